@@ -0,0 +1,214 @@
+/*--------------------------------------------------------------------*/
+/* benchhash.c                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Length of the long keys, terminating '\0' included. */
+enum {LONG_KEY_SIZE = 128};
+
+/* Number of times each key is looked up after the table is built. */
+enum {GET_ROUNDS = 4};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey under the byte-at-a-time multiplier
+   hash that the hash table implementation used originally. */
+
+static size_t hashMultiplier(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iCount distinct keys. If iLong, each key is
+   LONG_KEY_SIZE - 1 characters long and shares a long prefix with
+   the others, like a qualified identifier; otherwise each key is
+   the decimal form of its index. */
+
+static char **makeKeys(int iCount, int iLong)
+{
+   char **ppcKeys;
+   char acKey[LONG_KEY_SIZE];
+   size_t uLength;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)iCount);
+   assert(ppcKeys != NULL);
+   for (i = 0; i < iCount; i++)
+   {
+      if (iLong)
+      {
+         sprintf(acKey, "org.example.service.component.module.%d.", i);
+         uLength = strlen(acKey);
+         memset(acKey + uLength, 'x', LONG_KEY_SIZE - 1 - uLength);
+         acKey[LONG_KEY_SIZE - 1] = '\0';
+      }
+      else
+         sprintf(acKey, "%d", i);
+      ppcKeys[i] = (char*)malloc(strlen(acKey) + 1);
+      assert(ppcKeys[i] != NULL);
+      strcpy(ppcKeys[i], acKey);
+   }
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Shuffle the iCount keys of ppcKeys into a pseudo-random order, so
+   that consecutive lookups do not hit neighbouring buckets just
+   because the keys were generated in sequence. */
+
+static void shuffleKeys(char **ppcKeys, int iCount)
+{
+   char *pcTemp;
+   int i;
+   int j;
+
+   assert(ppcKeys != NULL);
+
+   srand(217);
+   for (i = iCount - 1; i > 0; i--)
+   {
+      j = (int)(((double)rand() / ((double)RAND_MAX + 1.0)) * (i + 1));
+      pcTemp = ppcKeys[i];
+      ppcKeys[i] = ppcKeys[j];
+      ppcKeys[j] = pcTemp;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the iCount keys of ppcKeys into oSymTable, freeze it if
+   iFreeze, look each of them up GET_ROUNDS times, and write the CPU
+   time of each phase to stdout labelled with pcLabel. The freeze
+   counts as part of the put phase. Free oSymTable. */
+
+static void benchTable(SymTable_T oSymTable, const char *pcLabel,
+   char **ppcKeys, int iCount, int iFreeze)
+{
+   clock_t iInitialClock;
+   clock_t iPutClock;
+   clock_t iFinalClock;
+   int iRound;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(pcLabel != NULL);
+   assert(ppcKeys != NULL);
+
+   iInitialClock = clock();
+   for (i = 0; i < iCount; i++)
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+   if (iFreeze && ! SymTable_freeze(oSymTable))
+      printf("Freeze failed.\n");
+   iPutClock = clock();
+   for (iRound = 0; iRound < GET_ROUNDS; iRound++)
+      for (i = 0; i < iCount; i++)
+         if (SymTable_get(oSymTable, ppcKeys[i]) != ppcKeys[i])
+            printf("Lookup of key %d failed.\n", i);
+   iFinalClock = clock();
+
+   printf("%-24s put %f seconds, get %f seconds\n", pcLabel,
+      ((double)(iPutClock - iInitialClock)) / CLOCKS_PER_SEC,
+      ((double)(iFinalClock - iPutClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the iCount keys of ppcKeys into a new table with one call of
+   SymTable_putMany on one thread, and write the CPU time it took to
+   stdout labelled with pcLabel. */
+
+static void benchBulk(const char *pcLabel, char **ppcKeys, int iCount)
+{
+   SymTable_T oSymTable;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   assert(pcLabel != NULL);
+   assert(ppcKeys != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) return;
+   iInitialClock = clock();
+   if (! SymTable_putMany(oSymTable, (const char *const *)ppcKeys,
+      (void *const *)ppcKeys, (size_t)iCount, 1, NULL))
+      printf("Bulk load failed.\n");
+   iFinalClock = clock();
+
+   printf("%-24s put %f seconds\n", pcLabel,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the built-in hash function of the SymTable implementation
+   with the original multiplier hash, a frozen table with both, and
+   one put at a time with a bulk load, on short and on long keys.
+   argv[1] is the number of bindings to put into each table. Exit
+   with EXIT_FAILURE if argv[1] is missing or not a positive number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   char **ppcKeys;
+   int iBindingCount;
+   int iLong;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount <= 0)
+   {
+      fprintf(stderr, "bindingcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (iLong = 0; iLong <= 1; iLong++)
+   {
+      printf("------------------------------------------------------\n");
+      printf("%d %s keys:\n", iBindingCount, iLong ? "long" : "short");
+      fflush(stdout);
+
+      ppcKeys = makeKeys(iBindingCount, iLong);
+      shuffleKeys(ppcKeys, iBindingCount);
+      benchTable(SymTable_new(), "built-in hash", ppcKeys,
+         iBindingCount, 0);
+      benchTable(SymTable_newWithHash(hashMultiplier),
+         "multiplier hash", ppcKeys, iBindingCount, 0);
+      benchTable(SymTable_new(), "frozen", ppcKeys, iBindingCount, 1);
+      benchBulk("bulk load", ppcKeys, iBindingCount);
+      for (i = 0; i < iBindingCount; i++)
+         free(ppcKeys[i]);
+      free(ppcKeys);
+   }
+   return 0;
+}
@@ -0,0 +1,667 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+/* Benchmark a SymTable implementation under a set of workloads.
+
+   Usage: benchsymtableX [-w workload] [-n keycount] [-o opcount]
+                         [-l keylength] [-d uniform|zipf] [-s skew]
+                         [-r readpercent] [-h hitpercent] [-S seed]
+
+   Each workload puts keycount keys into a new table (the "insert"
+   phase), then runs opcount operations against it. A read is a get
+   of a present key (hitpercent of reads) or of a key that was never
+   put. A write removes a present key and puts it back, so the table
+   keeps its size. Keys are picked uniformly or from a Zipfian
+   distribution, and are decimal numbers (keylength 0) or padded to
+   keylength characters.
+
+   Without -w every workload in asWorkloads runs; -l, -d, -s, -r and
+   -h override the corresponding setting of each workload that runs.
+
+   Every operation is timed on its own with the monotonic clock, so
+   the latencies include the overhead of one clock_gettime call. The
+   results go to stdout as CSV, one line per workload and operation
+   type, after a header line. */
+
+/* clock_gettime and CLOCK_MONOTONIC are POSIX, not ANSI C. */
+#define _POSIX_C_SOURCE 199309L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Operation types whose latencies are recorded. */
+enum {OP_INSERT, OP_GET_HIT, OP_GET_MISS, OP_REMOVE, OP_PUT, OP_FREE,
+   OP_COUNT};
+
+/* Names of the operation types in the output. */
+static const char *apcOpNames[OP_COUNT] = {"insert", "get_hit",
+   "get_miss", "remove", "put", "free"};
+
+/* Key distributions. */
+enum {DIST_UNIFORM, DIST_ZIPF};
+
+/* Names of the key distributions, in the output and for -d. */
+static const char *apcDistNames[] = {"uniform", "zipf"};
+
+/* Longest key that -l accepts, terminating '\0' excluded. */
+enum {MAX_KEY_LENGTH = 1024};
+
+/*--------------------------------------------------------------------*/
+
+/* A Workload is one benchmark configuration. */
+
+struct Workload
+{
+   /* Name of the workload in the output and for -w. */
+   const char *pcName;
+
+   /* Length keys are padded to, or 0 for bare decimal keys. */
+   size_t uKeyLength;
+
+   /* DIST_UNIFORM or DIST_ZIPF, and the Zipfian exponent. */
+   int iDist;
+   double dSkew;
+
+   /* Percentage of operations that are reads, and percentage of
+      reads that look up a present key. */
+   int iReadPercent;
+   int iHitPercent;
+};
+
+/* The workloads that run when -w is not given. */
+static struct Workload asWorkloads[] =
+{
+   {"read_uniform_short", 0, DIST_UNIFORM, 0.99, 95, 90},
+   {"read_zipf_short", 0, DIST_ZIPF, 0.99, 95, 90},
+   {"read_uniform_long", 100, DIST_UNIFORM, 0.99, 95, 90},
+   {"read_zipf_long", 100, DIST_ZIPF, 0.99, 95, 90},
+   {"miss_uniform_short", 0, DIST_UNIFORM, 0.99, 95, 10},
+   {"write_uniform_short", 0, DIST_UNIFORM, 0.99, 50, 90},
+   {"write_zipf_long", 100, DIST_ZIPF, 0.99, 50, 90}
+};
+
+/* Number of elements in asWorkloads. */
+enum {WORKLOAD_COUNT = sizeof(asWorkloads) / sizeof(asWorkloads[0])};
+
+/*--------------------------------------------------------------------*/
+
+/* A Samples object collects the latencies of one operation type. */
+
+struct Samples
+{
+   /* Latencies in nanoseconds, and how many there are. */
+   unsigned long *pulNs;
+   size_t uCount;
+
+   /* Sum of the latencies, in seconds. */
+   double dTotal;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* State of the xorshift random number generator. Never 0. */
+static unsigned long ulRandomState = 217;
+
+/* Return a pseudo-random number in [0, 1). */
+
+static double randomUnit(void)
+{
+   unsigned long ul = ulRandomState;
+
+   ul ^= (ul << 13) & 0xffffffffUL;
+   ul ^= ul >> 17;
+   ul ^= (ul << 5) & 0xffffffffUL;
+   ulRandomState = ul;
+   return (double)ul / 4294967296.0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pseudo-random index in [0, uCount). */
+
+static size_t randomIndex(size_t uCount)
+{
+   size_t u;
+
+   u = (size_t)(randomUnit() * (double)uCount);
+   return u < uCount ? u : uCount - 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of nanoseconds from *psStart to *psEnd. */
+
+static unsigned long elapsedNs(const struct timespec *psStart,
+   const struct timespec *psEnd)
+{
+   assert(psStart != NULL);
+   assert(psEnd != NULL);
+
+   return (unsigned long)(psEnd->tv_sec - psStart->tv_sec) *
+      1000000000UL + (unsigned long)psEnd->tv_nsec -
+      (unsigned long)psStart->tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that one operation took the time from *psStart to *psEnd in
+   psSamples. */
+
+static void record(struct Samples *psSamples,
+   const struct timespec *psStart, const struct timespec *psEnd)
+{
+   unsigned long ulNs;
+
+   assert(psSamples != NULL);
+
+   ulNs = elapsedNs(psStart, psEnd);
+   psSamples->pulNs[psSamples->uCount++] = ulNs;
+   psSamples->dTotal += (double)ulNs / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of uCount distinct keys that start with pcPrefix.
+   If uKeyLength is not 0, each key is padded with 'x' to uKeyLength
+   characters. Exit with EXIT_FAILURE if insufficient memory is
+   available. */
+
+static char **makeKeys(size_t uCount, const char *pcPrefix,
+   size_t uKeyLength)
+{
+   char **ppcKeys;
+   char acKey[MAX_KEY_LENGTH + 32];
+   size_t uLength;
+   size_t u;
+
+   assert(pcPrefix != NULL);
+
+   ppcKeys = (char**)malloc(sizeof(char*) * uCount);
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "Insufficient memory for keys\n");
+      exit(EXIT_FAILURE);
+   }
+   for (u = 0; u < uCount; u++)
+   {
+      sprintf(acKey, "%s%lu", pcPrefix, (unsigned long)u);
+      uLength = strlen(acKey);
+      if (uLength < uKeyLength)
+      {
+         memset(acKey + uLength, 'x', uKeyLength - uLength);
+         acKey[uKeyLength] = '\0';
+      }
+      ppcKeys[u] = (char*)malloc(strlen(acKey) + 1);
+      if (ppcKeys[u] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory for keys\n");
+         exit(EXIT_FAILURE);
+      }
+      strcpy(ppcKeys[u], acKey);
+   }
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the uCount keys of ppcKeys, and ppcKeys itself. */
+
+static void freeKeys(char **ppcKeys, size_t uCount)
+{
+   size_t u;
+
+   assert(ppcKeys != NULL);
+
+   for (u = 0; u < uCount; u++)
+      free(ppcKeys[u]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Shuffle the uCount keys of ppcKeys into a pseudo-random order, so
+   that the popular ranks of a Zipfian distribution are not
+   neighbouring keys. */
+
+static void shuffleKeys(char **ppcKeys, size_t uCount)
+{
+   char *pcTemp;
+   size_t u;
+   size_t uOther;
+
+   assert(ppcKeys != NULL);
+
+   for (u = uCount; u > 1; u--)
+   {
+      uOther = randomIndex(u);
+      pcTemp = ppcKeys[u - 1];
+      ppcKeys[u - 1] = ppcKeys[uOther];
+      ppcKeys[uOther] = pcTemp;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the cumulative distribution of a Zipfian distribution with
+   exponent dSkew over uCount ranks: element i is the probability of
+   picking a rank no greater than i. Exit with EXIT_FAILURE if
+   insufficient memory is available. */
+
+static double *makeZipf(size_t uCount, double dSkew)
+{
+   double *pdCumulative;
+   double dSum = 0.0;
+   size_t u;
+
+   pdCumulative = (double*)malloc(sizeof(double) * uCount);
+   if (pdCumulative == NULL)
+   {
+      fprintf(stderr, "Insufficient memory for distribution\n");
+      exit(EXIT_FAILURE);
+   }
+   for (u = 0; u < uCount; u++)
+   {
+      dSum += 1.0 / pow((double)(u + 1), dSkew);
+      pdCumulative[u] = dSum;
+   }
+   for (u = 0; u < uCount; u++)
+      pdCumulative[u] /= dSum;
+   return pdCumulative;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pseudo-random index in [0, uCount), picked uniformly if
+   pdCumulative is NULL and from the distribution pdCumulative
+   otherwise. */
+
+static size_t pickIndex(const double *pdCumulative, size_t uCount)
+{
+   double d;
+   size_t uLow;
+   size_t uHigh;
+   size_t uMid;
+
+   if (pdCumulative == NULL)
+      return randomIndex(uCount);
+
+   /* Find the first rank whose cumulative probability exceeds d. */
+   d = randomUnit();
+   uLow = 0;
+   uHigh = uCount - 1;
+   while (uLow < uHigh)
+   {
+      uMid = uLow + (uHigh - uLow) / 2;
+      if (pdCumulative[uMid] > d)
+         uHigh = uMid;
+      else
+         uLow = uMid + 1;
+   }
+   return uLow;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the latencies that pv1 and pv2 point to, for qsort. */
+
+static int compareNs(const void *pv1, const void *pv2)
+{
+   unsigned long ul1 = *(const unsigned long*)pv1;
+   unsigned long ul2 = *(const unsigned long*)pv2;
+
+   if (ul1 < ul2) return -1;
+   return ul1 > ul2;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the dPercentile-th percentile (nearest rank) of the uCount
+   sorted latencies in pulNs. */
+
+static unsigned long percentile(const unsigned long *pulNs,
+   size_t uCount, double dPercentile)
+{
+   size_t uRank;
+
+   assert(pulNs != NULL);
+   assert(uCount > 0);
+
+   uRank = (size_t)ceil(dPercentile / 100.0 * (double)uCount);
+   if (uRank == 0) uRank = 1;
+   return pulNs[uRank - 1];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write one CSV line to stdout for each operation type of asSamples
+   that ran in workload *psWorkload, labelled with pcBackend. */
+
+static void report(const char *pcBackend,
+   const struct Workload *psWorkload, size_t uKeyCount,
+   struct Samples asSamples[OP_COUNT])
+{
+   struct Samples *psSamples;
+   int iOp;
+
+   assert(pcBackend != NULL);
+   assert(psWorkload != NULL);
+
+   for (iOp = 0; iOp < OP_COUNT; iOp++)
+   {
+      psSamples = &asSamples[iOp];
+      if (psSamples->uCount == 0) continue;
+      qsort(psSamples->pulNs, psSamples->uCount, sizeof(unsigned long),
+         compareNs);
+      printf("%s,%s,%lu,%lu,%s,%.2f,%d,%d,%s,%lu,%.0f,"
+         "%lu,%lu,%lu,%lu,%lu\n",
+         pcBackend, psWorkload->pcName, (unsigned long)uKeyCount,
+         (unsigned long)psWorkload->uKeyLength,
+         apcDistNames[psWorkload->iDist], psWorkload->dSkew,
+         psWorkload->iReadPercent, psWorkload->iHitPercent,
+         apcOpNames[iOp], (unsigned long)psSamples->uCount,
+         psSamples->dTotal > 0.0 ?
+            (double)psSamples->uCount / psSamples->dTotal : 0.0,
+         percentile(psSamples->pulNs, psSamples->uCount, 50.0),
+         percentile(psSamples->pulNs, psSamples->uCount, 90.0),
+         percentile(psSamples->pulNs, psSamples->uCount, 99.0),
+         percentile(psSamples->pulNs, psSamples->uCount, 99.9),
+         psSamples->pulNs[psSamples->uCount - 1]);
+   }
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run workload *psWorkload with uKeyCount keys and uOpCount
+   operations against a new SymTable, and report the results labelled
+   with pcBackend. Return the number of operations that returned an
+   unexpected result. Exit with EXIT_FAILURE if insufficient memory
+   is available. */
+
+static size_t runWorkload(const char *pcBackend,
+   const struct Workload *psWorkload, size_t uKeyCount,
+   size_t uOpCount)
+{
+   struct Samples asSamples[OP_COUNT];
+   struct timespec sStart;
+   struct timespec sEnd;
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char **ppcMissKeys;
+   double *pdCumulative = NULL;
+   const char *pcKey;
+   void *pvValue;
+   size_t uErrors = 0;
+   size_t uIndex;
+   size_t u;
+   int iOp;
+   int iSuccessful;
+
+   assert(pcBackend != NULL);
+   assert(psWorkload != NULL);
+   assert(uKeyCount > 0);
+
+   ppcKeys = makeKeys(uKeyCount, "", psWorkload->uKeyLength);
+   ppcMissKeys = makeKeys(uKeyCount, "miss", psWorkload->uKeyLength);
+   shuffleKeys(ppcKeys, uKeyCount);
+   shuffleKeys(ppcMissKeys, uKeyCount);
+   if (psWorkload->iDist == DIST_ZIPF)
+      pdCumulative = makeZipf(uKeyCount, psWorkload->dSkew);
+
+   for (iOp = 0; iOp < OP_COUNT; iOp++)
+   {
+      asSamples[iOp].uCount = 0;
+      asSamples[iOp].dTotal = 0.0;
+      asSamples[iOp].pulNs = (unsigned long*)malloc(
+         sizeof(unsigned long) * (uKeyCount > uOpCount ?
+            uKeyCount : uOpCount));
+      if (asSamples[iOp].pulNs == NULL)
+      {
+         fprintf(stderr, "Insufficient memory for samples\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory for SymTable\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Insert every key, with the key itself as its value. */
+   for (u = 0; u < uKeyCount; u++)
+   {
+      clock_gettime(CLOCK_MONOTONIC, &sStart);
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[u], ppcKeys[u]);
+      clock_gettime(CLOCK_MONOTONIC, &sEnd);
+      record(&asSamples[OP_INSERT], &sStart, &sEnd);
+      if (! iSuccessful) uErrors++;
+   }
+
+   /* Run the mix of reads and writes. The random choices are made
+      outside the timed region. */
+   for (u = 0; u < uOpCount; u++)
+   {
+      uIndex = pickIndex(pdCumulative, uKeyCount);
+      if (randomUnit() * 100.0 < (double)psWorkload->iReadPercent)
+      {
+         if (randomUnit() * 100.0 < (double)psWorkload->iHitPercent)
+         {
+            pcKey = ppcKeys[uIndex];
+            clock_gettime(CLOCK_MONOTONIC, &sStart);
+            pvValue = SymTable_get(oSymTable, pcKey);
+            clock_gettime(CLOCK_MONOTONIC, &sEnd);
+            record(&asSamples[OP_GET_HIT], &sStart, &sEnd);
+            if (pvValue != pcKey) uErrors++;
+         }
+         else
+         {
+            pcKey = ppcMissKeys[uIndex];
+            clock_gettime(CLOCK_MONOTONIC, &sStart);
+            pvValue = SymTable_get(oSymTable, pcKey);
+            clock_gettime(CLOCK_MONOTONIC, &sEnd);
+            record(&asSamples[OP_GET_MISS], &sStart, &sEnd);
+            if (pvValue != NULL) uErrors++;
+         }
+      }
+      else
+      {
+         pcKey = ppcKeys[uIndex];
+         clock_gettime(CLOCK_MONOTONIC, &sStart);
+         pvValue = SymTable_remove(oSymTable, pcKey);
+         clock_gettime(CLOCK_MONOTONIC, &sEnd);
+         record(&asSamples[OP_REMOVE], &sStart, &sEnd);
+         if (pvValue != pcKey) uErrors++;
+
+         clock_gettime(CLOCK_MONOTONIC, &sStart);
+         iSuccessful = SymTable_put(oSymTable, pcKey, pcKey);
+         clock_gettime(CLOCK_MONOTONIC, &sEnd);
+         record(&asSamples[OP_PUT], &sStart, &sEnd);
+         if (! iSuccessful) uErrors++;
+      }
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &sStart);
+   SymTable_free(oSymTable);
+   clock_gettime(CLOCK_MONOTONIC, &sEnd);
+   record(&asSamples[OP_FREE], &sStart, &sEnd);
+
+   report(pcBackend, psWorkload, uKeyCount, asSamples);
+
+   for (iOp = 0; iOp < OP_COUNT; iOp++)
+      free(asSamples[iOp].pulNs);
+   free(pdCumulative);
+   freeKeys(ppcKeys, uKeyCount);
+   freeKeys(ppcMissKeys, uKeyCount);
+   return uErrors;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a usage message for program pcProgram to stderr and exit with
+   EXIT_FAILURE. */
+
+static void usage(const char *pcProgram)
+{
+   int i;
+
+   assert(pcProgram != NULL);
+
+   fprintf(stderr, "Usage: %s [-w workload] [-n keycount] "
+      "[-o opcount] [-l keylength]\n"
+      "       [-d uniform|zipf] [-s skew] [-r readpercent] "
+      "[-h hitpercent] [-S seed]\n"
+      "Workloads:", pcProgram);
+   for (i = 0; i < WORKLOAD_COUNT; i++)
+      fprintf(stderr, " %s", asWorkloads[i].pcName);
+   fprintf(stderr, "\n");
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the SymTable implementation that pcProgram, the
+   path of this program, was linked with: whatever follows
+   "benchsymtable" in its file name, or the whole file name. */
+
+static const char *backendName(const char *pcProgram)
+{
+   const char *pcName;
+
+   assert(pcProgram != NULL);
+
+   pcName = strrchr(pcProgram, '/');
+   pcName = pcName == NULL ? pcProgram : pcName + 1;
+   if (strncmp(pcName, "benchsymtable", 13) == 0 && pcName[13] != '\0')
+      pcName += 13;
+   return pcName;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the options in argv (see the comment at the top of this
+   file), run the selected workloads, and write the results to stdout
+   as CSV. Exit with EXIT_FAILURE if the options are invalid. Return
+   0 if every operation returned the expected result, or 1
+   otherwise. */
+
+int main(int argc, char *argv[])
+{
+   const char *pcWorkload = NULL;
+   unsigned long ulKeyCount = 10000;
+   unsigned long ulOpCount = 200000;
+   unsigned long ulKeyLength = 0;
+   unsigned long ulSeed;
+   double dSkew = 0.0;
+   int iKeyLength = 0;
+   int iDist = -1;
+   int iReadPercent = -1;
+   int iHitPercent = -1;
+   size_t uErrors = 0;
+   struct Workload sWorkload;
+   int i;
+
+   /* Parse the options, which all take a value. */
+   for (i = 1; i < argc; i += 2)
+   {
+      if (argv[i][0] != '-' || argv[i][1] == '\0' ||
+         argv[i][2] != '\0' || i + 1 >= argc)
+         usage(argv[0]);
+      switch (argv[i][1])
+      {
+         case 'w':
+            pcWorkload = argv[i + 1];
+            break;
+         case 'n':
+            if (sscanf(argv[i + 1], "%lu", &ulKeyCount) != 1 ||
+               ulKeyCount == 0)
+               usage(argv[0]);
+            break;
+         case 'o':
+            if (sscanf(argv[i + 1], "%lu", &ulOpCount) != 1)
+               usage(argv[0]);
+            break;
+         case 'l':
+            if (sscanf(argv[i + 1], "%lu", &ulKeyLength) != 1 ||
+               ulKeyLength > MAX_KEY_LENGTH)
+               usage(argv[0]);
+            iKeyLength = 1;
+            break;
+         case 'd':
+            if (strcmp(argv[i + 1], "uniform") == 0)
+               iDist = DIST_UNIFORM;
+            else if (strcmp(argv[i + 1], "zipf") == 0)
+               iDist = DIST_ZIPF;
+            else
+               usage(argv[0]);
+            break;
+         case 's':
+            if (sscanf(argv[i + 1], "%lf", &dSkew) != 1 || dSkew <= 0.0)
+               usage(argv[0]);
+            break;
+         case 'r':
+            if (sscanf(argv[i + 1], "%d", &iReadPercent) != 1 ||
+               iReadPercent < 0 || iReadPercent > 100)
+               usage(argv[0]);
+            break;
+         case 'h':
+            if (sscanf(argv[i + 1], "%d", &iHitPercent) != 1 ||
+               iHitPercent < 0 || iHitPercent > 100)
+               usage(argv[0]);
+            break;
+         case 'S':
+            if (sscanf(argv[i + 1], "%lu", &ulSeed) != 1)
+               usage(argv[0]);
+            ulRandomState = (ulSeed & 0xffffffffUL) | 1;
+            break;
+         default:
+            usage(argv[0]);
+      }
+   }
+
+   /* Check the workload name before writing anything. */
+   if (pcWorkload != NULL)
+   {
+      for (i = 0; i < WORKLOAD_COUNT; i++)
+         if (strcmp(pcWorkload, asWorkloads[i].pcName) == 0) break;
+      if (i == WORKLOAD_COUNT)
+         usage(argv[0]);
+   }
+
+   printf("backend,workload,keys,key_length,distribution,skew,"
+      "read_percent,hit_percent,op,count,ops_per_sec,"
+      "p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+
+   for (i = 0; i < WORKLOAD_COUNT; i++)
+   {
+      if (pcWorkload != NULL &&
+         strcmp(pcWorkload, asWorkloads[i].pcName) != 0)
+         continue;
+      sWorkload = asWorkloads[i];
+      if (iKeyLength) sWorkload.uKeyLength = (size_t)ulKeyLength;
+      if (iDist != -1) sWorkload.iDist = iDist;
+      if (dSkew > 0.0) sWorkload.dSkew = dSkew;
+      if (iReadPercent != -1) sWorkload.iReadPercent = iReadPercent;
+      if (iHitPercent != -1) sWorkload.iHitPercent = iHitPercent;
+      uErrors += runWorkload(backendName(argv[0]), &sWorkload,
+         (size_t)ulKeyCount, (size_t)ulOpCount);
+   }
+
+   if (uErrors != 0)
+   {
+      fprintf(stderr, "%lu operations returned unexpected results\n",
+         (unsigned long)uErrors);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,332 @@
+/*--------------------------------------------------------------------*/
+/* benchthreads.c                                                     */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+/* Measure how a thread-safe SymTable implementation scales with the
+   number of threads that share one table.
+
+   Usage: benchthreads [-t maxthreads] [-n keycount] [-o opcount]
+                       [-r readpercent] [-g]
+
+   keycount keys are put into a new table, then 1, 2, ... maxthreads
+   threads run opcount operations each against it. A read gets a
+   random key. A write removes a random key and puts it back; each
+   thread writes only the keys whose index is its own number modulo
+   the thread count, so every remove and put must succeed, and a get
+   must return either the key's value or NULL.
+
+   With -g every call is made while holding one global mutex, the way
+   a table that is not thread-safe has to be shared; comparing the
+   two runs shows what the implementation's own locking buys.
+
+   The results go to stdout as CSV, one line per thread count, after
+   a header line. */
+
+/* clock_gettime and the pthread functions are POSIX, not ANSI C. */
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Largest number of threads that -t accepts. */
+enum {MAX_THREADS = 256};
+
+/*--------------------------------------------------------------------*/
+
+/* A Worker holds the parameters and results of one thread. */
+
+struct Worker
+{
+   /* The shared table and its keys. */
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   size_t uKeyCount;
+
+   /* This thread's number, and the number of threads. */
+   size_t uThread;
+   size_t uThreadCount;
+
+   /* Number of operations to run, and percentage that are reads. */
+   size_t uOpCount;
+   int iReadPercent;
+
+   /* State of this thread's xorshift random number generator. */
+   unsigned long ulRandomState;
+
+   /* Number of operations that returned an unexpected result. */
+   size_t uErrors;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The mutex that -g wraps around every call, and whether to use it. */
+static pthread_mutex_t sGlobalLock = PTHREAD_MUTEX_INITIALIZER;
+static int iGlobal = 0;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pseudo-random number in [0, 1) from psWorker's
+   generator. */
+
+static double randomUnit(struct Worker *psWorker)
+{
+   unsigned long ul;
+
+   assert(psWorker != NULL);
+
+   ul = psWorker->ulRandomState;
+   ul ^= (ul << 13) & 0xffffffffUL;
+   ul ^= ul >> 17;
+   ul ^= (ul << 5) & 0xffffffffUL;
+   psWorker->ulRandomState = ul;
+   return (double)ul / 4294967296.0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take the global mutex if -g was given. */
+
+static void lock(void)
+{
+   if (iGlobal) pthread_mutex_lock(&sGlobalLock);
+}
+
+/* Release the global mutex if -g was given. */
+
+static void unlock(void)
+{
+   if (iGlobal) pthread_mutex_unlock(&sGlobalLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the operations of the Worker that pvWorker points to. Return
+   NULL. */
+
+static void *runWorker(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   const char *pcKey;
+   void *pvValue;
+   size_t uIndex;
+   size_t u;
+   int iSuccessful;
+
+   assert(psWorker != NULL);
+
+   for (u = 0; u < psWorker->uOpCount; u++)
+   {
+      uIndex = (size_t)(randomUnit(psWorker) *
+         (double)psWorker->uKeyCount);
+      if (randomUnit(psWorker) * 100.0 <
+         (double)psWorker->iReadPercent)
+      {
+         pcKey = psWorker->ppcKeys[uIndex];
+         lock();
+         pvValue = SymTable_get(psWorker->oSymTable, pcKey);
+         unlock();
+         if (pvValue != NULL && pvValue != pcKey) psWorker->uErrors++;
+         continue;
+      }
+
+      /* Move to the nearest key that this thread owns. */
+      uIndex -= uIndex % psWorker->uThreadCount;
+      uIndex += psWorker->uThread;
+      if (uIndex >= psWorker->uKeyCount) uIndex = psWorker->uThread;
+      if (uIndex >= psWorker->uKeyCount) continue;
+      pcKey = psWorker->ppcKeys[uIndex];
+
+      lock();
+      pvValue = SymTable_remove(psWorker->oSymTable, pcKey);
+      unlock();
+      if (pvValue != pcKey) psWorker->uErrors++;
+      lock();
+      iSuccessful = SymTable_put(psWorker->oSymTable, pcKey, pcKey);
+      unlock();
+      if (! iSuccessful) psWorker->uErrors++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds from *psStart to *psEnd. */
+
+static double elapsed(const struct timespec *psStart,
+   const struct timespec *psEnd)
+{
+   assert(psStart != NULL);
+   assert(psEnd != NULL);
+
+   return (double)(psEnd->tv_sec - psStart->tv_sec) +
+      (double)(psEnd->tv_nsec - psStart->tv_nsec) / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a usage message for program pcProgram to stderr and exit with
+   EXIT_FAILURE. */
+
+static void usage(const char *pcProgram)
+{
+   assert(pcProgram != NULL);
+
+   fprintf(stderr, "Usage: %s [-t maxthreads] [-n keycount] "
+      "[-o opcount] [-r readpercent] [-g]\n", pcProgram);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the options in argv (see the comment at the top of this
+   file), run the benchmark for each thread count, and write the
+   results to stdout as CSV. Exit with EXIT_FAILURE if the options are
+   invalid or memory runs out. Return 0 if every operation returned
+   the expected result, or 1 otherwise. */
+
+int main(int argc, char *argv[])
+{
+   static struct Worker asWorkers[MAX_THREADS];
+   pthread_t aiThreads[MAX_THREADS];
+   struct timespec sStart;
+   struct timespec sEnd;
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char acKey[32];
+   unsigned long ulMaxThreads = 8;
+   unsigned long ulKeyCount = 100000;
+   unsigned long ulOpCount = 1000000;
+   int iReadPercent = 90;
+   double dSeconds;
+   double dBaseRate = 0.0;
+   double dRate;
+   size_t uErrors = 0;
+   size_t uThreads;
+   size_t u;
+   int i;
+
+   /* Parse the options. */
+   for (i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-g") == 0)
+      {
+         iGlobal = 1;
+         continue;
+      }
+      if (i + 1 >= argc) usage(argv[0]);
+      if (strcmp(argv[i], "-t") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulMaxThreads) != 1 ||
+            ulMaxThreads == 0 || ulMaxThreads > MAX_THREADS)
+            usage(argv[0]);
+      }
+      else if (strcmp(argv[i], "-n") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulKeyCount) != 1 ||
+            ulKeyCount == 0)
+            usage(argv[0]);
+      }
+      else if (strcmp(argv[i], "-o") == 0)
+      {
+         if (sscanf(argv[++i], "%lu", &ulOpCount) != 1)
+            usage(argv[0]);
+      }
+      else if (strcmp(argv[i], "-r") == 0)
+      {
+         if (sscanf(argv[++i], "%d", &iReadPercent) != 1 ||
+            iReadPercent < 0 || iReadPercent > 100)
+            usage(argv[0]);
+      }
+      else
+         usage(argv[0]);
+   }
+
+   /* Make the keys and put them all into a new table. */
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)ulKeyCount);
+   oSymTable = SymTable_new();
+   if (ppcKeys == NULL || oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (u = 0; u < (size_t)ulKeyCount; u++)
+   {
+      sprintf(acKey, "key%lu", (unsigned long)u);
+      ppcKeys[u] = (char*)malloc(strlen(acKey) + 1);
+      if (ppcKeys[u] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      strcpy(ppcKeys[u], acKey);
+      if (! SymTable_put(oSymTable, ppcKeys[u], ppcKeys[u]))
+         uErrors++;
+   }
+
+   printf("locking,threads,keys,read_percent,ops,seconds,ops_per_sec,"
+      "speedup\n");
+
+   for (uThreads = 1; uThreads <= (size_t)ulMaxThreads; uThreads++)
+   {
+      for (u = 0; u < uThreads; u++)
+      {
+         asWorkers[u].oSymTable = oSymTable;
+         asWorkers[u].ppcKeys = ppcKeys;
+         asWorkers[u].uKeyCount = (size_t)ulKeyCount;
+         asWorkers[u].uThread = u;
+         asWorkers[u].uThreadCount = uThreads;
+         asWorkers[u].uOpCount = (size_t)ulOpCount;
+         asWorkers[u].iReadPercent = iReadPercent;
+         asWorkers[u].ulRandomState = (unsigned long)(217 + 2 * u + 1);
+         asWorkers[u].uErrors = 0;
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &sStart);
+      for (u = 0; u < uThreads; u++)
+         if (pthread_create(&aiThreads[u], NULL, runWorker,
+            &asWorkers[u]) != 0)
+         {
+            fprintf(stderr, "Cannot create thread\n");
+            exit(EXIT_FAILURE);
+         }
+      for (u = 0; u < uThreads; u++)
+      {
+         pthread_join(aiThreads[u], NULL);
+         uErrors += asWorkers[u].uErrors;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &sEnd);
+
+      dSeconds = elapsed(&sStart, &sEnd);
+      dRate = (double)(uThreads * (size_t)ulOpCount) / dSeconds;
+      if (uThreads == 1) dBaseRate = dRate;
+      printf("%s,%lu,%lu,%d,%lu,%f,%.0f,%.2f\n",
+         iGlobal ? "global" : "table", (unsigned long)uThreads,
+         ulKeyCount, iReadPercent,
+         (unsigned long)(uThreads * (size_t)ulOpCount), dSeconds, dRate,
+         dRate / dBaseRate);
+      fflush(stdout);
+   }
+
+   if (SymTable_getLength(oSymTable) != (size_t)ulKeyCount)
+      uErrors++;
+   SymTable_free(oSymTable);
+   for (u = 0; u < (size_t)ulKeyCount; u++)
+      free(ppcKeys[u]);
+   free(ppcKeys);
+
+   if (uErrors != 0)
+   {
+      fprintf(stderr, "%lu operations returned unexpected results\n",
+         (unsigned long)uErrors);
+      return 1;
+   }
+   return 0;
+}
@@ -28,6 +28,58 @@ typedef struct SymTable *SymTable_T;
 
 SymTable_T SymTable_new(void);
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_newWithHash: Returns a new SymTable object that contains *
+ *                       no bindings and that uses function *pfHash  *
+ *                       to compute the hash codes of its keys, or   *
+ *                       NULL if insufficient memory is available.   *
+ *                       *pfHash must return equal codes for equal   *
+ *                       keys. SymTable_new uses a built-in hash     *
+ *                       function instead.                           *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey));
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_newWithCapacity: Returns a new SymTable object that      *
+ *                           contains no bindings and is already     *
+ *                           sized to hold uCapacity bindings        *
+ *                           without resizing, or NULL if            *
+ *                           insufficient memory is available. To    *
+ *                           pre-size a table with a client hash     *
+ *                           function, call SymTable_reserve after   *
+ *                           SymTable_newWithHash.                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_newBorrowedKeys: Returns a new SymTable object that      *
+ *                           contains no bindings and that stores    *
+ *                           the key pointers that clients pass to   *
+ *                           SymTable_put, SymTable_getOrPut and     *
+ *                           SymTable_upsert instead of copies of    *
+ *                           the keys, or NULL if insufficient       *
+ *                           memory is available. Each key must stay *
+ *                           unchanged, and its memory valid, until  *
+ *                           its binding is removed or the table is  *
+ *                           freed or cleared. The table never frees *
+ *                           a key. SymTable_new copies every key.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+SymTable_T SymTable_newBorrowedKeys(void);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_reserve: Sizes SymTable_T oSymTable, in one step, so     *
+ *                   that it can hold uCapacity bindings in all      *
+ *                   without resizing again, and returns 1. Never    *
+ *                   makes a table smaller. If insufficient memory   *
+ *                   is available, leaves the bindings of oSymTable  *
+ *                   unchanged and returns 0.                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * SymTable_free: Frees all memory occupied by SymTable_T argument   *
  *                oSymTable.                                         *
@@ -92,6 +144,50 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_clear: Removes every binding from SymTable_T oSymTable.  *
+ *                 A table with a bucket or slot array keeps it, so  *
+ *                 that filling the table again up to its old size   *
+ *                 does not resize it. A table that carves its nodes *
+ *                 from pooled chunks keeps the nodes too, so that   *
+ *                 refilling allocates little or nothing. Other      *
+ *                 tables free the memory of each binding, as        *
+ *                 SymTable_remove does.                             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_clear(SymTable_T oSymTable);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_getOrPut: If SymTable_T oSymTable contains a binding     *
+ *                    with key pcKey, returns the address of that    *
+ *                    binding's value. Otherwise adds a new binding  *
+ *                    consisting of key pcKey and value pvValue and  *
+ *                    returns the address of its value. Either way   *
+ *                    oSymTable is searched only once. If piAdded is *
+ *                    not NULL, stores 1 in *piAdded if a binding    *
+ *                    was added and 0 otherwise. If insufficient     *
+ *                    memory is available, leaves oSymTable          *
+ *                    unchanged and returns NULL. The address stays  *
+ *                    valid until the next call that adds or removes *
+ *                    a binding.                                     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue, int *piAdded);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_upsert: Binds key pcKey to value pvValue in SymTable_T   *
+ *                  oSymTable, searching oSymTable only once. If a   *
+ *                  binding with key pcKey existed, replaces its     *
+ *                  value and returns the old value. Otherwise adds  *
+ *                  a new binding and returns NULL. If insufficient  *
+ *                  memory is available, leaves oSymTable unchanged  *
+ *                  and returns NULL.                                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue);
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * SymTable_map: Applies function *pfApply to each binding in        *
  *               Symtable_T object oSymTable, passing pvExtra as     *
@@ -102,4 +198,104 @@ void SymTable_map(SymTable_T oSymTable,
    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
    const void *pvExtra);
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_Iter: A cursor over the bindings of a SymTable_T object, *
+ *                declared by the client (usually on the stack) and  *
+ *                filled in by SymTable_iterBegin. Its fields belong *
+ *                to the implementation.                             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct SymTable_Iter
+{
+   /* The table being traversed, the next node or slot to look at,
+      and the implementation's position counters. */
+   SymTable_T oSymTable;
+   void *pvNext;
+   size_t auPos[2];
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_iterBegin: Sets *psIter to the start of a traversal of   *
+ *                     every binding in SymTable_T oSymTable, in no  *
+ *                     particular order. Until the traversal ends,   *
+ *                     oSymTable must not gain or lose bindings,     *
+ *                     though values may be replaced and keys looked *
+ *                     up.                                           *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+   struct SymTable_Iter *psIter);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_iterNext: If the traversal *psIter has bindings left,    *
+ *                    advances it past the next one, stores that     *
+ *                    binding's key in *ppcKey and value in          *
+ *                    *ppvValue (either may be NULL to skip it), and *
+ *                    returns 1. Otherwise returns 0. A traversal    *
+ *                    may be abandoned, or resumed later, at any     *
+ *                    point.                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+   const char **ppcKey, void **ppvValue);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SYMTABLE_PROBE_MAX: Number of elements in the probe histogram of  *
+ *                     struct SymTable_Stats.                        *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+enum {SYMTABLE_PROBE_MAX = 8};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_Stats: A snapshot of how a SymTable_T object is laid     *
+ *                 out, filled in by SymTable_getStats. A "bucket"   *
+ *                 is a chain head of a chained table, a slot of an  *
+ *                 open addressing table, or the single list of a    *
+ *                 list; a "chain" is the bindings that one lookup   *
+ *                 may compare its key against. All sizes are in     *
+ *                 bytes.                                            *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct SymTable_Stats
+{
+   /* Number of bindings, buckets, and buckets holding a binding. */
+   size_t uBindings;
+   size_t uBuckets;
+   size_t uUsedBuckets;
+
+   /* uBindings divided by uBuckets, or 0 if there are no buckets. */
+   double dLoadFactor;
+
+   /* Length of the longest chain, and mean length of the chains that
+      are not empty. */
+   size_t uMaxChain;
+   double dMeanChain;
+
+   /* Element i is the number of bindings that a successful lookup
+      finds with its (i+1)th key comparison; the last element also
+      counts every binding that takes more comparisons. */
+   size_t auProbes[SYMTABLE_PROBE_MAX];
+
+   /* Number of times the bucket array has been reallocated. */
+   size_t uResizes;
+
+   /* Memory held by the table: its own structure, its bucket arrays,
+      its nodes (unused pooled nodes included) and its key copies. */
+   size_t uStructBytes;
+   size_t uTableBytes;
+   size_t uNodeBytes;
+   size_t uKeyBytes;
+   size_t uTotalBytes;
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_getStats: Fills in *psStats with statistics about        *
+ *                    SymTable_T oSymTable. Takes time proportional  *
+ *                    to the size of oSymTable, and does not change  *
+ *                    it.                                            *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_getStats(SymTable_T oSymTable,
+   struct SymTable_Stats *psStats);
+
 #endif
\ No newline at end of file
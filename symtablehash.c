@@ -1,421 +1,3279 @@
 /*-------------------------------------------------------------------*/
-/* symtablehash.h                                                    */
+/* symtablehash.c                                                    */
 /* Author: Isaac Wolfe                                               */
 /* netid: iwolfe                                                     */
 /*-------------------------------------------------------------------*/
 
+/* The pthread functions, posix_memalign and mmap are POSIX, not ANSI
+   C. */
+#define _POSIX_C_SOURCE 200112L
+
 #include <string.h>
-#include "symtable.h"
+#include "symtablehash.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*-------------------------------------------------------------------*/
 
-/* Size_t value to hold max number of buckets */
-static size_t uSequenceMax = 65521;
+/* Multiplier and shift of the built-in hash function, sized to the
+   width of size_t. */
+#if ULONG_MAX > 0xffffffffUL
+#define HASH_MIX ((size_t)0xc6a4a7935bd1e995UL)
+#define HASH_SHIFT 47
+#else
+#define HASH_MIX ((size_t)0x5bd1e995UL)
+#define HASH_SHIFT 24
+#endif
+
+/*-------------------------------------------------------------------*/
 
-/* Size_t array to hold incremented sizes for resized tables/arrays */
-static size_t uSequence[8] = {509, 1021, 2039, 4093, 8191,
-	16381, 32749, 65521};
+/* Fibonacci multiplier (2^w divided by the golden ratio) that
+   SymTable_reduce uses to spread hash codes over the buckets. */
+#if ULONG_MAX > 0xffffffffUL
+#define HASH_FIBONACCI ((size_t)0x9e3779b97f4a7c15UL)
+#else
+#define HASH_FIBONACCI ((size_t)0x9e3779b9UL)
+#endif
+
+/* Number of bits in a size_t hash code. */
+#define HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+/* Base 2 logarithm of the number of buckets in a table's first bucket
+   array. Each resize doubles the number of buckets, and there is no
+   maximum. */
+enum {INITIAL_LENGTH_LOG = 9};
+
+/* Number of old buckets moved into the new array by each put, get,
+   contains, replace or remove while a resize is in progress. A
+   remove moves SHRINK_STEP instead while the array is halved. */
+enum {MIGRATE_STEP = 8};
+
+/* A remove starts halving the bucket array once fewer than
+   1/SHRINK_LOAD_DEN as many bindings as buckets remain. A put doubles
+   it at one binding per bucket, so a halved table is at most a
+   quarter full and needs three times as many bindings again before
+   it grows back; a table cannot thrash across a size boundary. */
+enum {SHRINK_LOAD_DEN = 8};
+
+/* Number of old buckets moved by each remove while the array is
+   being halved. A halving starts with fewer than 1/SHRINK_LOAD_DEN
+   as many bindings as old buckets, and the next one once half of
+   those are gone, so moving SHRINK_STEP buckets per remove finishes
+   each halving before the next is due. */
+enum {SHRINK_STEP = 2 * SHRINK_LOAD_DEN};
+
+/* Smallest and largest number of nodes carved from one chunk. Each
+   new node chunk is twice the size of the last, up to the maximum. */
+enum {NODE_CHUNK_MIN = 16, NODE_CHUNK_MAX = 4096};
+
+/* Smallest and largest number of bytes in one key chunk. */
+enum {KEY_CHUNK_MIN = 256, KEY_CHUNK_MAX = 65536};
+
+/* Number of bindings a new table keeps inline in its SymTable
+   structure before it allocates a bucket array. */
+enum {INLINE_MAX = 8};
+
+/* A key of up to KEY_INLINE bytes, terminating '\0' included, is
+   copied into its node, so that comparing it reads no other memory
+   and needs no key copy of its own. Most keys are this short. */
+enum {KEY_INLINE = 16};
+
+/* Longer key copies are rounded up to a multiple of KEY_GRANULE
+   bytes, and each multiple up to KEY_CLASS_COUNT granules has its own
+   free list. Longer keys still get their own malloc. */
+enum {KEY_GRANULE = 16, KEY_CLASS_COUNT = 16};
+
+/* Number of buckets in each chunk of work that SymTable_mapParallel
+   hands to a thread. */
+enum {PARALLEL_CHUNK = 256};
+
+/* Size of a cache line. Workers are padded to a multiple of it so
+   that threads updating neighbouring ones do not share a line. */
+enum {CACHE_LINE = 64};
+
+/* First word of an image written by SymTable_save ("SYM1"). */
+enum {IMAGE_MAGIC = 0x53594d31};
+
+/* Every value in an image starts at a multiple of IMAGE_ALIGN bytes
+   from its start, which mmap places at a page boundary, so a client
+   can read any basic type where its value begins. */
+enum {IMAGE_ALIGN = 16};
+
+/* Size of the first block that SymTable_save builds keys and values
+   in. */
+enum {IMAGE_HEAP_MIN = 4096};
+
+/* SymTable_freeze gives each displacement bucket at most FREEZE_LOAD
+   keys on average. Fewer buckets would save memory but make the last
+   of them slow to place. */
+enum {FREEZE_LOAD = 2};
+
+/* SymTable_freeze gives up on a seed once a bucket needs more than
+   FREEZE_TRIES displacements per binding, and on the table once
+   FREEZE_SEEDS seeds have failed. */
+enum {FREEZE_TRIES = 64, FREEZE_SEEDS = 8};
 
 /*-------------------------------------------------------------------*/
 
-/* Special function to create size_t hash codes for hash table using 
-   pcKey and and a count of the number of buckets in the current 
-   hash table */
-	static size_t SymTable_hash(const char *pcKey, size_t uPhysLength);
+/* Special function to create full-width size_t hash codes for the
+   hash table using pcKey and uSeed */
+	static size_t SymTable_hash(const char *pcKey, size_t uSeed);
+
+/* Special function to hash pcKey with the hash function of
+   oSymTable */
+	static size_t SymTable_hashKey(SymTable_T oSymTable,
+		const char *pcKey);
 
-/* Special function to resize the current table to the next size in 
-   the sequence */
+/* Special function to reduce hash code uHash to the index of a bucket
+   in an array of 2^(HASH_BITS - uShift) buckets */
+	static size_t SymTable_reduce(size_t uHash, size_t uShift);
+
+/* Special function to start resizing the current table to twice its
+   number of buckets */
 	static void SymTable_resize(SymTable_T oSymTable);
 
+/* Special function to start resizing the current table to half its
+   number of buckets */
+	static void SymTable_shrink(SymTable_T oSymTable);
+
+/* Special function to move up to uBuckets buckets from the array
+   being resized away from into the current array */
+	static void SymTable_migrate(SymTable_T oSymTable, size_t uBuckets);
+
+/* Special function to find the bucket that holds, or would hold, a
+   key whose hash code is uHash */
+	static struct Node **SymTable_bucket(SymTable_T oSymTable,
+		size_t uHash);
+
+/* Special function to find the link that points to the node holding
+   pcKey, or the NULL link at the end of its bucket */
+	static struct Node **SymTable_findLink(SymTable_T oSymTable,
+		const char *pcKey, size_t uHash);
+
+/* Special functions to take nodes and key copies from the table's
+   arena and give them back */
+	static struct Node *SymTable_allocNode(SymTable_T oSymTable);
+	static void SymTable_freeNode(SymTable_T oSymTable,
+		struct Node *psNode);
+	static char *SymTable_allocKey(SymTable_T oSymTable, size_t uSize);
+	static void SymTable_freeKey(SymTable_T oSymTable, const char *pcKey);
+
+/* Special functions to give a node a copy of a key, inline if it is
+   short enough, to give back a copy that is not inline, and to copy
+   a node whose key may be inline */
+	static int SymTable_setKey(SymTable_T oSymTable, struct Node *psNode,
+		const char *pcKey);
+	static void SymTable_dropKey(SymTable_T oSymTable,
+		struct Node *psNode);
+	static void SymTable_copyNode(struct Node *psTo,
+		const struct Node *psFrom);
+
+/* Special function to find the node, inline or in a bucket, that
+   holds pcKey */
+	static struct Node *SymTable_find(SymTable_T oSymTable,
+		const char *pcKey, size_t uHash);
+
+/* Special function to add the chain that starts at psHead to the
+   chain statistics in psStats */
+	static void SymTable_addChain(struct SymTable_Stats *psStats,
+		struct Node *psHead);
+
+/* Special function to move the inline bindings of a small table into
+   a newly allocated array of 2^(HASH_BITS - uShift) buckets */
+	static int SymTable_spill(SymTable_T oSymTable, size_t uShift);
+
+/* Special function to move every node, in one pass, into a newly
+   allocated array of 2^(HASH_BITS - uShift) buckets */
+	static int SymTable_relink(SymTable_T oSymTable, size_t uShift);
+
+/* Special function to make sure the arena can hand out uCount more
+   nodes without allocating */
+	static int SymTable_reserveNodes(SymTable_T oSymTable, size_t uCount);
+
+/* Special function to size the bucket array for uCapacity bindings
+   and finish any resize in progress */
+	static int SymTable_reserveBuckets(SymTable_T oSymTable,
+		size_t uCapacity);
+
+/* Special function to run the chunks of one worker of a parallel
+   call, stealing more when they run out */
+	static void *SymTable_work(void *pvWorker);
+
+/* Special function to run tasks on several threads that steal chunks
+   of work from each other */
+	static void SymTable_runParallel(size_t uTasks, size_t uThreads,
+		void (*pfRun)(void *pvJob, size_t uThread, size_t uFirst,
+			size_t uLast), void *pvJob);
+
+/* Special function to apply a function to the bindings of a range of
+   buckets */
+	static void SymTable_mapRange(void *pvJob, size_t uThread,
+		size_t uFirst, size_t uLast);
+
+/* Special function to hash and measure a range of the keys of a bulk
+   put */
+	static void SymTable_hashRange(void *pvJob, size_t uThread,
+		size_t uFirst, size_t uLast);
+
+/* Special function to put the bindings of a bulk put that a small
+   table keeps inline, one at a time */
+	static int SymTable_putSmall(SymTable_T oSymTable,
+		const char *const *ppcKeys, void *const *ppvValues,
+		size_t uCount, int *piAdded);
+
+/* The header of a saved image, defined below */
+	struct Image;
+
+/* Special functions to find the bucket starts and the entries of a
+   mapped image */
+	static const size_t *SymTable_imageStarts(
+		const struct Image *psImage);
+	static const struct ImageEntry *SymTable_imageEntries(
+		const struct Image *psImage);
+
+/* Special function to find the entry of a mapped table that holds
+   pcKey */
+	static const struct ImageEntry *SymTable_findMapped(
+		SymTable_T oSymTable, const char *pcKey);
+
+/* Special function to make room in the block that SymTable_save
+   builds keys and values in */
+	static int SymTable_growHeap(char **ppcHeap, size_t *puRoom,
+		size_t uNeeded);
+
+/* Special function to check that a mapped file of uBytes bytes holds
+   an image that this machine can read */
+	static int SymTable_checkImage(const struct Image *psImage,
+		size_t uBytes);
+
+/* Special function to fill in the statistics of a mapped table */
+	static void SymTable_getMappedStats(SymTable_T oSymTable,
+		struct SymTable_Stats *psStats);
+
+/* Special function to release every node, key copy and bucket array
+   of oSymTable */
+	static void SymTable_release(SymTable_T oSymTable);
+
+/* The perfect hash of a frozen table, and one binding that
+   SymTable_freeze places in it, defined below */
+	struct Frozen;
+	struct FreezeKey;
+
+/* Special function to find the slot that displacement uDisp sends a
+   key whose hash code is uHash to, in a frozen table of uSlots
+   slots */
+	static size_t SymTable_slot(size_t uHash, size_t uDisp,
+		size_t uSlots);
+
+/* Special function to find the slot of a frozen table that holds
+   pcKey */
+	static size_t SymTable_findFrozen(SymTable_T oSymTable,
+		const char *pcKey);
+
+/* Special function to find a displacement for every bucket of a
+   perfect hash, and place the bindings in its slots */
+	static int SymTable_place(struct Frozen *psFrozen,
+		const struct FreezeKey *psKeys, size_t uCount, size_t *puWork);
+
+/* Special function to fill in the statistics of a frozen table */
+	static void SymTable_getFrozenStats(SymTable_T oSymTable,
+		struct SymTable_Stats *psStats);
+
+/*-------------------------------------------------------------------*/
+
+/* Node is a structure that stores and associates a char Key with
+   a void value and also maintains a pointer to the next node. */
+
+	struct Node
+	{
+	/* Full hash code of pcKey, kept so that resizing never rehashes
+	   a key and chain walks can skip most strcmp calls. */
+		size_t uHash;
+
+	/* Char pointer to hold the Key: acKey if the key fits there, or a
+	   key copy from the arena. */
+		const char *pcKey;
+
+	/* A void pointer to hold the Value. */
+		void *pvValue;
+
+	/* Another Node to hold a pointer to the next Node. */
+		struct Node *psNext;
+
+	/* The key itself, if it is at most KEY_INLINE bytes long. */
+		char acKey[KEY_INLINE];
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Chunk is the header of one large block of memory that nodes or key
+   copies are carved from. The usable memory follows the header. */
+
+	struct Chunk
+	{
+	/* The chunk allocated before this one. */
+		struct Chunk *psNext;
+
+	/* Number of nodes at the start of the usable memory, or 0 for a
+	   chunk of key copies only. */
+		size_t uNodeCount;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* LongKey is the header of a key copy too long for any size class.
+   Such keys are linked so that SymTable_free can release them without
+   walking the buckets. The key bytes follow the header. */
+
+	struct LongKey
+	{
+	/* Neighbours in the table's list of long keys. */
+		struct LongKey *psPrev;
+		struct LongKey *psNext;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Arena is a structure that hands out the nodes and key copies of one
+   SymTable from a few large chunks, and keeps removed ones on free
+   lists for reuse. */
+
+	struct Arena
+	{
+	/* Every chunk allocated for this table. */
+		struct Chunk *psChunks;
+
+	/* Removed nodes, linked through psNext. Their pcKey is NULL. */
+		struct Node *psFreeNodes;
+
+	/* The newest node chunk, its next never-used node, and how many
+	   remain after it. */
+		struct Chunk *psNodeChunk;
+		struct Node *psNodeNext;
+		size_t uNodesLeft;
+
+	/* Number of nodes to put in the next node chunk. */
+		size_t uNodeChunkLength;
+
+	/* Next never-used byte of the newest key chunk, and how many
+	   remain after it. */
+		char *pcKeyNext;
+		size_t uKeyBytesLeft;
+
+	/* Number of bytes to put in the next key chunk. */
+		size_t uKeyChunkLength;
+
+	/* Removed key copies of each size class, linked through their
+	   first bytes. */
+		char *apcFreeKeys[KEY_CLASS_COUNT];
+
+	/* Key copies too long for a size class. */
+		struct LongKey *psLongKeys;
+
+	/* Bytes held in node chunks, and in key chunks and long keys. */
+		size_t uNodeBytes;
+		size_t uKeyBytes;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain a counter for the number of
+   bindings in a Symbol Table and a pointer to the "head" Node. A
+   small table keeps its bindings inline and has no bucket array. */
+
+	struct SymTable
+	{
+
+	/* Count of the binding elements contained in the hash array from
+	   user's point of view. */
+		size_t uBindCount;
+
+	/* Count of elements in the hash array that undrlies the
+	   SymTable, or 0 while the bindings are still inline. Always a
+	   power of two. */
+		size_t uPhysLength;
+
+	/* HASH_BITS minus the base 2 logarithm of uPhysLength, so that
+	   SymTable_reduce keeps just enough high bits of a hash code. */
+		size_t uShift;
+
+	/* The client's hash function, or NULL to use SymTable_hash. */
+		size_t (*pfHash)(const char *pcKey);
+
+	/* 1 if nodes point to the client's keys instead of copies. */
+		int iBorrowKeys;
+
+	/* The array/table that underlies the SymTable, or NULL while the
+	   bindings are still inline. */
+		struct Node **ppsTable;
+
+	/* The smaller array that a resize is still draining into
+	   ppsTable, or NULL if no resize is in progress. */
+		struct Node **ppsOldTable;
+
+	/* Count of elements in ppsOldTable, and the shift that indexes
+	   it. */
+		size_t uOldPhysLength;
+		size_t uOldShift;
+
+	/* Index of the next ppsOldTable bucket to move. Buckets below it
+	   are already empty. */
+		size_t uMigrateIndex;
+
+	/* Number of resizes started since the table was created. */
+		size_t uResizeCount;
+
+	/* The image that SymTable_openMapped mapped, or NULL for a table
+	   built by puts. A mapped table serves lookups from the image and
+	   must not be changed. */
+		const struct Image *psImage;
+
+	/* The perfect hash that SymTable_freeze built, or NULL. A frozen
+	   table has no bucket array or arena, and must not be changed. */
+		struct Frozen *psFrozen;
+
+	/* Where this table's nodes and key copies come from. */
+		struct Arena sArena;
+
+	/* The first uBindCount elements hold the bindings of a table that
+	   has no bucket array yet. Their psNext fields are unused. */
+		struct Node asInline[INLINE_MAX];
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Worker is a structure that holds the range of chunks one thread of
+   SymTable_runParallel has still to run. Other threads steal from
+   the end of the range once their own is empty. */
+
+	struct Worker
+	{
+	/* Held while uNext or uEnd is read or changed. */
+		pthread_mutex_t sLock;
+
+	/* The chunks still to run are uNext to uEnd - 1. */
+		size_t uNext;
+		size_t uEnd;
+
+	/* This worker's number, and the pool it belongs to. */
+		size_t uThread;
+		struct Pool *psPool;
+
+	/* The worker's thread, if iStarted. Worker 0 is the calling
+	   thread. */
+		pthread_t iThread;
+		int iStarted;
+
+	/* Room to the end of the cache line. */
+		char acPad[CACHE_LINE - (sizeof(pthread_mutex_t) +
+			3 * sizeof(size_t) + sizeof(struct Pool *) +
+			sizeof(pthread_t) + sizeof(int)) % CACHE_LINE];
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Pool is a structure that describes one call of
+   SymTable_runParallel: the job, how it is cut into chunks, and the
+   workers running them. */
+
+	struct Pool
+	{
+	/* The function that runs tasks uFirst to uLast - 1 of pvJob on
+	   thread uThread. */
+		void (*pfRun)(void *pvJob, size_t uThread, size_t uFirst,
+			size_t uLast);
+		void *pvJob;
+
+	/* Number of tasks, and of tasks in each chunk. */
+		size_t uTasks;
+		size_t uChunk;
+
+	/* The workers, aligned to a cache line. */
+		struct Worker *psWorkers;
+		size_t uWorkers;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* MapJob is a structure that holds the arguments of one call of
+   SymTable_mapParallel for SymTable_mapRange. */
+
+	struct MapJob
+	{
+		SymTable_T oSymTable;
+		void (*pfApply)(const char *pcKey, void *pvValue,
+			void *pvExtra);
+		void **ppvExtras;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* BulkKey is a structure that holds what SymTable_putMany learns
+   about one of its keys before it adds any binding. */
+
+	struct BulkKey
+	{
+	/* Hash code of the key, and its size with the terminating '\0'. */
+		size_t uHash;
+		size_t uSize;
+
+	/* The key's copy if it is too long for a size class, or NULL. */
+		char *pcLongCopy;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* BulkJob is a structure that holds the arguments of one call of
+   SymTable_putMany for SymTable_hashRange. */
+
+	struct BulkJob
+	{
+		SymTable_T oSymTable;
+		const char *const *ppcKeys;
+		struct BulkKey *psKeys;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Image is the header of the file that SymTable_save writes. It is
+   followed by the index of each bucket's first entry (one more than
+   the number of buckets, the last being the number of bindings),
+   then one ImageEntry per binding, grouped by bucket, then the keys
+   and serialized values. Every position is a byte offset from the
+   start of the header, so the image can be mapped anywhere. */
+
+	struct Image
+	{
+	/* IMAGE_MAGIC and sizeof(size_t) as the saving machine wrote
+	   them, so that an image of another word size or byte order is
+	   refused. */
+		size_t uMagic;
+		size_t uWordSize;
+
+	/* Size of the whole image in bytes. */
+		size_t uBytes;
+
+	/* Number of bindings, and the shift that SymTable_reduce indexes
+	   the buckets with. */
+		size_t uBindings;
+		size_t uShift;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* ImageEntry is a structure that locates one binding of an image. */
+
+	struct ImageEntry
+	{
+	/* Hash code of the key under SymTable_hash. */
+		size_t uHash;
+
+	/* Offsets of the key and of the serialized value. */
+		size_t uKey;
+		size_t uValue;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* FrozenSlot is a structure that holds one binding of a frozen
+   table. */
+
+	struct FrozenSlot
+	{
+		const char *pcKey;
+		void *pvValue;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* Frozen is the header of the one block that holds a frozen table: a
+   minimal perfect hash of its keys into as many slots as there are
+   bindings. A key hashed with uSeed falls into a displacement bucket,
+   and the displacement of that bucket picks its slot, so a lookup
+   reads one slot and compares one key. The slots, the displacements,
+   and the key bytes follow the header. */
+
+	struct Frozen
+	{
+	/* Seed that every key is hashed with, and the shift that
+	   SymTable_reduce indexes the displacements with. */
+		size_t uSeed;
+		size_t uShift;
+
+	/* Key and value of each slot, side by side, so that a lookup
+	   that finds its key reads one place for both. */
+		struct FrozenSlot *psSlots;
+
+	/* Displacement of each bucket. */
+		unsigned int *auDisp;
+
+	/* Size of the whole block in bytes. */
+		size_t uBytes;
+	};
+
+/*-------------------------------------------------------------------*/
+
+/* FreezeKey is a structure that holds one binding while
+   SymTable_freeze searches for a perfect hash of the keys. */
+
+	struct FreezeKey
+	{
+	/* Hash code of the key under the seed being tried. */
+		size_t uHash;
+
+	/* The binding's key copy and value. */
+		const char *pcKey;
+		void *pvValue;
+	};
+
+/*-------------------------------------------------------------------*/
+
+	SymTable_T SymTable_new(void)
+	{
+		SymTable_T oSymTable;
+
+	/* Allocate memory and return NULL if it is unsufficient. */
+		size_t uSize = sizeof(struct SymTable);
+		oSymTable = (SymTable_T)malloc(uSize);
+		if (oSymTable == NULL) return NULL;
+
+	/* Initiate SymTable variables. The bucket array is not allocated
+	   until the table outgrows its inline bindings. */
+		oSymTable->uBindCount = 0;
+		oSymTable->uPhysLength = 0;
+		oSymTable->uShift = 0;
+		oSymTable->pfHash = NULL;
+		oSymTable->iBorrowKeys = 0;
+		oSymTable->ppsTable = NULL;
+		oSymTable->ppsOldTable = NULL;
+		oSymTable->uOldPhysLength = 0;
+		oSymTable->uOldShift = 0;
+		oSymTable->uMigrateIndex = 0;
+		oSymTable->uResizeCount = 0;
+		oSymTable->psImage = NULL;
+		oSymTable->psFrozen = NULL;
+
+	/* Start with an empty arena; chunks are allocated on demand. */
+		memset(&oSymTable->sArena, 0, sizeof(struct Arena));
+		oSymTable->sArena.uNodeChunkLength = NODE_CHUNK_MIN;
+		oSymTable->sArena.uKeyChunkLength = KEY_CHUNK_MIN;
+
+		return oSymTable;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+	{
+		SymTable_T oSymTable;
+
+		assert(pfHash != NULL);
+
+		oSymTable = SymTable_new();
+		if (oSymTable == NULL) return NULL;
+		oSymTable->pfHash = pfHash;
+		return oSymTable;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	SymTable_T SymTable_newBorrowedKeys(void)
+	{
+		SymTable_T oSymTable;
+
+		oSymTable = SymTable_new();
+		if (oSymTable == NULL) return NULL;
+		oSymTable->iBorrowKeys = 1;
+		return oSymTable;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+	{
+		SymTable_T oSymTable;
+
+		oSymTable = SymTable_new();
+		if (oSymTable == NULL) return NULL;
+		if (! SymTable_reserve(oSymTable, uCapacity))
+		{
+			SymTable_free(oSymTable);
+			return NULL;
+		}
+		return oSymTable;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Size the bucket array for uCapacity bindings, and carve the nodes
+   that the bindings not yet in the table will need from one arena
+   chunk. Key copies still come from the arena as they are put, since
+   their lengths are not known yet. */
+
+	int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+	{
+		assert(oSymTable != NULL);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+		if (! SymTable_reserveBuckets(oSymTable, uCapacity)) return 0;
+		if (oSymTable->ppsTable == NULL ||
+			uCapacity <= oSymTable->uBindCount)
+			return 1;
+		return SymTable_reserveNodes(oSymTable,
+			uCapacity - oSymTable->uBindCount);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* A table holds uCapacity bindings without resizing once it has at
+   least uCapacity buckets, since a put only doubles the array at one
+   binding per bucket. Make it so in one step, unless oSymTable can
+   keep that many bindings inline. Afterwards no resize is in
+   progress. Return 1 on success, or 0 (leaving the bindings
+   unchanged) if insufficient memory is available. */
+
+	static int SymTable_reserveBuckets(SymTable_T oSymTable,
+		size_t uCapacity)
+	{
+		size_t uLength = (size_t)1 << INITIAL_LENGTH_LOG;
+		size_t uShift = HASH_BITS - INITIAL_LENGTH_LOG;
+
+		assert(oSymTable != NULL);
+
+	/* A small table keeps up to INLINE_MAX bindings without any
+	   array or nodes at all. */
+		if (oSymTable->ppsTable == NULL && uCapacity <= INLINE_MAX)
+			return 1;
+
+		while (uLength < uCapacity)
+		{
+			if (uLength > (size_t)-1 / sizeof(struct Node*) / 2 ||
+				uShift <= 1)
+				return 0;
+			uLength *= 2;
+			uShift--;
+		}
+
+		if (oSymTable->ppsTable == NULL)
+		{
+			if (! SymTable_spill(oSymTable, uShift)) return 0;
+		}
+		else
+		{
+			SymTable_migrate(oSymTable, oSymTable->uOldPhysLength);
+			if (uLength > oSymTable->uPhysLength &&
+				! SymTable_relink(oSymTable, uShift))
+				return 0;
+		}
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void SymTable_free(SymTable_T oSymTable)
+	{
+		assert(oSymTable != NULL);
+
+		SymTable_release(oSymTable);
+		if (oSymTable->psImage != NULL)
+			munmap((void *)oSymTable->psImage,
+				oSymTable->psImage->uBytes);
+		free(oSymTable->psFrozen);
+		free(oSymTable);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Free every chunk, long key and bucket array of oSymTable. Every
+   node and key copy, inline bindings' keys included, lives in an
+   arena chunk or on the long key list, so release those instead of
+   walking the buckets. */
+
+	static void SymTable_release(SymTable_T oSymTable)
+	{
+		struct Chunk *psChunk;
+		struct LongKey *psLongKey;
+		void *pvTemp;
+
+		assert(oSymTable != NULL);
+
+		for (psChunk = oSymTable->sArena.psChunks; psChunk != NULL;
+			psChunk = (struct Chunk *)pvTemp)
+		{
+			pvTemp = psChunk->psNext;
+			free(psChunk);
+		}
+		for (psLongKey = oSymTable->sArena.psLongKeys; psLongKey != NULL;
+			psLongKey = (struct LongKey *)pvTemp)
+		{
+			pvTemp = psLongKey->psNext;
+			free(psLongKey);
+		}
+		free(oSymTable->ppsOldTable);
+		free(oSymTable->ppsTable);
+	}
+
+/*-------------------------------------------------------------------*/
+
+	size_t SymTable_getLength(SymTable_T oSymTable)
+	{
+		assert(oSymTable != NULL);
+
+	/* Return length count from SymTable structure. */
+		return oSymTable->uBindCount;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey. The key is consumed a whole size_t
+   word at a time (MurmurHash2 mixing), so a long key costs one
+   multiply per word on the serial path instead of one per byte. */
+
+	static size_t SymTable_hash(const char *pcKey, size_t uSeed)
+	{
+		size_t uLength;
+		size_t uTail;
+		size_t uWord;
+		size_t uHash;
+		const char *pcEnd;
+
+		assert(pcKey != NULL);
+
+		uLength = strlen(pcKey);
+		uTail = uLength % sizeof(size_t);
+		uHash = (uLength ^ uSeed) * HASH_MIX;
+
+	/* Mix in each whole word. The per-word mixing does not depend on
+	   uHash, so consecutive words overlap in the pipeline. */
+		for (pcEnd = pcKey + (uLength - uTail); pcKey != pcEnd;
+			pcKey += sizeof(size_t))
+		{
+			memcpy(&uWord, pcKey, sizeof(size_t));
+			uWord *= HASH_MIX;
+			uWord ^= uWord >> HASH_SHIFT;
+			uWord *= HASH_MIX;
+			uHash ^= uWord;
+			uHash *= HASH_MIX;
+		}
+
+	/* Mix in the last few bytes, then avalanche. */
+		if (uTail != 0)
+		{
+			uWord = 0;
+			memcpy(&uWord, pcKey, uTail);
+			uHash ^= uWord;
+			uHash *= HASH_MIX;
+		}
+		uHash ^= uHash >> HASH_SHIFT;
+		uHash *= HASH_MIX;
+		uHash ^= uHash >> HASH_SHIFT;
+		return uHash;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey under oSymTable's hash function.
+   Callers reduce it with the shift of whichever array they are
+   indexing. */
+
+	static size_t SymTable_hashKey(SymTable_T oSymTable,
+		const char *pcKey)
+	{
+		assert(oSymTable != NULL);
+
+		if (oSymTable->pfHash != NULL)
+			return (*oSymTable->pfHash)(pcKey);
+		return SymTable_hash(pcKey, 0);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the index of the bucket for hash code uHash in an array of
+   2^(HASH_BITS - uShift) buckets. Multiplying by HASH_FIBONACCI mixes
+   every bit of uHash into the high bits that are kept, so a client
+   hash that is weak in its low bits still spreads well, and no
+   division is needed. The index is a prefix of the index in an array
+   twice the size, so bucket i of one array splits into exactly
+   buckets 2i and 2i+1 of the next. */
+
+	static size_t SymTable_reduce(size_t uHash, size_t uShift)
+	{
+		assert(uShift > 0 && uShift < HASH_BITS);
+
+		return (uHash * HASH_FIBONACCI) >> uShift;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the address of the bucket that holds, or would hold, a key
+   with hash code uHash. While a resize is in progress a key lives in
+   ppsOldTable if its old bucket has not been moved yet, and in
+   ppsTable otherwise. */
+
+	static struct Node **SymTable_bucket(SymTable_T oSymTable,
+		size_t uHash)
+	{
+		size_t uOldIndex;
+
+		assert(oSymTable != NULL);
+
+		if (oSymTable->ppsOldTable != NULL)
+		{
+			uOldIndex = SymTable_reduce(uHash, oSymTable->uOldShift);
+			if (uOldIndex >= oSymTable->uMigrateIndex)
+				return &oSymTable->ppsOldTable[uOldIndex];
+		}
+		return &oSymTable->ppsTable[SymTable_reduce(uHash,
+			oSymTable->uShift)];
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the address of the link (bucket or psNext field) that points
+   to the node holding pcKey, whose hash code is uHash, or the address
+   of the NULL link that ends its bucket if there is no such node. */
+
+	static struct Node **SymTable_findLink(SymTable_T oSymTable,
+		const char *pcKey, size_t uHash)
+	{
+		struct Node **ppsLink;
+		struct Node *psCurr;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+		for (ppsLink = SymTable_bucket(oSymTable, uHash);
+			(psCurr = *ppsLink) != NULL; ppsLink = &psCurr->psNext)
+		{
+			if (psCurr->uHash == uHash &&
+				strcmp(pcKey, psCurr->pcKey) == 0) break;
+		}
+		return ppsLink;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the node holding pcKey, whose hash code is uHash, or NULL
+   if oSymTable contains no such binding. A small table is searched
+   linearly; a large one through the key's bucket. */
+
+	static struct Node *SymTable_find(SymTable_T oSymTable,
+		const char *pcKey, size_t uHash)
+	{
+		struct Node *psCurr;
+		size_t uIndex;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+		if (oSymTable->ppsTable != NULL)
+			return *SymTable_findLink(oSymTable, pcKey, uHash);
+
+		for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+		{
+			psCurr = &oSymTable->asInline[uIndex];
+			if (psCurr->uHash == uHash &&
+				strcmp(pcKey, psCurr->pcKey) == 0) return psCurr;
+		}
+		return NULL;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Allocate the first bucket array of a small oSymTable, with
+   2^(HASH_BITS - uShift) buckets, and move its inline bindings into
+   arena nodes in that array. Return 1 on success, or 0 (leaving
+   oSymTable unchanged) if insufficient memory is available. */
+
+	static int SymTable_spill(SymTable_T oSymTable, size_t uShift)
+	{
+		struct Node *apsNodes[INLINE_MAX];
+		struct Node **ppsTable;
+		size_t uHashedIndex;
+		size_t uIndex;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->ppsTable == NULL);
+
+		ppsTable = (struct Node**)calloc((size_t)1 << (HASH_BITS - uShift),
+			sizeof(struct Node*));
+		if (ppsTable == NULL) return 0;
+
+	/* Take every node needed before changing anything, so a failure
+	   can be undone. */
+		for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+		{
+			apsNodes[uIndex] = SymTable_allocNode(oSymTable);
+			if (apsNodes[uIndex] == NULL)
+			{
+				while (uIndex-- > 0)
+					SymTable_freeNode(oSymTable, apsNodes[uIndex]);
+				free(ppsTable);
+				return 0;
+			}
+		}
+
+		for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+		{
+			SymTable_copyNode(apsNodes[uIndex],
+				&oSymTable->asInline[uIndex]);
+			uHashedIndex = SymTable_reduce(apsNodes[uIndex]->uHash,
+				uShift);
+			apsNodes[uIndex]->psNext = ppsTable[uHashedIndex];
+			ppsTable[uHashedIndex] = apsNodes[uIndex];
+		}
+
+		oSymTable->uPhysLength = (size_t)1 << (HASH_BITS - uShift);
+		oSymTable->uShift = uShift;
+		oSymTable->ppsTable = ppsTable;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Move every node of oSymTable, which has a bucket array and no
+   resize in progress, into a newly allocated array of
+   2^(HASH_BITS - uShift) buckets in one pass. Return 1 on success, or
+   0 (leaving oSymTable unchanged) if insufficient memory is
+   available. */
+
+	static int SymTable_relink(SymTable_T oSymTable, size_t uShift)
+	{
+		struct Node **ppsTable;
+		struct Node *psCurr;
+		struct Node *psNext;
+		size_t uIndex;
+		size_t uHashedIndex;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->ppsTable != NULL);
+		assert(oSymTable->ppsOldTable == NULL);
+
+		ppsTable = (struct Node**)calloc((size_t)1 << (HASH_BITS - uShift),
+			sizeof(struct Node*));
+		if (ppsTable == NULL) return 0;
+
+		for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+		{
+			for (psCurr = oSymTable->ppsTable[uIndex]; psCurr != NULL;
+				psCurr = psNext)
+			{
+				psNext = psCurr->psNext;
+				uHashedIndex = SymTable_reduce(psCurr->uHash, uShift);
+				psCurr->psNext = ppsTable[uHashedIndex];
+				ppsTable[uHashedIndex] = psCurr;
+			}
+		}
+
+		free(oSymTable->ppsTable);
+		oSymTable->ppsTable = ppsTable;
+		oSymTable->uPhysLength = (size_t)1 << (HASH_BITS - uShift);
+		oSymTable->uShift = uShift;
+		oSymTable->uResizeCount++;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Take an oSymTable object and start moving its elements over into
+   an expanded array with twice as many buckets. The elements are
+   moved a few buckets at a time by SymTable_migrate, so no single
+   call pays for the whole table. */
+
+	static void SymTable_resize(SymTable_T oSymTable)
+	{
+		size_t uNewLength;
+		struct Node **ppsExpandedTable;
+
+		assert(oSymTable != NULL);
+
+		/* A new resize can only start once the last one is done. */
+		if (oSymTable->ppsOldTable != NULL)
+			SymTable_migrate(oSymTable, oSymTable->uOldPhysLength);
+
+		/* Double the number of buckets. Give up if the size would
+		   overflow, or if the hash codes have no bits left to tell
+		   the new buckets apart. */
+		if (oSymTable->uPhysLength >
+			(size_t)-1 / sizeof(struct Node*) / 2 ||
+			oSymTable->uShift <= 1)
+			return;
+		uNewLength = oSymTable->uPhysLength * 2;
+
+		ppsExpandedTable =
+		(struct Node**)calloc(uNewLength, sizeof(struct Node*));
+
+		/* Return if there is insufficient memory.
+		   I just return instead of returning NULL because this is a
+		   static function. */
+		if (ppsExpandedTable == NULL) return;
+
+		/* The current array becomes the one being drained. */
+		oSymTable->ppsOldTable = oSymTable->ppsTable;
+		oSymTable->uOldPhysLength = oSymTable->uPhysLength;
+		oSymTable->uOldShift = oSymTable->uShift;
+		oSymTable->uMigrateIndex = 0;
+		oSymTable->ppsTable = ppsExpandedTable;
+		oSymTable->uPhysLength = uNewLength;
+		oSymTable->uShift--;
+		oSymTable->uResizeCount++;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Take an oSymTable object and start moving its elements over into
+   an array with half as many buckets, never fewer than a table's
+   first array has. Like SymTable_resize, the elements are moved a
+   few buckets at a time by SymTable_migrate. Do nothing while a
+   resize is still in progress; a later remove tries again. */
+
+	static void SymTable_shrink(SymTable_T oSymTable)
+	{
+		struct Node **ppsShrunkTable;
+
+		assert(oSymTable != NULL);
+
+		/* A new resize can only start once the last one is done.
+		   Draining it here would make this one remove pay for up to
+		   the whole old array. */
+		if (oSymTable->ppsOldTable != NULL) return;
+
+		if (oSymTable->uPhysLength <= (size_t)1 << INITIAL_LENGTH_LOG)
+			return;
+
+		/* Keep the current array if there is insufficient memory. */
+		ppsShrunkTable = (struct Node**)calloc(
+			oSymTable->uPhysLength / 2, sizeof(struct Node*));
+		if (ppsShrunkTable == NULL) return;
+
+		/* The current array becomes the one being drained. */
+		oSymTable->ppsOldTable = oSymTable->ppsTable;
+		oSymTable->uOldPhysLength = oSymTable->uPhysLength;
+		oSymTable->uOldShift = oSymTable->uShift;
+		oSymTable->uMigrateIndex = 0;
+		oSymTable->ppsTable = ppsShrunkTable;
+		oSymTable->uPhysLength /= 2;
+		oSymTable->uShift++;
+		oSymTable->uResizeCount++;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Move up to uBuckets buckets of ppsOldTable into ppsTable. When
+   growing, old bucket i splits into new buckets 2i and 2i+1, and the
+   one bit of each node's cached hash code that the new shift adds
+   picks which. Nodes keep their order within each half. Both new
+   buckets are still empty, since a put only reaches them once bucket
+   i has been moved. When shrinking, old bucket i is put in front of
+   new bucket i/2, which may already hold the other half and new
+   puts. Free ppsOldTable once every bucket has been moved. */
+
+	static void SymTable_migrate(SymTable_T oSymTable, size_t uBuckets)
+	{
+		struct Node **appsTails[2];
+		struct Node *psCurr;
+		struct Node *psTemp;
+		size_t uHalf;
+
+		assert(oSymTable != NULL);
+
+		if (oSymTable->ppsOldTable == NULL) return;
+
+		for (; uBuckets > 0 &&
+			oSymTable->uMigrateIndex < oSymTable->uOldPhysLength;
+			uBuckets--, oSymTable->uMigrateIndex++)
+		{
+			psCurr = oSymTable->ppsOldTable[oSymTable->uMigrateIndex];
+			if (oSymTable->uOldShift < oSymTable->uShift)
+			{
+				if (psCurr == NULL) continue;
+				psTemp = psCurr;
+				while (psTemp->psNext != NULL) psTemp = psTemp->psNext;
+				psTemp->psNext =
+					oSymTable->ppsTable[oSymTable->uMigrateIndex / 2];
+				oSymTable->ppsTable[oSymTable->uMigrateIndex / 2] = psCurr;
+				oSymTable->ppsOldTable[oSymTable->uMigrateIndex] = NULL;
+				continue;
+			}
+
+			appsTails[0] =
+				&oSymTable->ppsTable[oSymTable->uMigrateIndex * 2];
+			appsTails[1] = appsTails[0] + 1;
+			for (psCurr =
+				oSymTable->ppsOldTable[oSymTable->uMigrateIndex];
+				psCurr != NULL; psCurr = psTemp)
+			{
+				psTemp = psCurr->psNext;
+				uHalf = SymTable_reduce(psCurr->uHash,
+					oSymTable->uShift) & 1;
+				*appsTails[uHalf] = psCurr;
+				appsTails[uHalf] = &psCurr->psNext;
+			}
+			*appsTails[0] = NULL;
+			*appsTails[1] = NULL;
+			oSymTable->ppsOldTable[oSymTable->uMigrateIndex] = NULL;
+		}
+
+		/* Free the drained array once every bucket has moved. */
+		if (oSymTable->uMigrateIndex == oSymTable->uOldPhysLength)
+		{
+			free(oSymTable->ppsOldTable);
+			oSymTable->ppsOldTable = NULL;
+			oSymTable->uOldPhysLength = 0;
+			oSymTable->uOldShift = 0;
+			oSymTable->uMigrateIndex = 0;
+		}
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Allocate a chunk with room for uBytes bytes after its header, the
+   first uNodeCount nodes of them, link it into oSymTable's arena and
+   return the address of that room, or NULL if insufficient memory is
+   available. */
+
+	static void *SymTable_allocChunk(SymTable_T oSymTable, size_t uBytes,
+		size_t uNodeCount)
+	{
+		struct Chunk *psChunk;
+
+		assert(oSymTable != NULL);
+		assert(uNodeCount <= uBytes / sizeof(struct Node));
+
+		psChunk = (struct Chunk *)malloc(sizeof(struct Chunk) + uBytes);
+		if (psChunk == NULL) return NULL;
+		psChunk->uNodeCount = uNodeCount;
+		psChunk->psNext = oSymTable->sArena.psChunks;
+		oSymTable->sArena.psChunks = psChunk;
+		return psChunk + 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return an unused node from oSymTable's arena, preferring one that
+   was removed earlier, or NULL if insufficient memory is
+   available. */
+
+	static struct Node *SymTable_allocNode(SymTable_T oSymTable)
+	{
+		struct Arena *psArena;
+		struct Node *psNode;
+
+		assert(oSymTable != NULL);
+
+		psArena = &oSymTable->sArena;
+		if (psArena->psFreeNodes != NULL)
+		{
+			psNode = psArena->psFreeNodes;
+			psArena->psFreeNodes = psNode->psNext;
+			return psNode;
+		}
+
+	/* Start a new node chunk, twice as long as the last one, once the
+	   current one is used up. */
+		if (psArena->uNodesLeft == 0)
+		{
+			psNode = (struct Node *)SymTable_allocChunk(oSymTable,
+				psArena->uNodeChunkLength * sizeof(struct Node),
+				psArena->uNodeChunkLength);
+			if (psNode == NULL) return NULL;
+			psArena->psNodeChunk = psArena->psChunks;
+			psArena->uNodeBytes +=
+				psArena->uNodeChunkLength * sizeof(struct Node);
+			psArena->psNodeNext = psNode;
+			psArena->uNodesLeft = psArena->uNodeChunkLength;
+			if (psArena->uNodeChunkLength < NODE_CHUNK_MAX)
+				psArena->uNodeChunkLength *= 2;
+		}
+
+		psArena->uNodesLeft--;
+		return psArena->psNodeNext++;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Make sure that the next uCount nodes oSymTable's arena hands out
+   come from the free list or the current chunk. If the current chunk
+   is too short, put what is left of it on the free list and carve
+   the rest from one new chunk of exactly the length needed. Return 1
+   on success, or 0 if insufficient memory is available. */
+
+	static int SymTable_reserveNodes(SymTable_T oSymTable, size_t uCount)
+	{
+		struct Arena *psArena;
+		struct Node *psNode;
+
+		assert(oSymTable != NULL);
+
+		psArena = &oSymTable->sArena;
+		if (uCount <= psArena->uNodesLeft) return 1;
+		if (uCount > ((size_t)-1 - sizeof(struct Chunk)) /
+			sizeof(struct Node))
+			return 0;
+
+		psNode = (struct Node *)SymTable_allocChunk(oSymTable,
+			uCount * sizeof(struct Node), uCount);
+		if (psNode == NULL) return 0;
+		psArena->uNodeBytes += uCount * sizeof(struct Node);
+
+		while (psArena->uNodesLeft > 0)
+		{
+			psArena->uNodesLeft--;
+			SymTable_freeNode(oSymTable, psArena->psNodeNext++);
+		}
+		psArena->psNodeChunk = psArena->psChunks;
+		psArena->psNodeNext = psNode;
+		psArena->uNodesLeft = uCount;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Put psNode, which is no longer in any bucket, on oSymTable's free
+   node list. Clear its key, which marks it unused for
+   SymTable_clear. */
+
+	static void SymTable_freeNode(SymTable_T oSymTable,
+		struct Node *psNode)
+	{
+		assert(oSymTable != NULL);
+		assert(psNode != NULL);
+
+		psNode->pcKey = NULL;
+		psNode->psNext = oSymTable->sArena.psFreeNodes;
+		oSymTable->sArena.psFreeNodes = psNode;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return room for a key copy of uSize bytes (terminating '\0'
+   included) from oSymTable's arena, or NULL if insufficient memory
+   is available. */
+
+	static char *SymTable_allocKey(SymTable_T oSymTable, size_t uSize)
+	{
+		struct Arena *psArena;
+		struct LongKey *psLongKey;
+		size_t uClass;
+		size_t uBlock;
+		char *pcKey;
+
+		assert(oSymTable != NULL);
+		assert(uSize > 0);
+
+		psArena = &oSymTable->sArena;
+		uClass = (uSize - 1) / KEY_GRANULE;
+
+	/* Long keys get their own block on the long key list. */
+		if (uClass >= KEY_CLASS_COUNT)
+		{
+			psLongKey = (struct LongKey *)malloc(sizeof(struct LongKey) +
+				uSize);
+			if (psLongKey == NULL) return NULL;
+			psArena->uKeyBytes += sizeof(struct LongKey) + uSize;
+			psLongKey->psPrev = NULL;
+			psLongKey->psNext = psArena->psLongKeys;
+			if (psArena->psLongKeys != NULL)
+				psArena->psLongKeys->psPrev = psLongKey;
+			psArena->psLongKeys = psLongKey;
+			return (char *)(psLongKey + 1);
+		}
+
+	/* Reuse a removed key of the same size class if there is one. */
+		if (psArena->apcFreeKeys[uClass] != NULL)
+		{
+			pcKey = psArena->apcFreeKeys[uClass];
+			psArena->apcFreeKeys[uClass] = *(char **)(void *)pcKey;
+			return pcKey;
+		}
+
+	/* Otherwise carve the block from the newest key chunk, starting a
+	   new chunk if the rest of this one is too small. */
+		uBlock = (uClass + 1) * KEY_GRANULE;
+		if (psArena->uKeyBytesLeft < uBlock)
+		{
+			pcKey = (char *)SymTable_allocChunk(oSymTable,
+				psArena->uKeyChunkLength, 0);
+			if (pcKey == NULL) return NULL;
+			psArena->uKeyBytes += psArena->uKeyChunkLength;
+			psArena->pcKeyNext = pcKey;
+			psArena->uKeyBytesLeft = psArena->uKeyChunkLength;
+			if (psArena->uKeyChunkLength < KEY_CHUNK_MAX)
+				psArena->uKeyChunkLength *= 2;
+		}
+
+		pcKey = psArena->pcKeyNext;
+		psArena->pcKeyNext += uBlock;
+		psArena->uKeyBytesLeft -= uBlock;
+		return pcKey;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Give key copy pcKey, which came from SymTable_allocKey, back to
+   oSymTable's arena. */
+
+	static void SymTable_freeKey(SymTable_T oSymTable, const char *pcKey)
+	{
+		struct Arena *psArena;
+		struct LongKey *psLongKey;
+		size_t uClass;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+		psArena = &oSymTable->sArena;
+		uClass = strlen(pcKey) / KEY_GRANULE;
+
+	/* Unlink and free a long key... */
+		if (uClass >= KEY_CLASS_COUNT)
+		{
+			psLongKey = (struct LongKey *)(void *)pcKey - 1;
+			if (psLongKey->psPrev != NULL)
+				psLongKey->psPrev->psNext = psLongKey->psNext;
+			else
+				psArena->psLongKeys = psLongKey->psNext;
+			if (psLongKey->psNext != NULL)
+				psLongKey->psNext->psPrev = psLongKey->psPrev;
+			psArena->uKeyBytes -= sizeof(struct LongKey) +
+				strlen(pcKey) + 1;
+			free(psLongKey);
+			return;
+		}
+
+	/* ...or push a short one onto the free list of its class. */
+		*(char **)(void *)pcKey = psArena->apcFreeKeys[uClass];
+		psArena->apcFreeKeys[uClass] = (char *)pcKey;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Copy pcKey into psNode's acKey if it fits, or into a key copy from
+   oSymTable's arena otherwise, and point psNode's pcKey at it. A
+   table that borrows its keys points it at pcKey itself. Return 1,
+   or 0 if insufficient memory is available. */
+
+	static int SymTable_setKey(SymTable_T oSymTable, struct Node *psNode,
+		const char *pcKey)
+	{
+		char *pcCopy;
+		size_t uSize;
+
+		assert(oSymTable != NULL);
+		assert(psNode != NULL);
+		assert(pcKey != NULL);
+
+		if (oSymTable->iBorrowKeys)
+		{
+			psNode->pcKey = pcKey;
+			return 1;
+		}
+		uSize = strlen(pcKey) + 1;
+		if (uSize <= KEY_INLINE)
+			pcCopy = psNode->acKey;
+		else
+		{
+			pcCopy = SymTable_allocKey(oSymTable, uSize);
+			if (pcCopy == NULL) return 0;
+		}
+		memcpy(pcCopy, pcKey, uSize);
+		psNode->pcKey = pcCopy;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Give psNode's key copy back to oSymTable's arena, unless the key is
+   in the node itself or belongs to the client. */
+
+	static void SymTable_dropKey(SymTable_T oSymTable,
+		struct Node *psNode)
+	{
+		assert(oSymTable != NULL);
+		assert(psNode != NULL);
+		assert(psNode->pcKey != NULL);
+
+		if (! oSymTable->iBorrowKeys && psNode->pcKey != psNode->acKey)
+			SymTable_freeKey(oSymTable, psNode->pcKey);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Copy the binding of psFrom, which may be psTo, into psTo, keeping
+   an inline key's pcKey pointing into its own node. */
+
+	static void SymTable_copyNode(struct Node *psTo,
+		const struct Node *psFrom)
+	{
+		assert(psTo != NULL);
+		assert(psFrom != NULL);
+
+		*psTo = *psFrom;
+		if (psFrom->pcKey == psFrom->acKey) psTo->pcKey = psTo->acKey;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+		const void *pvValue)
+	{
+		int iAdded;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+		if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) ==
+			NULL) return 0;
+		return iAdded;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+		const void *pvValue)
+	{
+		struct Node *psCurr;
+		void *pvOldValue;
+
+		assert (oSymTable != NULL);
+		assert (pcKey != NULL);
+		assert (oSymTable->psImage == NULL);
+		assert (oSymTable->psFrozen == NULL);
+
+		SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+	/* Find the node whose key matches pcKey, if any. */
+		psCurr = SymTable_find(oSymTable, pcKey,
+			SymTable_hashKey(oSymTable, pcKey));
+		if (psCurr == NULL) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+		pvOldValue = psCurr->pvValue;
+		psCurr->pvValue = (void *)pvValue;
+		return pvOldValue;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+	{
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+		if (oSymTable->psImage != NULL)
+			return SymTable_findMapped(oSymTable, pcKey) != NULL;
+		if (oSymTable->psFrozen != NULL)
+			return SymTable_findFrozen(oSymTable, pcKey) !=
+				oSymTable->uBindCount;
+
+		SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+	/* Return 1 if a node's key matches the query key, 0 otherwise. */
+		return SymTable_find(oSymTable, pcKey,
+			SymTable_hashKey(oSymTable, pcKey)) != NULL;
+	}
+
+	void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+	{
+		struct Node *psCurr;
+		const struct ImageEntry *psEntry;
+		size_t uSlot;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+	/* A mapped table's values are their serialized bytes, read in
+	   place. */
+		if (oSymTable->psImage != NULL)
+		{
+			psEntry = SymTable_findMapped(oSymTable, pcKey);
+			if (psEntry == NULL) return NULL;
+			return (void *)((const char *)oSymTable->psImage +
+				psEntry->uValue);
+		}
+
+	/* A frozen table's key is in one slot or nowhere. */
+		if (oSymTable->psFrozen != NULL)
+		{
+			uSlot = SymTable_findFrozen(oSymTable, pcKey);
+			if (uSlot == oSymTable->uBindCount) return NULL;
+			return oSymTable->psFrozen->psSlots[uSlot].pvValue;
+		}
+
+		SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+	/* Return a pointer to the value connected to the query Key */
+		psCurr = SymTable_find(oSymTable, pcKey,
+			SymTable_hashKey(oSymTable, pcKey));
+		if (psCurr == NULL) return NULL;
+		return psCurr->pvValue;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+	{
+		struct Node *psCurr;
+		struct Node **ppsLink;
+		void *pvOldValue;
+		size_t uHash;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+	/* Return NULL if oSymbolTable has no bindings */
+		if (oSymTable->uBindCount == 0) return NULL;
+
+	/* Move old buckets faster while shrinking, so that the halving
+	   is done before the next one is due. */
+		SymTable_migrate(oSymTable, oSymTable->ppsOldTable != NULL &&
+			oSymTable->uOldShift < oSymTable->uShift ?
+			SHRINK_STEP : MIGRATE_STEP);
+		uHash = SymTable_hashKey(oSymTable, pcKey);
+
+	/* In a small table, fill the removed binding's place with the
+	   last inline binding. */
+		if (oSymTable->ppsTable == NULL)
+		{
+			psCurr = SymTable_find(oSymTable, pcKey, uHash);
+			if (psCurr == NULL) return NULL;
+			pvOldValue = psCurr->pvValue;
+			SymTable_dropKey(oSymTable, psCurr);
+			oSymTable->uBindCount--;
+			SymTable_copyNode(psCurr,
+				&oSymTable->asInline[oSymTable->uBindCount]);
+			return pvOldValue;
+		}
+
+	/* Find the link to the query key's Node and return NULL if there
+	   is none. Otherwise unlink and free the Node, update the count
+	   and return the removed value. */
+		ppsLink = SymTable_findLink(oSymTable, pcKey, uHash);
+		psCurr = *ppsLink;
+		if (psCurr == NULL) return NULL;
+
+		pvOldValue = psCurr->pvValue;
+		*ppsLink = psCurr->psNext;
+		SymTable_dropKey(oSymTable, psCurr);
+		SymTable_freeNode(oSymTable, psCurr);
+		oSymTable->uBindCount--;
+
+	/* Start shrinking once the table is mostly empty buckets. */
+		if (oSymTable->uBindCount <
+			oSymTable->uPhysLength / SHRINK_LOAD_DEN)
+			SymTable_shrink(oSymTable);
+		return pvOldValue;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Walk the nodes carved from the arena's node chunks instead of the
+   buckets. A node in use empties its bucket and gives back its key
+   copy, and every node goes on the free list, so only occupied
+   buckets are written and a large, mostly empty array costs nothing.
+   The bucket array and every chunk stay for the next bindings. */
+
+	void SymTable_clear(SymTable_T oSymTable)
+	{
+		struct Arena *psArena;
+		struct Chunk *psChunk;
+		struct Node *psNode;
+		size_t uCarved;
+		size_t uIndex;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+		psArena = &oSymTable->sArena;
+		if (oSymTable->ppsTable == NULL)
+		{
+			for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+				SymTable_dropKey(oSymTable,
+					&oSymTable->asInline[uIndex]);
+			oSymTable->uBindCount = 0;
+			return;
+		}
+		if (oSymTable->uBindCount == 0) return;
+
+	/* Nodes not yet moved out of an old array are found through the
+	   chunks like the rest, so drop that array at once. */
+		free(oSymTable->ppsOldTable);
+		oSymTable->ppsOldTable = NULL;
+		oSymTable->uOldPhysLength = 0;
+		oSymTable->uOldShift = 0;
+		oSymTable->uMigrateIndex = 0;
+
+		psArena->psFreeNodes = NULL;
+		for (psChunk = psArena->psChunks; psChunk != NULL;
+			psChunk = psChunk->psNext)
+		{
+			uCarved = psChunk->uNodeCount;
+			if (psChunk == psArena->psNodeChunk)
+				uCarved -= psArena->uNodesLeft;
+			for (psNode = (struct Node *)(void *)(psChunk + 1);
+				uCarved > 0; uCarved--, psNode++)
+			{
+				if (psNode->pcKey != NULL)
+				{
+					oSymTable->ppsTable[SymTable_reduce(psNode->uHash,
+						oSymTable->uShift)] = NULL;
+					SymTable_dropKey(oSymTable, psNode);
+				}
+				SymTable_freeNode(oSymTable, psNode);
+			}
+		}
+		oSymTable->uBindCount = 0;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+		const void *pvValue, int *piAdded)
+	{
+		struct Node *psNodePut;
+		struct Node **ppsBucket;
+		size_t uHash;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+		SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+	/* Hash the key once and return the address of the existing
+	   value if oSymTable already contains pcKey... */
+		uHash = SymTable_hashKey(oSymTable, pcKey);
+		psNodePut = SymTable_find(oSymTable, pcKey, uHash);
+		if (psNodePut != NULL)
+		{
+			if (piAdded != NULL) *piAdded = 0;
+			return &psNodePut->pvValue;
+		}
+
+	/* ...if not, and a small table still has room, keep the binding
+	   inline... */
+		if (oSymTable->ppsTable == NULL)
+		{
+			if (oSymTable->uBindCount < INLINE_MAX)
+			{
+				psNodePut = &oSymTable->asInline[oSymTable->uBindCount];
+				if (! SymTable_setKey(oSymTable, psNodePut, pcKey))
+					return NULL;
+				psNodePut->pvValue = (void *)pvValue;
+				psNodePut->uHash = uHash;
+				psNodePut->psNext = NULL;
+				oSymTable->uBindCount++;
+				if (piAdded != NULL) *piAdded = 1;
+				return &psNodePut->pvValue;
+			}
+			if (! SymTable_spill(oSymTable,
+				HASH_BITS - INITIAL_LENGTH_LOG))
+				return NULL;
+		}
+
+	/* ...if not, take the node and key copy from the arena and
+	   check to ensure there is suffcient memory.
+	   Return NULL if not */
+		psNodePut = SymTable_allocNode(oSymTable);
+		if (psNodePut == NULL) return NULL;
+		if (! SymTable_setKey(oSymTable, psNodePut, pcKey))
+		{
+			SymTable_freeNode(oSymTable, psNodePut);
+			return NULL;
+		}
+
+	/* Check if table needs to be expanded, and start expanding if
+	   so. */
+		if (oSymTable->uBindCount >= oSymTable->uPhysLength)
+			SymTable_resize(oSymTable);
+
+	/* Copy over pvValue and the hash code to psPutNode, and push it
+	   onto the front of its bucket. A resize may have moved the
+	   bucket, but finding it again needs no chain walk. */
+		psNodePut->pvValue = (void *)pvValue;
+		psNodePut->uHash = uHash;
+		ppsBucket = SymTable_bucket(oSymTable, uHash);
+		psNodePut->psNext = *ppsBucket;
+		*ppsBucket = psNodePut;
+
+		/* Increment binding count and return. */
+		oSymTable->uBindCount++;
+		if (piAdded != NULL) *piAdded = 1;
+		return &psNodePut->pvValue;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+		const void *pvValue)
+	{
+		void **ppvValue;
+		void *pvOldValue;
+		int iAdded;
+
+		assert(oSymTable != NULL);
+		assert(pcKey != NULL);
+
+		ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded);
+		if (ppvValue == NULL || iAdded) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+		pvOldValue = *ppvValue;
+		*ppvValue = (void *)pvValue;
+		return pvOldValue;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void SymTable_map(SymTable_T oSymTable,
+		void (*pfApply)(const char *pcKey, void *pvValue,
+			void *pvExtra),const void *pvExtra)
+	{
+		struct Node *psCurr;
+		const struct ImageEntry *psEntry;
+		size_t uIndex;
+
+		assert(oSymTable != NULL);
+		assert(pfApply != NULL);
+
+	/* Traverse the entries of a mapped table in order. */
+		if (oSymTable->psImage != NULL)
+		{
+			psEntry = SymTable_imageEntries(oSymTable->psImage);
+			for (uIndex = 0; uIndex < oSymTable->uBindCount;
+				uIndex++, psEntry++)
+				(*pfApply)((const char *)oSymTable->psImage +
+					psEntry->uKey, (char *)oSymTable->psImage +
+					psEntry->uValue, (void *)pvExtra);
+			return;
+		}
+
+	/* Traverse the slots of a frozen table in order. */
+		if (oSymTable->psFrozen != NULL)
+		{
+			for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+				(*pfApply)(oSymTable->psFrozen->psSlots[uIndex].pcKey,
+					oSymTable->psFrozen->psSlots[uIndex].pvValue,
+					(void *)pvExtra);
+			return;
+		}
+
+	/* Traverse the inline bindings of a small table. */
+		if (oSymTable->ppsTable == NULL)
+		{
+			for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+			{
+				psCurr = &oSymTable->asInline[uIndex];
+				(*pfApply)(psCurr->pcKey, psCurr->pvValue,
+					(void *)pvExtra);
+			}
+			return;
+		}
+
+	/* Traverse all the buckets not yet moved out of the old array,
+	   if a resize is in progress. */
+		if (oSymTable->ppsOldTable != NULL)
+		{
+			for (uIndex = oSymTable->uMigrateIndex;
+				uIndex < oSymTable->uOldPhysLength; uIndex++)
+			{
+				for (psCurr = oSymTable->ppsOldTable[uIndex];
+					psCurr != NULL; psCurr = psCurr->psNext)
+					(*pfApply)(psCurr->pcKey, (void *)psCurr->pvValue,
+						(void *)pvExtra);
+			}
+		}
+
+	/* Traverse all the buckets and the traverse through each Node
+	   in each bucket and apply function pfApply to each key,
+	   value, and extra value if present */
+		for (uIndex = 0; uIndex <oSymTable->uPhysLength; uIndex++)
+		{
+			psCurr = oSymTable->ppsTable[uIndex];
+			while (psCurr != NULL)
+			{
+				(*pfApply)(psCurr->pcKey, (void *)psCurr->pvValue,
+					(void *)pvExtra);
+				psCurr = psCurr->psNext;
+			}
+		}
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void SymTable_iterBegin(SymTable_T oSymTable,
+		struct SymTable_Iter *psIter)
+	{
+		assert(oSymTable != NULL);
+		assert(psIter != NULL);
+
+	/* Finish any resize in progress, so that lookups made during the
+	   traversal do not move buckets under it. auPos[0] is the next
+	   bucket, or inline binding, to look at. */
+		SymTable_migrate(oSymTable, oSymTable->uOldPhysLength);
+		psIter->oSymTable = oSymTable;
+		psIter->pvNext = NULL;
+		psIter->auPos[0] = 0;
+		psIter->auPos[1] = 0;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	int SymTable_iterNext(struct SymTable_Iter *psIter,
+		const char **ppcKey, void **ppvValue)
+	{
+		SymTable_T oSymTable;
+		struct Node *psCurr;
+		const struct ImageEntry *psEntry;
+		size_t uSlot;
+
+		assert(psIter != NULL);
+
+		oSymTable = psIter->oSymTable;
+		psCurr = (struct Node *)psIter->pvNext;
+
+	/* A mapped table hands out its entries in turn. */
+		if (oSymTable->psImage != NULL)
+		{
+			if (psIter->auPos[0] >= oSymTable->uBindCount) return 0;
+			psEntry = SymTable_imageEntries(oSymTable->psImage) +
+				psIter->auPos[0]++;
+			if (ppcKey != NULL)
+				*ppcKey = (const char *)oSymTable->psImage +
+					psEntry->uKey;
+			if (ppvValue != NULL)
+				*ppvValue = (char *)oSymTable->psImage + psEntry->uValue;
+			return 1;
+		}
+
+	/* So does a frozen table with its slots. */
+		if (oSymTable->psFrozen != NULL)
+		{
+			if (psIter->auPos[0] >= oSymTable->uBindCount) return 0;
+			uSlot = psIter->auPos[0]++;
+			if (ppcKey != NULL)
+				*ppcKey = oSymTable->psFrozen->psSlots[uSlot].pcKey;
+			if (ppvValue != NULL)
+				*ppvValue = oSymTable->psFrozen->psSlots[uSlot].pvValue;
+			return 1;
+		}
+
+	/* At the end of a chain, move to the next bucket that is not
+	   empty. A small table hands out its inline bindings in turn. */
+		if (psCurr == NULL)
+		{
+			if (oSymTable->ppsTable == NULL)
+			{
+				if (psIter->auPos[0] >= oSymTable->uBindCount) return 0;
+				psCurr = &oSymTable->asInline[psIter->auPos[0]++];
+				if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+				if (ppvValue != NULL) *ppvValue = psCurr->pvValue;
+				return 1;
+			}
+			while (psCurr == NULL &&
+				psIter->auPos[0] < oSymTable->uPhysLength)
+				psCurr = oSymTable->ppsTable[psIter->auPos[0]++];
+			if (psCurr == NULL) return 0;
+		}
+
+		psIter->pvNext = psCurr->psNext;
+		if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+		if (ppvValue != NULL) *ppvValue = psCurr->pvValue;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+	void SymTable_compact(SymTable_T oSymTable)
+	{
+		size_t uLength = (size_t)1 << INITIAL_LENGTH_LOG;
+		size_t uShift = HASH_BITS - INITIAL_LENGTH_LOG;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+		if (oSymTable->ppsTable == NULL) return;
+		SymTable_migrate(oSymTable, oSymTable->uOldPhysLength);
+
+	/* Find the smallest array that is at most half full, the load a
+	   table has just after it grows. */
+		while (uLength / 2 < oSymTable->uBindCount)
+		{
+			uLength *= 2;
+			uShift--;
+		}
+		if (uLength >= oSymTable->uPhysLength) return;
+
+	/* Keep the current array if there is insufficient memory. */
+		(void)SymTable_relink(oSymTable, uShift);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Run chunks of the pool of psWorker, first from psWorker's own
+   range, then stolen from the end of the other workers' ranges, until
+   no range has any left. A thief takes the later half of its
+   victim's range, so uneven chunks even out in few steals. Return
+   NULL. */
+
+	static void *SymTable_work(void *pvWorker)
+	{
+		struct Worker *psWorker = (struct Worker *)pvWorker;
+		struct Worker *psVictim;
+		struct Pool *psPool;
+		size_t uChunk;
+		size_t uFirst;
+		size_t uLast;
+		size_t uStep;
+		int iFound;
+
+		assert(psWorker != NULL);
+
+		psPool = psWorker->psPool;
+		for (;;)
+		{
+	/* Take the next chunk of this worker's own range. */
+			pthread_mutex_lock(&psWorker->sLock);
+			iFound = psWorker->uNext < psWorker->uEnd;
+			uChunk = psWorker->uNext;
+			if (iFound) psWorker->uNext++;
+			pthread_mutex_unlock(&psWorker->sLock);
+			if (iFound)
+			{
+				uFirst = uChunk * psPool->uChunk;
+				uLast = uFirst + psPool->uChunk;
+				if (uLast > psPool->uTasks) uLast = psPool->uTasks;
+				(*psPool->pfRun)(psPool->pvJob, psWorker->uThread,
+					uFirst, uLast);
+				continue;
+			}
+
+	/* Steal from the next worker that has chunks left. */
+			for (uStep = 1; uStep < psPool->uWorkers && ! iFound; uStep++)
+			{
+				psVictim = &psPool->psWorkers[(psWorker->uThread + uStep) %
+					psPool->uWorkers];
+				pthread_mutex_lock(&psVictim->sLock);
+				if (psVictim->uNext < psVictim->uEnd)
+				{
+					uFirst = psVictim->uNext +
+						(psVictim->uEnd - psVictim->uNext) / 2;
+					uLast = psVictim->uEnd;
+					psVictim->uEnd = uFirst;
+					iFound = 1;
+				}
+				pthread_mutex_unlock(&psVictim->sLock);
+			}
+			if (! iFound) return NULL;
+			pthread_mutex_lock(&psWorker->sLock);
+			psWorker->uNext = uFirst;
+			psWorker->uEnd = uLast;
+			pthread_mutex_unlock(&psWorker->sLock);
+		}
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Run tasks 0 to uTasks - 1 of pvJob on up to uThreads threads, the
+   calling thread being thread 0, by calling (*pfRun)(pvJob, uThread,
+   uFirst, uLast) for consecutive chunks of tasks. Each thread starts
+   with an equal share of the chunks and steals when it runs out.
+   Return once every task has run. If a thread or the workers cannot
+   be created, the threads that exist run its share. */
+
+	static void SymTable_runParallel(size_t uTasks, size_t uThreads,
+		void (*pfRun)(void *pvJob, size_t uThread, size_t uFirst,
+			size_t uLast), void *pvJob)
+	{
+		struct Pool sPool;
+		struct Worker *psWorker;
+		void *pvWorkers;
+		size_t uChunks;
+		size_t uThread;
+
+		assert(uThreads > 0);
+		assert(pfRun != NULL);
+
+		if (uTasks == 0) return;
+
+	/* No more threads than chunks. */
+		sPool.pfRun = pfRun;
+		sPool.pvJob = pvJob;
+		sPool.uTasks = uTasks;
+		sPool.uChunk = PARALLEL_CHUNK;
+		uChunks = (uTasks - 1) / PARALLEL_CHUNK + 1;
+		sPool.uWorkers = uThreads < uChunks ? uThreads : uChunks;
+		if (sPool.uWorkers == 1 ||
+			posix_memalign(&pvWorkers, CACHE_LINE,
+				sPool.uWorkers * sizeof(struct Worker)) != 0)
+		{
+			(*pfRun)(pvJob, 0, 0, uTasks);
+			return;
+		}
+		sPool.psWorkers = (struct Worker *)pvWorkers;
+
+		for (uThread = 0; uThread < sPool.uWorkers; uThread++)
+		{
+			psWorker = &sPool.psWorkers[uThread];
+			pthread_mutex_init(&psWorker->sLock, NULL);
+			psWorker->uNext = uChunks * uThread / sPool.uWorkers;
+			psWorker->uEnd = uChunks * (uThread + 1) / sPool.uWorkers;
+			psWorker->uThread = uThread;
+			psWorker->psPool = &sPool;
+			psWorker->iStarted = 0;
+		}
+		for (uThread = 1; uThread < sPool.uWorkers; uThread++)
+		{
+			psWorker = &sPool.psWorkers[uThread];
+			psWorker->iStarted = pthread_create(&psWorker->iThread, NULL,
+				SymTable_work, psWorker) == 0;
+		}
+		SymTable_work(&sPool.psWorkers[0]);
+
+	/* A running thread may still try to steal from any worker, so
+	   destroy the locks only once every thread has finished. */
+		for (uThread = 1; uThread < sPool.uWorkers; uThread++)
+			if (sPool.psWorkers[uThread].iStarted)
+				pthread_join(sPool.psWorkers[uThread].iThread, NULL);
+		for (uThread = 0; uThread < sPool.uWorkers; uThread++)
+			pthread_mutex_destroy(&sPool.psWorkers[uThread].sLock);
+		free(pvWorkers);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Apply the function of the MapJob that pvJob points to, with the
+   extra argument of thread uThread, to every binding in buckets
+   uFirst to uLast - 1. The buckets not yet moved out of an old array
+   are numbered after those of the current array. */
+
+	static void SymTable_mapRange(void *pvJob, size_t uThread,
+		size_t uFirst, size_t uLast)
+	{
+		struct MapJob *psJob = (struct MapJob *)pvJob;
+		SymTable_T oSymTable;
+		struct Node *psCurr;
+		void *pvExtra;
+		size_t uIndex;
+
+		assert(psJob != NULL);
+
+		oSymTable = psJob->oSymTable;
+		pvExtra = psJob->ppvExtras[uThread];
+		for (uIndex = uFirst; uIndex < uLast; uIndex++)
+		{
+			if (uIndex < oSymTable->uPhysLength)
+				psCurr = oSymTable->ppsTable[uIndex];
+			else
+				psCurr = oSymTable->ppsOldTable[oSymTable->uMigrateIndex +
+					(uIndex - oSymTable->uPhysLength)];
+			for ( ; psCurr != NULL; psCurr = psCurr->psNext)
+				(*psJob->pfApply)(psCurr->pcKey, psCurr->pvValue, pvExtra);
+		}
+	}
 
 /*-------------------------------------------------------------------*/
 
-/* SymTable is a structure to maintain a counter for the number of 
-   bindings in a Symbol Table and a pointer to the "head" Node. */
-
-	struct SymTable 
+	void SymTable_mapParallel(SymTable_T oSymTable,
+		void (*pfApply)(const char *pcKey, void *pvValue,
+			void *pvExtra),
+		void **ppvExtras, size_t uThreads,
+		void (*pfReduce)(void *pvInto, void *pvFrom))
 	{
+		struct MapJob sJob;
+		struct Node *psCurr;
+		size_t uIndex;
+		size_t uBuckets = 0;
 
-	/* Count of the binding elements contained in the hash array from 
-	   user's point of view. */
-		size_t uBindCount;
-
-	/* Count of elements in the hash array that undrlies the
-	   SymTable. */
-		size_t uPhysLength;
-
-	/* Variable to store which size in the sequence we are at. */
-		size_t uSequenceIndex;
+		assert(oSymTable != NULL);
+		assert(pfApply != NULL);
+		assert(ppvExtras != NULL);
+		assert(uThreads > 0);
+
+		sJob.oSymTable = oSymTable;
+		sJob.pfApply = pfApply;
+		sJob.ppvExtras = ppvExtras;
+
+	/* A mapped or frozen table's bindings are read in place, and a
+	   small table's inline bindings are too few to share out. */
+		if (oSymTable->psImage != NULL || oSymTable->psFrozen != NULL)
+			SymTable_map(oSymTable, pfApply, ppvExtras[0]);
+		else if (oSymTable->ppsTable == NULL)
+		{
+			for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+			{
+				psCurr = &oSymTable->asInline[uIndex];
+				(*pfApply)(psCurr->pcKey, psCurr->pvValue, ppvExtras[0]);
+			}
+		}
+		else
+		{
+	/* Share out the current array's buckets and any old buckets not
+	   yet moved. */
+			uBuckets = oSymTable->uPhysLength;
+			if (oSymTable->ppsOldTable != NULL)
+				uBuckets += oSymTable->uOldPhysLength -
+					oSymTable->uMigrateIndex;
+			SymTable_runParallel(uBuckets, uThreads, SymTable_mapRange,
+				&sJob);
+		}
 
-	/* The array/table that underlies the SymTable */
-		struct Node **ppsTable;
-	};
+	/* Fold every thread's result into the first. */
+		if (pfReduce != NULL)
+			for (uIndex = 1; uIndex < uThreads; uIndex++)
+				(*pfReduce)(ppvExtras[0], ppvExtras[uIndex]);
+	}
 
 /*-------------------------------------------------------------------*/
 
-/* Node is a structure that stores and associates a char Key with 
-   a void value and also maintains a pointer to the next node. */
+/* Hash keys uFirst to uLast - 1 of the BulkJob that pvJob points to,
+   and record their sizes. Each thread writes only its own range. */
 
-	struct Node
+	static void SymTable_hashRange(void *pvJob, size_t uThread,
+		size_t uFirst, size_t uLast)
 	{
-	/* Char pointer to hold the Key. */
-		const char *pcKey;
+		struct BulkJob *psJob = (struct BulkJob *)pvJob;
+		struct BulkKey *psKey;
+		size_t uIndex;
 
-	/* A void pointer to hold the Value. */
-		const void *pvValue;
+		assert(psJob != NULL);
+		(void)uThread;
 
-	/* Another Node to hold a pointer to the next Node. */
-		struct Node *psNext;
-	};
+		for (uIndex = uFirst; uIndex < uLast; uIndex++)
+		{
+			assert(psJob->ppcKeys[uIndex] != NULL);
+			psKey = &psJob->psKeys[uIndex];
+			psKey->uHash = SymTable_hashKey(psJob->oSymTable,
+				psJob->ppcKeys[uIndex]);
+			psKey->uSize = strlen(psJob->ppcKeys[uIndex]) + 1;
+			psKey->pcLongCopy = NULL;
+		}
+	}
 
 /*-------------------------------------------------------------------*/
 
-	SymTable_T SymTable_new(void)
-	{
-		SymTable_T oSymTable;
+/* Put the uCount bindings of a SymTable_putMany call into oSymTable,
+   which keeps them inline, one at a time. If one fails, take out the
+   ones added before it. */
 
-	/* Allocate memory and return NULL if it is unsufficient. */
-		size_t uSize = sizeof(struct SymTable);
-		oSymTable = (SymTable_T)malloc(uSize);
-		if (oSymTable == NULL) return NULL;
+	static int SymTable_putSmall(SymTable_T oSymTable,
+		const char *const *ppcKeys, void *const *ppvValues,
+		size_t uCount, int *piAdded)
+	{
+		int aiAdded[INLINE_MAX];
+		size_t uIndex;
 
-	/* Initiate SymTable variables. */
-		oSymTable->uBindCount = 0;
-		oSymTable->uSequenceIndex = 0;
-		oSymTable->uPhysLength = uSequence[oSymTable->uSequenceIndex];
-		oSymTable->ppsTable = 
-		(struct Node**)calloc(oSymTable->uPhysLength, 
-			sizeof(struct Node*));
+		assert(oSymTable != NULL);
+		assert(uCount <= INLINE_MAX);
 
-	/* Return NULL and free mem if insufficient energy for ppsArray */
-		if (oSymTable->ppsTable == NULL)
+		for (uIndex = 0; uIndex < uCount; uIndex++)
 		{
-			free(oSymTable);
-			return NULL;
+			if (SymTable_getOrPut(oSymTable, ppcKeys[uIndex],
+				ppvValues[uIndex], &aiAdded[uIndex]) == NULL)
+			{
+				while (uIndex-- > 0)
+					if (aiAdded[uIndex])
+						(void)SymTable_remove(oSymTable, ppcKeys[uIndex]);
+				return 0;
+			}
 		}
 
-		return oSymTable;
+		if (piAdded != NULL)
+			for (uIndex = 0; uIndex < uCount; uIndex++)
+				piAdded[uIndex] = aiAdded[uIndex];
+		return 1;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	void SymTable_free(SymTable_T oSymTable)
+/* Everything that can fail happens before the first binding is
+   added: the bucket array is sized for every key, the keys are
+   hashed and measured (on several threads), long keys are copied,
+   and one chunk is allocated with a node for every key followed by
+   room for every short key copy. The bindings are then linked in one
+   serial pass, with no resize and no allocation. Nodes and key room
+   that duplicates leave unused go back to the arena. */
+
+	int SymTable_putMany(SymTable_T oSymTable, const char *const *ppcKeys,
+		void *const *ppvValues, size_t uCount, size_t uThreads,
+		int *piAdded)
 	{
-		struct Node *psCurr;
-		struct Node *psTemp;
+		struct BulkJob sJob;
+		struct BulkKey *psKeys;
+		struct Arena *psArena;
+		struct Node *psNodes;
+		struct Node *psNode;
+		struct Node **ppsBucket;
+		char *pcKeyNext;
+		char *pcKeyEnd;
+		size_t uNodesUsed = 0;
+		size_t uKeyBytes = 0;
 		size_t uIndex;
+		int iSuccessful = 1;
 
-		assert(oSymTable != NULL); 
+		assert(oSymTable != NULL);
+		assert(ppcKeys != NULL);
+		assert(ppvValues != NULL);
+		assert(uThreads > 0);
+		assert(oSymTable->psImage == NULL);
+		assert(oSymTable->psFrozen == NULL);
+
+		if (uCount == 0) return 1;
+		if (uCount > (size_t)-1 - oSymTable->uBindCount ||
+			! SymTable_reserveBuckets(oSymTable,
+				oSymTable->uBindCount + uCount))
+			return 0;
+		if (oSymTable->ppsTable == NULL)
+			return SymTable_putSmall(oSymTable, ppcKeys, ppvValues, uCount,
+				piAdded);
+
+	/* Hash and measure every key. */
+		if (uCount > (size_t)-1 / sizeof(struct BulkKey)) return 0;
+		psKeys = (struct BulkKey *)malloc(uCount * sizeof(struct BulkKey));
+		if (psKeys == NULL) return 0;
+		sJob.oSymTable = oSymTable;
+		sJob.ppcKeys = ppcKeys;
+		sJob.psKeys = psKeys;
+		SymTable_runParallel(uCount, uThreads, SymTable_hashRange, &sJob);
+
+	/* Copy the long keys, and add up the room the short ones need.
+	   Keys that fit in their nodes, or that are borrowed, need none. */
+		for (uIndex = 0; uIndex < uCount && iSuccessful; uIndex++)
+		{
+			if (oSymTable->iBorrowKeys ||
+				psKeys[uIndex].uSize <= KEY_INLINE) continue;
+			if ((psKeys[uIndex].uSize - 1) / KEY_GRANULE < KEY_CLASS_COUNT)
+			{
+				uKeyBytes += ((psKeys[uIndex].uSize - 1) / KEY_GRANULE + 1) *
+					KEY_GRANULE;
+				iSuccessful = uKeyBytes <= (size_t)-1 -
+					KEY_CLASS_COUNT * KEY_GRANULE;
+				continue;
+			}
+			psKeys[uIndex].pcLongCopy = SymTable_allocKey(oSymTable,
+				psKeys[uIndex].uSize);
+			if (psKeys[uIndex].pcLongCopy == NULL)
+				iSuccessful = 0;
+			else
+				memcpy(psKeys[uIndex].pcLongCopy, ppcKeys[uIndex],
+					psKeys[uIndex].uSize);
+		}
 
-	/* Traverse hash array and free the memory associated with 
-	   each Key and Node. */
-		for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+	/* Take one chunk for all the nodes and short key copies. */
+		psNodes = NULL;
+		if (iSuccessful && uCount <= ((size_t)-1 - sizeof(struct Chunk) -
+			uKeyBytes) / sizeof(struct Node))
+			psNodes = (struct Node *)SymTable_allocChunk(oSymTable,
+				uCount * sizeof(struct Node) + uKeyBytes, uCount);
+		if (psNodes == NULL)
 		{
-			psCurr = oSymTable->ppsTable[uIndex];
-			while (psCurr != NULL)
+			for (uIndex = 0; uIndex < uCount; uIndex++)
+				if (psKeys[uIndex].pcLongCopy != NULL)
+					SymTable_freeKey(oSymTable, psKeys[uIndex].pcLongCopy);
+			free(psKeys);
+			return 0;
+		}
+		psArena = &oSymTable->sArena;
+		psArena->uNodeBytes += uCount * sizeof(struct Node);
+		psArena->uKeyBytes += uKeyBytes;
+		pcKeyNext = (char *)(psNodes + uCount);
+		pcKeyEnd = pcKeyNext + uKeyBytes;
+
+	/* Link each new binding onto the front of its bucket, in order, so
+	   that a key seen earlier in ppcKeys wins. */
+		for (uIndex = 0; uIndex < uCount; uIndex++)
+		{
+			ppsBucket = &oSymTable->ppsTable[SymTable_reduce(
+				psKeys[uIndex].uHash, oSymTable->uShift)];
+			for (psNode = *ppsBucket; psNode != NULL; psNode = psNode->psNext)
+				if (psNode->uHash == psKeys[uIndex].uHash &&
+					strcmp(ppcKeys[uIndex], psNode->pcKey) == 0)
+					break;
+			if (piAdded != NULL) piAdded[uIndex] = psNode == NULL;
+			if (psNode != NULL)
 			{
-				psTemp = psCurr->psNext;
-				free((char *)psCurr->pcKey);
-				free(psCurr);
-				psCurr = psTemp;
+				if (psKeys[uIndex].pcLongCopy != NULL)
+					SymTable_freeKey(oSymTable, psKeys[uIndex].pcLongCopy);
+				continue;
+			}
+
+			psNode = &psNodes[uNodesUsed++];
+			if (oSymTable->iBorrowKeys)
+				psNode->pcKey = ppcKeys[uIndex];
+			else if (psKeys[uIndex].uSize <= KEY_INLINE)
+			{
+				memcpy(psNode->acKey, ppcKeys[uIndex],
+					psKeys[uIndex].uSize);
+				psNode->pcKey = psNode->acKey;
+			}
+			else if (psKeys[uIndex].pcLongCopy != NULL)
+				psNode->pcKey = psKeys[uIndex].pcLongCopy;
+			else
+			{
+				memcpy(pcKeyNext, ppcKeys[uIndex], psKeys[uIndex].uSize);
+				psNode->pcKey = pcKeyNext;
+				pcKeyNext += ((psKeys[uIndex].uSize - 1) / KEY_GRANULE + 1) *
+					KEY_GRANULE;
 			}
+			psNode->pvValue = ppvValues[uIndex];
+			psNode->uHash = psKeys[uIndex].uHash;
+			psNode->psNext = *ppsBucket;
+			*ppsBucket = psNode;
+			oSymTable->uBindCount++;
 		}
-		free(oSymTable->ppsTable);
-		free(oSymTable);
+
+	/* Hand the nodes and key room of duplicates to the arena. */
+		while (uNodesUsed < uCount)
+			SymTable_freeNode(oSymTable, &psNodes[uNodesUsed++]);
+		if ((size_t)(pcKeyEnd - pcKeyNext) > psArena->uKeyBytesLeft)
+		{
+			psArena->pcKeyNext = pcKeyNext;
+			psArena->uKeyBytesLeft = (size_t)(pcKeyEnd - pcKeyNext);
+		}
+
+		free(psKeys);
+		return 1;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	size_t SymTable_getLength(SymTable_T oSymTable)
+/* Return the index of the first entry of each bucket of psImage,
+   which follows its header. */
+
+	static const size_t *SymTable_imageStarts(
+		const struct Image *psImage)
 	{
-		assert(oSymTable != NULL);
+		assert(psImage != NULL);
 
-	/* Return length count from SymTable structure. */
-		return oSymTable->uBindCount;
+		return (const size_t *)(const void *)(psImage + 1);
 	}
 
 /*-------------------------------------------------------------------*/
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
+/* Return the entries of psImage, which follow its bucket starts. */
 
-	static size_t SymTable_hash(const char *pcKey, size_t uPhysLength)
+	static const struct ImageEntry *SymTable_imageEntries(
+		const struct Image *psImage)
 	{
-		const size_t HASH_MULTIPLIER = 65599;
-		size_t u;
-		size_t uHash = 0;
+		assert(psImage != NULL);
 
-		assert(pcKey != NULL);
+		return (const struct ImageEntry *)(const void *)
+			(SymTable_imageStarts(psImage) +
+			((size_t)1 << (HASH_BITS - psImage->uShift)) + 1);
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the entry of mapped oSymTable that holds pcKey, or NULL if
+   there is none. The entries of a bucket are contiguous, so the
+   search reads one run of the image and compares a key only when
+   its hash code matches. */
 
-		for (u = 0; pcKey[u] != '\0'; u++)
-			uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+	static const struct ImageEntry *SymTable_findMapped(
+		SymTable_T oSymTable, const char *pcKey)
+	{
+		const struct Image *psImage;
+		const struct ImageEntry *psEntry;
+		const struct ImageEntry *psEnd;
+		const size_t *puStarts;
+		size_t uHash;
+		size_t uBucket;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->psImage != NULL);
+		assert(pcKey != NULL);
 
-		return uHash % uPhysLength;
+		psImage = oSymTable->psImage;
+		uHash = SymTable_hash(pcKey, 0);
+		uBucket = SymTable_reduce(uHash, psImage->uShift);
+		puStarts = SymTable_imageStarts(psImage);
+		psEntry = SymTable_imageEntries(psImage);
+		psEnd = psEntry + puStarts[uBucket + 1];
+		for (psEntry += puStarts[uBucket]; psEntry != psEnd; psEntry++)
+		{
+			if (psEntry->uHash == uHash && strcmp(pcKey,
+				(const char *)psImage + psEntry->uKey) == 0)
+				return psEntry;
+		}
+		return NULL;
 	}
 
 /*-------------------------------------------------------------------*/
 
-/* Take an oSymTable object and copies the elments over into an 
-   expanded array that is the size of the next number in the 
-   predetermined sequence */
+/* Make the block *ppcHeap, which has room for *puRoom bytes, big
+   enough for uNeeded bytes, at least doubling it if it grows. Return
+   1, or 0 with the block unchanged if insufficient memory is
+   available. */
 
-	static void SymTable_resize(SymTable_T oSymTable)
+	static int SymTable_growHeap(char **ppcHeap, size_t *puRoom,
+		size_t uNeeded)
 	{
+		char *pcHeap;
+		size_t uRoom;
+
+		assert(ppcHeap != NULL);
+		assert(puRoom != NULL);
+
+		if (uNeeded <= *puRoom) return 1;
+		uRoom = *puRoom * 2;
+		if (uRoom < IMAGE_HEAP_MIN) uRoom = IMAGE_HEAP_MIN;
+		if (uRoom < uNeeded) uRoom = uNeeded;
+		pcHeap = (char *)realloc(*ppcHeap, uRoom);
+		if (pcHeap == NULL) return 0;
+		*ppcHeap = pcHeap;
+		*puRoom = uRoom;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Write an image of oSymTable to the file pcPath. The image is built
+   in memory in two parts: the header, bucket starts and entries,
+   whose size is known from the number of bindings, and the keys and
+   values that follow them, which grow as they are serialized. Its
+   buckets are indexed with SymTable_hash whatever the table's own
+   hash function is, so that SymTable_openMapped needs no client
+   function. */
+
+	int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+		size_t (*pfSerialize)(const char *pcKey, void *pvValue,
+			void *pvBuffer, size_t uRoom, void *pvExtra),
+		const void *pvExtra)
+	{
+		struct SymTable_Iter sIter;
+		struct Image *psImage;
+		struct ImageEntry *psEntries;
+		struct ImageEntry *psEntry;
+		size_t *puStarts;
+		size_t *puHashes;
+		char *pcHeap = NULL;
+		size_t uHeapLength = 0;
+		size_t uHeapRoom = 0;
+		size_t uBuckets = 2;
+		size_t uShift = HASH_BITS - 1;
+		size_t uFixed;
 		size_t uIndex;
-		size_t uHashedIndex;
-		size_t uSequenceIndex;
-		struct Node *psCurr;
-		struct Node *psTemp;
-		struct Node **ppsExpandedTable;
+		size_t uBucket;
+		size_t uSize;
+		const char *pcKey;
+		void *pvValue;
+		FILE *psFile;
+		char *pcTemp;
+		int iSuccessful = 1;
 
 		assert(oSymTable != NULL);
+		assert(pcPath != NULL);
+		assert(pfSerialize != NULL);
 
-		/* Increment index of size sequence and allocate memory 
-		   for the exapnded array. */
-		oSymTable->uSequenceIndex++;
-		uSequenceIndex = oSymTable->uSequenceIndex;
-		ppsExpandedTable = 
-		(struct Node**)calloc(uSequence[uSequenceIndex],
-			sizeof(struct Node*));
-
-		/* Return if there is insufficient memory. 
-		   I just return instead of returning NULL because this is a
-		   static function. */
-		if (ppsExpandedTable == NULL) return;
+	/* Give the image one bucket per binding, as a put would, and
+	   start the keys and values on an IMAGE_ALIGN boundary. */
+		while (uBuckets < oSymTable->uBindCount)
+		{
+			uBuckets *= 2;
+			uShift--;
+		}
+		uFixed = sizeof(struct Image) + (uBuckets + 1) * sizeof(size_t) +
+			oSymTable->uBindCount * sizeof(struct ImageEntry);
+		uFixed = (uFixed + IMAGE_ALIGN - 1) / IMAGE_ALIGN * IMAGE_ALIGN;
+
+		psImage = (struct Image *)calloc(uFixed, 1);
+		puHashes = (size_t *)malloc((oSymTable->uBindCount + 1) *
+			sizeof(size_t));
+		if (psImage == NULL || puHashes == NULL ||
+			! SymTable_growHeap(&pcHeap, &uHeapRoom, IMAGE_HEAP_MIN))
+		{
+			free(psImage);
+			free(puHashes);
+			return 0;
+		}
+		puStarts = (size_t *)(void *)(psImage + 1);
+		psEntries = (struct ImageEntry *)(void *)
+			(puStarts + uBuckets + 1);
+
+	/* Count the bindings of each bucket into the start of the next,
+	   then sum the counts so that each bucket's start is right. */
+		SymTable_iterBegin(oSymTable, &sIter);
+		for (uIndex = 0; SymTable_iterNext(&sIter, &pcKey, NULL);
+			uIndex++)
+		{
+			puHashes[uIndex] = SymTable_hash(pcKey, 0);
+			puStarts[SymTable_reduce(puHashes[uIndex], uShift) + 1]++;
+		}
+		for (uBucket = 0; uBucket < uBuckets; uBucket++)
+			puStarts[uBucket + 1] += puStarts[uBucket];
+
+	/* Visit the bindings in the same order again, and put each one's
+	   entry at the next free place in its bucket, its key after the
+	   keys and values so far, and its value after that. Filling a
+	   bucket moves its start up to the next bucket's. */
+		SymTable_iterBegin(oSymTable, &sIter);
+		for (uIndex = 0; iSuccessful &&
+			SymTable_iterNext(&sIter, &pcKey, &pvValue); uIndex++)
+		{
+			uBucket = SymTable_reduce(puHashes[uIndex], uShift);
+			psEntry = &psEntries[puStarts[uBucket]++];
+			psEntry->uHash = puHashes[uIndex];
 
-		/* Traverse through old array and hash each key into a bucket
-		   in the new expanded array. */
-		for (uIndex = 0; uIndex != oSymTable->uPhysLength; uIndex++)
+			uSize = strlen(pcKey) + 1;
+			if (! SymTable_growHeap(&pcHeap, &uHeapRoom,
+				uHeapLength + uSize + IMAGE_ALIGN))
+			{
+				iSuccessful = 0;
+				break;
+			}
+			memcpy(pcHeap + uHeapLength, pcKey, uSize);
+			psEntry->uKey = uFixed + uHeapLength;
+			uHeapLength += uSize;
+			while (uHeapLength % IMAGE_ALIGN != 0)
+				pcHeap[uHeapLength++] = '\0';
+
+	/* A value that does not fit the room left is serialized again
+	   once the block has grown. */
+			uSize = (*pfSerialize)(pcKey, pvValue, pcHeap + uHeapLength,
+				uHeapRoom - uHeapLength, (void *)pvExtra);
+			if (uSize > uHeapRoom - uHeapLength)
+			{
+				if (! SymTable_growHeap(&pcHeap, &uHeapRoom,
+					uHeapLength + uSize))
+				{
+					iSuccessful = 0;
+					break;
+				}
+				uSize = (*pfSerialize)(pcKey, pvValue,
+					pcHeap + uHeapLength, uHeapRoom - uHeapLength,
+					(void *)pvExtra);
+				assert(uSize <= uHeapRoom - uHeapLength);
+			}
+			psEntry->uValue = uFixed + uHeapLength;
+			uHeapLength += uSize;
+		}
+		for (uBucket = uBuckets; uBucket > 0; uBucket--)
+			puStarts[uBucket] = puStarts[uBucket - 1];
+		puStarts[0] = 0;
+
+		psImage->uMagic = IMAGE_MAGIC;
+		psImage->uWordSize = sizeof(size_t);
+		psImage->uBytes = uFixed + uHeapLength;
+		psImage->uBindings = oSymTable->uBindCount;
+		psImage->uShift = uShift;
+
+	/* Write both parts to a file beside pcPath and rename it over
+	   pcPath only once it is complete, so that a failed save leaves
+	   the last good image in place, and a table that maps it sees
+	   either the old image or the new one, never a truncated one. */
+		pcTemp = NULL;
+		if (iSuccessful)
 		{
-			for (psCurr = oSymTable->ppsTable[uIndex];
-				psCurr != NULL; psCurr = psTemp)
+			pcTemp = (char *)malloc(strlen(pcPath) + sizeof(".tmp"));
+			if (pcTemp == NULL) iSuccessful = 0;
+		}
+		if (iSuccessful)
+		{
+			strcpy(pcTemp, pcPath);
+			strcat(pcTemp, ".tmp");
+			psFile = fopen(pcTemp, "wb");
+			if (psFile == NULL) iSuccessful = 0;
+			else
 			{
-				psTemp = psCurr->psNext;
-				uHashedIndex = SymTable_hash(psCurr->pcKey, 
-					uSequence[uSequenceIndex]);
-				psCurr->psNext = ppsExpandedTable[uHashedIndex];
-				ppsExpandedTable[uHashedIndex] = psCurr;
+				if (fwrite(psImage, 1, uFixed, psFile) != uFixed ||
+					fwrite(pcHeap, 1, uHeapLength, psFile) !=
+					uHeapLength || fflush(psFile) != 0 ||
+					fsync(fileno(psFile)) != 0)
+					iSuccessful = 0;
+				if (fclose(psFile) != 0) iSuccessful = 0;
+				if (iSuccessful && rename(pcTemp, pcPath) != 0)
+					iSuccessful = 0;
+				if (! iSuccessful) remove(pcTemp);
 			}
 		}
 
-		/* Free the old Array and update the Array pointer and 
-		   PhysLength variable in oSymTable */
-		free(oSymTable->ppsTable);
-		oSymTable->ppsTable = ppsExpandedTable;
-		oSymTable->uPhysLength = 
-		uSequence[uSequenceIndex];
+		free(pcTemp);
+		free(psImage);
+		free(puHashes);
+		free(pcHeap);
+		return iSuccessful;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
-		const void *pvValue)
-	{
-		struct Node *psNodePut;
-		size_t uHashedIndex;
+/* Return 1 if the uBytes bytes at psImage start with the header of
+   an image that SymTable_save wrote on a machine with the same word
+   size and byte order, whose bucket starts and entries fit in those
+   bytes, or 0 otherwise. The entries themselves are trusted. */
 
-		assert(oSymTable != NULL);
-		assert(pcKey != NULL);
+	static int SymTable_checkImage(const struct Image *psImage,
+		size_t uBytes)
+	{
+		size_t uBuckets;
+
+		assert(psImage != NULL);
+
+		if (psImage->uMagic != IMAGE_MAGIC ||
+			psImage->uWordSize != sizeof(size_t) ||
+			psImage->uBytes != uBytes ||
+			psImage->uShift == 0 || psImage->uShift >= HASH_BITS)
+			return 0;
+
+	/* Check each part's size against what remains, so that no sum
+	   can overflow. */
+		uBytes -= sizeof(struct Image);
+		uBuckets = (size_t)1 << (HASH_BITS - psImage->uShift);
+		if (uBuckets >= uBytes / sizeof(size_t)) return 0;
+		uBytes -= (uBuckets + 1) * sizeof(size_t);
+		if (psImage->uBindings > uBytes / sizeof(struct ImageEntry))
+			return 0;
+		return SymTable_imageStarts(psImage)[0] == 0 &&
+			SymTable_imageStarts(psImage)[uBuckets] ==
+				psImage->uBindings;
+	}
 
-	/* Return 0 if oSymTable already contains pcKey... */
-		if (SymTable_contains(oSymTable, pcKey) == 1) return 0;
+/*-------------------------------------------------------------------*/
 
-	/* Check if table needs to be expanded, and expand if so 
-	   while ensuring that max expansion has not been 
-	   reached (comment out for non-expanding) */
-		if (oSymTable->uBindCount == oSymTable->uPhysLength)
+	SymTable_T SymTable_openMapped(const char *pcPath)
+	{
+		SymTable_T oSymTable;
+		struct stat sStat;
+		void *pvImage;
+		size_t uBytes;
+		int iFd;
+
+		assert(pcPath != NULL);
+
+	/* Map the whole file read-only. The mapping outlives the file
+	   descriptor. */
+		iFd = open(pcPath, O_RDONLY);
+		if (iFd < 0) return NULL;
+		if (fstat(iFd, &sStat) != 0 ||
+			sStat.st_size < (off_t)sizeof(struct Image))
 		{
-			if (oSymTable->uPhysLength != uSequenceMax)
-			{
-				SymTable_resize(oSymTable);
-			}
-		} 
-
-	/* ...if not, allocate memory for the node and key in copies
-	   and check to ensure there is suffcient memory. 
-	   Return 0 if not */
-		psNodePut = (struct Node*)malloc(sizeof(struct Node));
-		if (psNodePut == NULL) return 0;
-		psNodePut->pcKey = (char*)malloc(strlen(pcKey) + 1);
-		if (psNodePut->pcKey == NULL) return 0;
-
-	/* Copy over pvValue to psPutNode. */
-		psNodePut->pvValue = pvValue;
-
-	/* Get a hash code for the new Key, then copy pcKey and 
-	   psNExt to  psPutNode. */
-		uHashedIndex = SymTable_hash(pcKey, oSymTable->uPhysLength);
-		strcpy((char*)psNodePut->pcKey, pcKey);
-		psNodePut->psNext = oSymTable->ppsTable[uHashedIndex];
-		oSymTable->ppsTable[uHashedIndex] = psNodePut;
+			close(iFd);
+			return NULL;
+		}
+		uBytes = (size_t)sStat.st_size;
+		pvImage = mmap(NULL, uBytes, PROT_READ, MAP_PRIVATE, iFd, 0);
+		close(iFd);
+		if (pvImage == MAP_FAILED) return NULL;
 
-		/* Increment binding count and return. */
-		oSymTable->uBindCount++;
-		return 1;
+		if (! SymTable_checkImage((const struct Image *)pvImage, uBytes))
+		{
+			munmap(pvImage, uBytes);
+			return NULL;
+		}
+		oSymTable = SymTable_new();
+		if (oSymTable == NULL)
+		{
+			munmap(pvImage, uBytes);
+			return NULL;
+		}
+		oSymTable->psImage = (const struct Image *)pvImage;
+		oSymTable->uBindCount = oSymTable->psImage->uBindings;
+		return oSymTable;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
-		const void *pvValue)
+/* Fill in *psStats for mapped oSymTable. Its buckets are runs of
+   entries, its table is the header and bucket starts, its nodes are
+   the entries, and its keys are the keys and values. */
+
+	static void SymTable_getMappedStats(SymTable_T oSymTable,
+		struct SymTable_Stats *psStats)
 	{
-		struct Node *psCurr;
-		const void *pvOldValue;
-		size_t uHashedIndex;
+		const struct Image *psImage;
+		const size_t *puStarts;
+		size_t uBuckets;
+		size_t uBucket;
+		size_t uLength;
+		size_t uFixed;
 
-		assert (oSymTable != NULL);
-		assert (pcKey != NULL);
+		assert(oSymTable != NULL);
+		assert(oSymTable->psImage != NULL);
+		assert(psStats != NULL);
 
-		uHashedIndex = SymTable_hash(pcKey, oSymTable->uPhysLength);
-		psCurr = oSymTable->ppsTable[uHashedIndex];
+		psImage = oSymTable->psImage;
+		puStarts = SymTable_imageStarts(psImage);
+		uBuckets = (size_t)1 << (HASH_BITS - psImage->uShift);
 
-	/* Traverse nodes at hash location until finding the key that 
-	   matches pcKey. */
-		while (psCurr != NULL)
+	/* The nth entry of a bucket is found with n comparisons. */
+		for (uBucket = 0; uBucket < uBuckets; uBucket++)
 		{
-			if (strcmp(psCurr->pcKey, pcKey) == 0) 
-			{
-			/* Save & return old value, & overwrite with new value */
-				pvOldValue = psCurr->pvValue;
-				psCurr->pvValue = (void *)pvValue;
-				return (void *)pvOldValue;
-			}
-			psCurr = psCurr->psNext;
+			for (uLength = 1; uLength <= puStarts[uBucket + 1] -
+				puStarts[uBucket]; uLength++)
+				psStats->auProbes[uLength < SYMTABLE_PROBE_MAX ?
+					uLength - 1 : SYMTABLE_PROBE_MAX - 1]++;
+			uLength--;
+			if (uLength == 0) continue;
+			psStats->uUsedBuckets++;
+			if (uLength > psStats->uMaxChain)
+				psStats->uMaxChain = uLength;
 		}
-		return NULL;
+		psStats->uBuckets = uBuckets;
+		psStats->dLoadFactor = (double)psStats->uBindings /
+			(double)uBuckets;
+		if (psStats->uUsedBuckets != 0)
+			psStats->dMeanChain = (double)psStats->uBindings /
+				(double)psStats->uUsedBuckets;
+
+		uFixed = (const char *)(SymTable_imageEntries(psImage) +
+			psImage->uBindings) - (const char *)psImage;
+		psStats->uStructBytes = sizeof(struct SymTable);
+		psStats->uTableBytes = sizeof(struct Image) +
+			(uBuckets + 1) * sizeof(size_t);
+		psStats->uNodeBytes = psImage->uBindings *
+			sizeof(struct ImageEntry);
+		psStats->uKeyBytes = psImage->uBytes - uFixed;
+		psStats->uTotalBytes = psStats->uStructBytes +
+			psStats->uTableBytes + psStats->uNodeBytes +
+			psStats->uKeyBytes;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+/* Add the chain that starts at psHead, which may be empty, to the
+   bucket, chain and probe counts of psStats. */
+
+	static void SymTable_addChain(struct SymTable_Stats *psStats,
+		struct Node *psHead)
 	{
 		struct Node *psCurr;
-		size_t uHashedIndex;
-
-		assert(oSymTable != NULL); 
-		assert(pcKey != NULL);
+		size_t uLength = 0;
 
-		uHashedIndex = SymTable_hash(pcKey, oSymTable->uPhysLength);
-		psCurr = oSymTable->ppsTable[uHashedIndex];
+		assert(psStats != NULL);
 
-	/* Traverse nodes in hash key location and return 1 if a key in 
-	   the node key matches the query key. */
-		while (psCurr != NULL)
+	/* The nth node of a chain is found with n comparisons. */
+		for (psCurr = psHead; psCurr != NULL; psCurr = psCurr->psNext)
 		{
-			if (strcmp(pcKey, psCurr->pcKey) == 0) return 1; 
-			psCurr = psCurr->psNext;
+			uLength++;
+			psStats->auProbes[uLength < SYMTABLE_PROBE_MAX ?
+				uLength - 1 : SYMTABLE_PROBE_MAX - 1]++;
 		}
 
-	/* Return 0 otherwise */
-		return 0;
+		psStats->uBuckets++;
+		if (uLength == 0) return;
+		psStats->uUsedBuckets++;
+		if (uLength > psStats->uMaxChain) psStats->uMaxChain = uLength;
 	}
 
-	void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+/*-------------------------------------------------------------------*/
+
+	void SymTable_getStats(SymTable_T oSymTable,
+		struct SymTable_Stats *psStats)
 	{
-		struct Node *psCurr;
-		size_t uHashedIndex;
+		size_t uIndex;
+		size_t uInlineBytes;
 
 		assert(oSymTable != NULL);
-		assert(pcKey != NULL);
+		assert(psStats != NULL);
 
-		uHashedIndex = SymTable_hash(pcKey, oSymTable->uPhysLength);
-		psCurr = oSymTable->ppsTable[uHashedIndex];
+		memset(psStats, 0, sizeof(struct SymTable_Stats));
+		psStats->uBindings = oSymTable->uBindCount;
+		psStats->uResizes = oSymTable->uResizeCount;
 
-	/* Traverse nodes in the correct bucket and return a pointer 
-	   to the value connected to the query Key */
-		while(psCurr != NULL)
+		if (oSymTable->psImage != NULL)
 		{
-			if (strcmp(psCurr->pcKey, pcKey) == 0) 
-				return (void *)psCurr->pvValue;
-			psCurr = psCurr->psNext;
+			SymTable_getMappedStats(oSymTable, psStats);
+			return;
 		}
-		return NULL;
+		if (oSymTable->psFrozen != NULL)
+		{
+			SymTable_getFrozenStats(oSymTable, psStats);
+			return;
+		}
+
+	/* A small table's inline bindings are searched as one chain. */
+		if (oSymTable->ppsTable == NULL)
+		{
+			psStats->uBuckets = 1;
+			psStats->uUsedBuckets = oSymTable->uBindCount != 0;
+			psStats->uMaxChain = oSymTable->uBindCount;
+			for (uIndex = 0; uIndex < oSymTable->uBindCount; uIndex++)
+				psStats->auProbes[uIndex < SYMTABLE_PROBE_MAX ?
+					uIndex : SYMTABLE_PROBE_MAX - 1]++;
+		}
+
+	/* Otherwise count the buckets not yet moved out of the old array,
+	   if a resize is in progress, and every bucket of the new one. */
+		else
+		{
+			if (oSymTable->ppsOldTable != NULL)
+				for (uIndex = oSymTable->uMigrateIndex;
+					uIndex < oSymTable->uOldPhysLength; uIndex++)
+					SymTable_addChain(psStats,
+						oSymTable->ppsOldTable[uIndex]);
+			for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+				SymTable_addChain(psStats, oSymTable->ppsTable[uIndex]);
+		}
+
+		psStats->dLoadFactor = (double)psStats->uBindings /
+			(double)psStats->uBuckets;
+		if (psStats->uUsedBuckets != 0)
+			psStats->dMeanChain = (double)psStats->uBindings /
+				(double)psStats->uUsedBuckets;
+
+	/* The inline bindings are part of the structure itself. The room
+	   that each arena node keeps for a key counts as key bytes, unless
+	   the keys are borrowed. */
+		psStats->uStructBytes = sizeof(struct SymTable);
+		psStats->uTableBytes = (oSymTable->uPhysLength +
+			oSymTable->uOldPhysLength) * sizeof(struct Node*);
+		uInlineBytes = oSymTable->iBorrowKeys ? 0 :
+			oSymTable->sArena.uNodeBytes / sizeof(struct Node) *
+			KEY_INLINE;
+		psStats->uNodeBytes = oSymTable->sArena.uNodeBytes -
+			uInlineBytes;
+		psStats->uKeyBytes = oSymTable->sArena.uKeyBytes + uInlineBytes;
+		psStats->uTotalBytes = psStats->uStructBytes +
+			psStats->uTableBytes + psStats->uNodeBytes +
+			psStats->uKeyBytes;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+/* Return the slot that a key whose hash code is uHash lands in, out
+   of uSlots, when its bucket has displacement uDisp. The hash code is
+   mixed again with the displacement, so that each displacement sends
+   the keys of a bucket to slots unrelated to those of the last. */
+
+	static size_t SymTable_slot(size_t uHash, size_t uDisp,
+		size_t uSlots)
 	{
-		struct Node *psCurr;
-		struct Node *psPrev;
-		const void *pvOldValue;
-		size_t uHashedIndex;
+		assert(uSlots > 0);
+
+		uHash ^= uDisp * HASH_FIBONACCI;
+		uHash *= HASH_MIX;
+		uHash ^= uHash >> HASH_SHIFT;
+		return uHash % uSlots;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the slot of frozen oSymTable that holds pcKey, or the number
+   of bindings if there is none. The slot is computed, not searched
+   for, so the only key compared is the one in it. */
+
+	static size_t SymTable_findFrozen(SymTable_T oSymTable,
+		const char *pcKey)
+	{
+		const struct Frozen *psFrozen;
+		size_t uHash;
+		size_t uSlot;
 
 		assert(oSymTable != NULL);
+		assert(oSymTable->psFrozen != NULL);
 		assert(pcKey != NULL);
 
-	/* Return NULL if oSymbolTable has no bindings */
-		if (oSymTable->uBindCount == 0) return NULL;
+		if (oSymTable->uBindCount == 0) return 0;
+		psFrozen = oSymTable->psFrozen;
+		uHash = SymTable_hash(pcKey, psFrozen->uSeed);
+		uSlot = SymTable_slot(uHash, psFrozen->auDisp[
+			SymTable_reduce(uHash, psFrozen->uShift)],
+			oSymTable->uBindCount);
+		if (strcmp(psFrozen->psSlots[uSlot].pcKey, pcKey) != 0)
+			return oSymTable->uBindCount;
+		return uSlot;
+	}
 
-	/* Get hash index and return if no nodes exist at this index. */
-		uHashedIndex = SymTable_hash(pcKey, oSymTable->uPhysLength);
-		if (oSymTable->ppsTable[uHashedIndex] == NULL) return NULL;
+/*-------------------------------------------------------------------*/
+
+/* Place the uCount bindings psKeys, whose hash codes are under the
+   seed of psFrozen, in its slots: group them by bucket, then give
+   each bucket, largest first, the smallest displacement that sends
+   all of its keys to slots still empty. puWork must have room for
+   2 * (buckets + uCount) + 3 size_t values. Return 1, or 0 if some
+   bucket cannot be placed within its budget of displacements, as
+   happens when two of its keys share a hash code. */
 
-	/* Otherwise proceed with traversing nodes. First we check if
-	   it is a special case of the query Node being the first in the
-	   relavant bucket. If so, we remove it below and return the
-	   removed value. */
-		if (strcmp(pcKey, 
-			oSymTable->ppsTable[uHashedIndex]->pcKey) == 0)
+	static int SymTable_place(struct Frozen *psFrozen,
+		const struct FreezeKey *psKeys, size_t uCount, size_t *puWork)
+	{
+		size_t uBuckets;
+		size_t *puStarts;
+		size_t *puOrder;
+		size_t *puBySize;
+		size_t *puSizes;
+		size_t uBucket;
+		size_t uIndex;
+		size_t uSize;
+		size_t uDisp;
+		size_t uTries;
+		size_t uFirst;
+		size_t uPlaced;
+		size_t uOther;
+
+		assert(psFrozen != NULL);
+		assert(psKeys != NULL);
+		assert(uCount > 0);
+		assert(puWork != NULL);
+
+		uBuckets = (size_t)1 << (HASH_BITS - psFrozen->uShift);
+		puStarts = puWork;
+		puOrder = puStarts + uBuckets + 1;
+		puBySize = puOrder + uCount;
+		puSizes = puBySize + uBuckets;
+
+	/* Group the keys by bucket, as SymTable_save groups entries:
+	   count each bucket into the start of the next and sum, then
+	   fill each bucket in turn, which moves its start up to the next
+	   bucket's, and move the starts back. */
+		memset(puStarts, 0, (uBuckets + 1) * sizeof(size_t));
+		for (uIndex = 0; uIndex < uCount; uIndex++)
+			puStarts[SymTable_reduce(psKeys[uIndex].uHash,
+				psFrozen->uShift) + 1]++;
+		for (uBucket = 0; uBucket < uBuckets; uBucket++)
+			puStarts[uBucket + 1] += puStarts[uBucket];
+		for (uIndex = 0; uIndex < uCount; uIndex++)
+			puOrder[puStarts[SymTable_reduce(psKeys[uIndex].uHash,
+				psFrozen->uShift)]++] = uIndex;
+		for (uBucket = uBuckets; uBucket > 0; uBucket--)
+			puStarts[uBucket] = puStarts[uBucket - 1];
+		puStarts[0] = 0;
+
+	/* Sort the buckets by size, largest first, by counting the
+	   buckets of each size and turning the counts into the position
+	   of the first bucket of that size. */
+		memset(puSizes, 0, (uCount + 2) * sizeof(size_t));
+		for (uBucket = 0; uBucket < uBuckets; uBucket++)
+			puSizes[puStarts[uBucket + 1] - puStarts[uBucket]]++;
+		for (uSize = uCount + 1, uPlaced = 0; uSize > 0; uSize--)
 		{
-			psCurr = oSymTable->ppsTable[uHashedIndex];
-			pvOldValue = psCurr->pvValue;
-			oSymTable->ppsTable[uHashedIndex] = 
-			oSymTable->ppsTable[uHashedIndex]->psNext;
-			free((char *)psCurr->pcKey);
-			free(psCurr);
-			oSymTable->uBindCount--;
-			return (void *)pvOldValue;
+			uOther = puSizes[uSize - 1];
+			puSizes[uSize - 1] = uPlaced;
+			uPlaced += uOther;
 		}
-
-		psPrev = oSymTable->ppsTable[uHashedIndex];
-		psCurr = psPrev->psNext;
-
-	/* Traverse nodes after the first node in a bucket;
-	   remove the query key and its associated Node and update 
-	   connections/count. Then return removed value */
-		while (psCurr != NULL)
+		for (uBucket = 0; uBucket < uBuckets; uBucket++)
+			puBySize[puSizes[puStarts[uBucket + 1] -
+				puStarts[uBucket]]++] = uBucket;
+
+	/* Place the buckets. An empty slot has a NULL key. */
+		for (uIndex = 0; uIndex < uCount; uIndex++)
+			psFrozen->psSlots[uIndex].pcKey = NULL;
+		uTries = uCount * FREEZE_TRIES;
+		if (uTries / FREEZE_TRIES != uCount || uTries > UINT_MAX)
+			uTries = UINT_MAX;
+		for (uIndex = 0; uIndex < uBuckets; uIndex++)
 		{
-			if (strcmp(pcKey, psCurr->pcKey) == 0)
-			{	
-				pvOldValue = psCurr->pvValue;
-				psPrev->psNext = psCurr->psNext;
-				free((char *)psCurr->pcKey);
-				free(psCurr);
-				oSymTable->uBindCount--;
-				return (void *)pvOldValue;
+			uBucket = puBySize[uIndex];
+			uFirst = puStarts[uBucket];
+			uSize = puStarts[uBucket + 1] - uFirst;
+			psFrozen->auDisp[uBucket] = 0;
+			if (uSize == 0) break;
+
+	/* Try displacements until each key lands in an empty slot,
+	   taking back the slots of a try that fails part way. */
+			for (uDisp = 0; ; uDisp++)
+			{
+				if (uDisp >= uTries) return 0;
+				for (uPlaced = 0; uPlaced < uSize; uPlaced++)
+				{
+					uOther = SymTable_slot(
+						psKeys[puOrder[uFirst + uPlaced]].uHash, uDisp,
+						uCount);
+					if (psFrozen->psSlots[uOther].pcKey != NULL) break;
+					psFrozen->psSlots[uOther].pcKey =
+						psKeys[puOrder[uFirst + uPlaced]].pcKey;
+					psFrozen->psSlots[uOther].pvValue =
+						psKeys[puOrder[uFirst + uPlaced]].pvValue;
+				}
+				if (uPlaced == uSize) break;
+				while (uPlaced > 0)
+				{
+					uPlaced--;
+					psFrozen->psSlots[SymTable_slot(
+						psKeys[puOrder[uFirst + uPlaced]].uHash, uDisp,
+						uCount)].pcKey = NULL;
+				}
 			}
-			psPrev = psCurr;
-			psCurr = psCurr->psNext;
+			psFrozen->auDisp[uBucket] = (unsigned int)uDisp;
 		}
-		return NULL;
+
+	/* The buckets left after the first empty one are empty too. */
+		for (; uIndex < uBuckets; uIndex++)
+			psFrozen->auDisp[puBySize[uIndex]] = 0;
+		return 1;
 	}
 
 /*-------------------------------------------------------------------*/
 
-	void SymTable_map(SymTable_T oSymTable,
-		void (*pfApply)(const char *pcKey, void *pvValue, 
-			void *pvExtra),const void *pvExtra)
+/* Turn oSymTable into a minimal perfect hash in one block. The
+   bindings are gathered, then placed with one seed after another
+   until every bucket finds a displacement. Only then are the key
+   bytes packed after the displacements and the old nodes, key copies
+   and bucket arrays freed, so a failure leaves the table as it was.
+   The keys are hashed with SymTable_hash whatever the table's own
+   hash function is, so that a seed can be varied. */
+
+	int SymTable_freeze(SymTable_T oSymTable)
 	{
-		struct Node *psCurr;
+		struct SymTable_Iter sIter;
+		struct Frozen *psFrozen;
+		struct FreezeKey *psKeys;
+		size_t *puWork;
+		size_t uCount;
+		size_t uBuckets = 2;
+		size_t uShift = HASH_BITS - 1;
+		size_t uKeyBytes = 0;
+		size_t uFixed;
+		size_t uSeed;
 		size_t uIndex;
+		size_t uSize;
+		char *pcNext;
+		int iPlaced = 1;
 
 		assert(oSymTable != NULL);
-		assert(pfApply != NULL);
+		assert(oSymTable->psImage == NULL);
 
-	/* Traverse all the buckets and the traverse through each Node
-	   in each bucket and apply function pfApply to each key,
-	   value, and extra value if present */
-		for (uIndex = 0; uIndex <oSymTable->uPhysLength; uIndex++)
+		if (oSymTable->psFrozen != NULL) return 1;
+
+	/* Give each bucket at most FREEZE_LOAD keys on average. */
+		uCount = oSymTable->uBindCount;
+		while (uBuckets * FREEZE_LOAD < uCount)
 		{
-			psCurr = oSymTable->ppsTable[uIndex];
-			while (psCurr != NULL)
+			uBuckets *= 2;
+			uShift--;
+		}
+
+	/* Gather the bindings and the size of their keys. */
+		psKeys = (struct FreezeKey *)malloc((uCount + 1) *
+			sizeof(struct FreezeKey));
+		puWork = (size_t *)malloc((2 * (uBuckets + uCount) + 3) *
+			sizeof(size_t));
+		if (psKeys == NULL || puWork == NULL)
+		{
+			free(psKeys);
+			free(puWork);
+			return 0;
+		}
+		SymTable_iterBegin(oSymTable, &sIter);
+		for (uIndex = 0; SymTable_iterNext(&sIter, &psKeys[uIndex].pcKey,
+			&psKeys[uIndex].pvValue); uIndex++)
+			if (! oSymTable->iBorrowKeys)
+				uKeyBytes += strlen(psKeys[uIndex].pcKey) + 1;
+
+	/* Lay out the block: header, slots, displacements, key bytes. */
+		uFixed = sizeof(struct Frozen) +
+			uCount * sizeof(struct FrozenSlot) +
+			uBuckets * sizeof(unsigned int);
+		psFrozen = (struct Frozen *)malloc(uFixed + uKeyBytes);
+		if (psFrozen == NULL)
+		{
+			free(psKeys);
+			free(puWork);
+			return 0;
+		}
+		psFrozen->uShift = uShift;
+		psFrozen->psSlots = (struct FrozenSlot *)(void *)(psFrozen + 1);
+		psFrozen->auDisp = (unsigned int *)(void *)
+			(psFrozen->psSlots + uCount);
+		psFrozen->uBytes = uFixed + uKeyBytes;
+
+	/* Hash the keys with one seed after another until they can be
+	   placed. */
+		for (uSeed = 0; uCount != 0; uSeed++)
+		{
+			if (uSeed == FREEZE_SEEDS)
 			{
-				(*pfApply)(psCurr->pcKey, (void *)psCurr->pvValue, 
-					(void *)pvExtra);
-				psCurr = psCurr->psNext;
+				iPlaced = 0;
+				break;
 			}
+			psFrozen->uSeed = uSeed * HASH_FIBONACCI;
+			for (uIndex = 0; uIndex < uCount; uIndex++)
+				psKeys[uIndex].uHash = SymTable_hash(
+					psKeys[uIndex].pcKey, psFrozen->uSeed);
+			if (SymTable_place(psFrozen, psKeys, uCount, puWork)) break;
+		}
+		free(psKeys);
+		free(puWork);
+		if (! iPlaced)
+		{
+			free(psFrozen);
+			return 0;
+		}
+		if (uCount == 0)
+		{
+			psFrozen->uSeed = 0;
+			for (uIndex = 0; uIndex < uBuckets; uIndex++)
+				psFrozen->auDisp[uIndex] = 0;
+		}
+
+	/* Copy the keys next to each other in slot order, unless they
+	   are borrowed, then free what the table was made of. */
+		pcNext = (char *)psFrozen + uFixed;
+		for (uIndex = 0; uIndex < uCount && ! oSymTable->iBorrowKeys;
+			uIndex++)
+		{
+			uSize = strlen(psFrozen->psSlots[uIndex].pcKey) + 1;
+			memcpy(pcNext, psFrozen->psSlots[uIndex].pcKey, uSize);
+			psFrozen->psSlots[uIndex].pcKey = pcNext;
+			pcNext += uSize;
+		}
+		SymTable_release(oSymTable);
+		oSymTable->uPhysLength = 0;
+		oSymTable->uShift = 0;
+		oSymTable->ppsTable = NULL;
+		oSymTable->ppsOldTable = NULL;
+		oSymTable->uOldPhysLength = 0;
+		oSymTable->uOldShift = 0;
+		oSymTable->uMigrateIndex = 0;
+		memset(&oSymTable->sArena, 0, sizeof(struct Arena));
+		oSymTable->sArena.uNodeChunkLength = NODE_CHUNK_MIN;
+		oSymTable->sArena.uKeyChunkLength = KEY_CHUNK_MIN;
+		oSymTable->psFrozen = psFrozen;
+		return 1;
+	}
+
+/*-------------------------------------------------------------------*/
+
+/* Fill in psStats for frozen oSymTable, whose uBindings and uResizes
+   are already set. Each slot is a bucket that one lookup compares
+   one key against, its table is the header and displacements, its
+   nodes are the slots' keys and values, and its keys are the key
+   bytes. */
+
+	static void SymTable_getFrozenStats(SymTable_T oSymTable,
+		struct SymTable_Stats *psStats)
+	{
+		const struct Frozen *psFrozen;
+		size_t uCount;
+
+		assert(oSymTable != NULL);
+		assert(oSymTable->psFrozen != NULL);
+		assert(psStats != NULL);
+
+		psFrozen = oSymTable->psFrozen;
+		uCount = oSymTable->uBindCount;
+		psStats->uBuckets = uCount;
+		psStats->uUsedBuckets = uCount;
+		psStats->auProbes[0] = uCount;
+		if (uCount != 0)
+		{
+			psStats->dLoadFactor = 1.0;
+			psStats->uMaxChain = 1;
+			psStats->dMeanChain = 1.0;
 		}
+
+		psStats->uStructBytes = sizeof(struct SymTable);
+		psStats->uTableBytes = sizeof(struct Frozen) +
+			((size_t)1 << (HASH_BITS - psFrozen->uShift)) *
+			sizeof(unsigned int);
+		psStats->uNodeBytes = uCount * sizeof(struct FrozenSlot);
+		psStats->uKeyBytes = psFrozen->uBytes - psStats->uTableBytes -
+			psStats->uNodeBytes;
+		psStats->uTotalBytes = psStats->uStructBytes +
+			psStats->uTableBytes + psStats->uNodeBytes +
+			psStats->uKeyBytes;
 	}
@@ -0,0 +1,132 @@
+/*-------------------------------------------------------------------*/
+/* symtablehash.h                                                    */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* Functions that only the hash table implementation of SymTable
+   (symtablehash.c) provides, in addition to those of symtable.h. */
+
+#include "symtable.h"
+
+/*-------------------------------------------------------------------*/
+
+#ifndef SYMTABLEHASH_INCLUDED
+#define SYMTABLEHASH_INCLUDED
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_mapParallel: Like SymTable_map, applies function         *
+ *                       *pfApply to each binding in oSymTable, but  *
+ *                       splits the buckets among uThreads threads,  *
+ *                       the calling thread included. The thread     *
+ *                       numbered i passes ppvExtras[i] as the       *
+ *                       extra argument, so each thread can keep its *
+ *                       own partial result. Once every binding has  *
+ *                       been visited, if pfReduce is not NULL, the  *
+ *                       calling thread calls (*pfReduce)            *
+ *                       (ppvExtras[0], ppvExtras[i]) for each i     *
+ *                       from 1 to uThreads-1 in order. *pfApply     *
+ *                       may run on several threads at once and must *
+ *                       not change oSymTable. If threads cannot be  *
+ *                       created, the remaining ones do their work.  *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   void **ppvExtras, size_t uThreads,
+   void (*pfReduce)(void *pvInto, void *pvFrom));
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_putMany: Adds to oSymTable, as uCount calls of           *
+ *                   SymTable_put in order would, a binding of key   *
+ *                   ppcKeys[i] and value ppvValues[i] for each i    *
+ *                   whose key is neither in oSymTable already nor   *
+ *                   earlier in ppcKeys. Sizes the table once for    *
+ *                   all of them, takes every node and short key     *
+ *                   copy from one block, and hashes the keys on up  *
+ *                   to uThreads threads, the calling thread         *
+ *                   included. If piAdded is not NULL, stores 1 in   *
+ *                   piAdded[i] if binding i was added and 0 if its  *
+ *                   key was a duplicate. Returns 1, or, if          *
+ *                   insufficient memory is available, leaves the    *
+ *                   bindings of oSymTable unchanged and returns 0.  *
+ *                   A client hash function must be safe to call     *
+ *                   from several threads if uThreads exceeds 1.     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SymTable_putMany(SymTable_T oSymTable, const char *const *ppcKeys,
+   void *const *ppvValues, size_t uCount, size_t uThreads,
+   int *piAdded);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_compact: Shrinks the bucket array of oSymTable, in one   *
+ *                   step, to the smallest size that is at most half *
+ *                   full, finishing any resize in progress first.   *
+ *                   Removes already shrink the array gradually once *
+ *                   it is mostly empty; call this during an idle    *
+ *                   period to pay for all of it at once. Leaves the *
+ *                   array unchanged if insufficient memory is       *
+ *                   available.                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_compact(SymTable_T oSymTable);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_save: Writes to the file named pcPath an image of the    *
+ *                bindings of oSymTable that SymTable_openMapped can *
+ *                map. Each value is stored as the bytes that        *
+ *                (*pfSerialize)(pcKey, pvValue, pvBuffer, uRoom,    *
+ *                pvExtra) writes to pvBuffer. *pfSerialize must     *
+ *                return the number of bytes the value needs, and    *
+ *                write them only if that is at most uRoom; it is    *
+ *                called again with more room otherwise. The image   *
+ *                is written to the file named pcPath followed by    *
+ *                ".tmp", then renamed to pcPath, so that a table    *
+ *                mapping an older image at pcPath keeps it intact.  *
+ *                Returns 1, or 0 if the file cannot be written or   *
+ *                insufficient memory is available, in which case    *
+ *                any file at pcPath is left as it was.              *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+   size_t (*pfSerialize)(const char *pcKey, void *pvValue,
+      void *pvBuffer, size_t uRoom, void *pvExtra),
+   const void *pvExtra);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_openMapped: Returns a SymTable object that maps the      *
+ *                      image in the file named pcPath, written by   *
+ *                      SymTable_save on a machine with the same     *
+ *                      word size and byte order, without reading    *
+ *                      or copying its bindings. Returns NULL if the *
+ *                      file cannot be mapped, does not hold such an *
+ *                      image, or insufficient memory is available.  *
+ *                      SymTable_get returns a pointer to a value's  *
+ *                      serialized bytes, which are read-only and    *
+ *                      start on a 16-byte boundary. The table may   *
+ *                      be read, traversed, saved and freed, but not *
+ *                      changed. The file must not change while it   *
+ *                      is mapped.                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+SymTable_T SymTable_openMapped(const char *pcPath);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_freeze: Turns oSymTable, which must not be mapped, into  *
+ *                  a read-only minimal perfect hash of its keys:    *
+ *                  one slot per binding, the keys and values in     *
+ *                  contiguous arrays, and the key bytes, unless     *
+ *                  they are borrowed, packed in one block, so that  *
+ *                  SymTable_get and SymTable_contains read one slot *
+ *                  and compare one key. The table may then be read, *
+ *                  traversed, saved and freed, but not changed. Its *
+ *                  keys are hashed with the built-in hash function  *
+ *                  whatever function it was created with. Returns   *
+ *                  1, or 0 if insufficient memory is available or   *
+ *                  no perfect hash is found, leaving oSymTable as   *
+ *                  it was. Freezing a frozen table does nothing.    *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SymTable_freeze(SymTable_T oSymTable);
+
+#endif
@@ -0,0 +1,1558 @@
+/*-------------------------------------------------------------------*/
+/* symtablehashmt.c                                                  */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* A chained hash table whose functions may be called from several
+   threads at once, built for tables that are read far more often
+   than they are changed.
+
+   SymTable_get and SymTable_contains take no locks and make no
+   atomic read-modify-write operations. Writers divide the buckets
+   into STRIPE_COUNT stripes, each guarded by its own mutex, so
+   changes to different stripes never wait for each other. A writer
+   fully builds a node (or, on a resize, a whole new bucket array)
+   before publishing it with a release store, so a reader that finds
+   it sees it complete.
+
+   Unlinked nodes and replaced bucket arrays are not freed at once,
+   because a reader may still be walking them. They are retired with
+   the current global epoch and may be freed once the epoch has
+   advanced LIMBO_COUNT times (arrays twice). Each thread announces
+   the epoch it read in before a lookup and clears the announcement
+   after, and the epoch advances only once every active thread has
+   announced the current one (epoch-based reclamation). A writer
+   frees old nodes as it reuses their limbo list, and after a grow or
+   clear it advances the epoch as far as readers allow and sweeps the
+   whole table; what readers still hold then is swept by a later
+   write once the epoch has moved on.
+
+   Only SymTable_free must not overlap any other call on the same
+   table. The address returned by SymTable_getOrPut is safe to use
+   only while no other thread may remove that binding or grow the
+   table, and storing through it races with concurrent lookups; use
+   SymTable_replace or SymTable_upsert to change a shared value. The
+   function passed to SymTable_map runs with every stripe locked, so
+   it may look keys up but must not change the table. A client hash
+   function must be safe to call from several threads. */
+
+/* The pthread functions and posix_memalign are POSIX, not ANSI C. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include "symtable.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+
+/*-------------------------------------------------------------------*/
+
+/* Multiplier and shift of the built-in hash function, and the
+   Fibonacci multiplier that spreads hash codes over the buckets,
+   sized to the width of size_t. */
+#if ULONG_MAX > 0xffffffffUL
+#define HASH_MIX ((size_t)0xc6a4a7935bd1e995UL)
+#define HASH_SHIFT 47
+#define HASH_FIBONACCI ((size_t)0x9e3779b97f4a7c15UL)
+#else
+#define HASH_MIX ((size_t)0x5bd1e995UL)
+#define HASH_SHIFT 24
+#define HASH_FIBONACCI ((size_t)0x9e3779b9UL)
+#endif
+
+/* Number of bits in a size_t hash code. */
+#define HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+/*-------------------------------------------------------------------*/
+
+/* Base 2 logarithm of the number of stripes. A bucket's stripe is the
+   top STRIPE_LOG bits of its index, so each stripe owns a contiguous
+   range of buckets and keeps the same keys across resizes. */
+enum {STRIPE_LOG = 6, STRIPE_COUNT = 1 << STRIPE_LOG};
+
+/* Base 2 logarithm of the number of buckets in a new table. Must be
+   at least STRIPE_LOG. */
+enum {INITIAL_LENGTH_LOG = 9};
+
+/* Size of a cache line. Stripes and reader records are padded to a
+   multiple of it so that threads using neighbouring ones do not
+   share a line. */
+enum {CACHE_LINE = 64};
+
+/* Number of limbo lists per stripe. Nodes retired in epoch e go on
+   list e % LIMBO_COUNT, which may be emptied from epoch
+   e + LIMBO_COUNT on, by which time no reader can hold them. */
+enum {LIMBO_COUNT = 3};
+
+/* Number of nodes a stripe retires between attempts by its writers
+   to advance the global epoch. Each attempt walks every reader
+   record, so removes pay for one only now and then, while each limbo
+   list still stays short. */
+enum {RETIRE_ADVANCE = 64};
+
+/*-------------------------------------------------------------------*/
+
+/* Node is a structure that stores and associates a char Key with
+   a void value and also maintains a pointer to the next node. The
+   key copy follows the node in the same allocation. */
+
+struct Node
+{
+	/* Full hash code of pcKey, already multiplied by HASH_FIBONACCI.
+	   Never changes once the node is published. */
+	size_t uHash;
+
+	/* Char pointer to hold the Key. Never changes once the node is
+	   published. */
+	const char *pcKey;
+
+	/* A void pointer to hold the Value. */
+	void *pvValue;
+
+	/* Another Node to hold a pointer to the next Node. */
+	struct Node *psNext;
+
+	/* The next node on the same limbo list, once this one has been
+	   unlinked. psNext is left alone for readers still here. */
+	struct Node *psRetired;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Table is the header of one bucket array. The buckets follow the
+   header in the same allocation, so a reader that loads the table
+   pointer gets a length and a shift that match its buckets. */
+
+struct Table
+{
+	/* Count of buckets, always a power of two. */
+	size_t uPhysLength;
+
+	/* HASH_BITS minus the base 2 logarithm of uPhysLength. */
+	size_t uShift;
+
+	/* Once replaced by a larger array: the epoch it was retired in,
+	   and the table retired before it. */
+	size_t uRetireEpoch;
+	struct Table *psRetired;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Stripe is a structure that holds the mutex guarding changes to one
+   range of buckets, the number of bindings in that range, and the
+   nodes unlinked from it that readers may still hold. */
+
+struct Stripe
+{
+	/* Held by every change to the stripe's buckets. */
+	pthread_mutex_t sLock;
+
+	/* Number of bindings in the stripe's buckets. Changed only with
+	   sLock held; read atomically by SymTable_getLength. */
+	size_t uCount;
+
+	/* Number of nodes SymTable_remove has retired from the stripe,
+	   modulo RETIRE_ADVANCE. Changed only with sLock held. */
+	size_t uRetired;
+
+	/* Unlinked nodes, the epoch each list was filled in, and the
+	   bytes each list holds, key copies included. */
+	struct Node *apsLimbo[LIMBO_COUNT];
+	size_t auLimboEpoch[LIMBO_COUNT];
+	size_t auLimboBytes[LIMBO_COUNT];
+};
+
+/*-------------------------------------------------------------------*/
+
+/* PaddedStripe is a Stripe rounded up to a whole number of cache
+   lines, which adds nothing if it already fills them. */
+
+union PaddedStripe
+{
+	/* The stripe itself. */
+	struct Stripe sStripe;
+
+	/* Room to the end of the stripe's last cache line. */
+	char acLines[(sizeof(struct Stripe) + CACHE_LINE - 1) /
+		CACHE_LINE * CACHE_LINE];
+};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain the bucket array of a Symbol
+   Table and the stripes whose mutexes guard it. */
+
+struct SymTable
+{
+	/* The current bucket array. Replaced with a release store, with
+	   every stripe locked, by SymTable_resize. */
+	struct Table *psTable;
+
+	/* Bucket arrays that have been replaced, newest first. */
+	struct Table *psRetiredTables;
+
+	/* The stripes, aligned to a cache line. */
+	union PaddedStripe *psStripes;
+
+	/* Number of times the bucket array has been grown. */
+	size_t uResizeCount;
+
+	/* The client's hash function, or NULL to use SymTable_hash. */
+	size_t (*pfHash)(const char *pcKey);
+
+	/* 1 if nodes point to the client's keys instead of copies. */
+	int iBorrowKeys;
+
+	/* The epoch from which everything retired by the last grow or
+	   clear may be freed, or 0 if it all has been. Read by writers
+	   without a lock. */
+	size_t uReclaimEpoch;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Reader is a structure through which one thread announces the epoch
+   of its current lookup. Records are shared by every table, and are
+   reused once their thread exits. */
+
+struct Reader
+{
+	/* 2e+1 while the thread is in a lookup that started in epoch e,
+	   and 0 otherwise. Written only by the owning thread. */
+	size_t uActive;
+
+	/* Number of lookups the thread is nested in, for a lookup made
+	   from inside a SymTable_map callback. */
+	size_t uDepth;
+
+	/* Whether a live thread owns this record. */
+	int iInUse;
+
+	/* The record registered before this one. */
+	struct Reader *psNext;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* PaddedReader is a Reader rounded up to a whole number of cache
+   lines, so that no two threads' records share one. */
+
+union PaddedReader
+{
+	/* The record itself. */
+	struct Reader sReader;
+
+	/* Room to the end of the record's last cache line. */
+	char acLines[(sizeof(struct Reader) + CACHE_LINE - 1) /
+		CACHE_LINE * CACHE_LINE];
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Special function to create full-width size_t hash codes for
+   pcKey */
+static size_t SymTable_hash(const char *pcKey);
+
+/* Special function to hash pcKey with the hash function of
+   oSymTable */
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey);
+
+/* Special functions to start and end a lookup that takes no lock */
+static struct Reader *SymTable_enter(void);
+static void SymTable_leave(struct Reader *psReader);
+
+/* Special function to advance the global epoch if every active
+   reader has announced the current one */
+static int SymTable_advance(void);
+
+/* Special function to put an unlinked node on a limbo list of its
+   stripe */
+static void SymTable_retireNode(SymTable_T oSymTable,
+	struct Stripe *psStripe, struct Node *psNode);
+
+/* Special function to free the nodes of one limbo list */
+static void SymTable_freeLimbo(struct Stripe *psStripe, size_t uList);
+
+/* Special functions to note that a grow or clear retired memory in
+   epoch uEpoch, to free retired memory that no reader can hold while
+   every stripe is locked, and to do so from a writer holding none
+   once the epoch allows */
+static void SymTable_setReclaim(SymTable_T oSymTable, size_t uEpoch);
+static void SymTable_reclaim(SymTable_T oSymTable);
+static void SymTable_tryReclaim(SymTable_T oSymTable);
+
+/* Special function to find the node holding pcKey without taking a
+   lock */
+static struct Node *SymTable_find(SymTable_T oSymTable,
+	const char *pcKey, size_t uHash);
+
+/* Special function to find the link that points to the node holding
+   pcKey, or the NULL link at the end of its bucket */
+static struct Node **SymTable_findLink(SymTable_T oSymTable,
+	const char *pcKey, size_t uHash);
+
+/* Special function to copy pcKey, unless oSymTable borrows keys,
+   pvValue and uHash into a new node */
+static struct Node *SymTable_newNode(SymTable_T oSymTable,
+	const char *pcKey, const void *pvValue, size_t uHash);
+
+/* Special functions to lock and unlock every stripe in order */
+static void SymTable_lockAll(SymTable_T oSymTable);
+static void SymTable_unlockAll(SymTable_T oSymTable);
+
+/* Special function to double the number of buckets if the stripe
+   uStripe is still overloaded */
+static void SymTable_resize(SymTable_T oSymTable, size_t uStripe);
+
+/* Special function to replace the bucket array with a larger one of
+   2^(HASH_BITS - uShift) buckets while every stripe is locked */
+static int SymTable_grow(SymTable_T oSymTable, size_t uShift);
+
+/*-------------------------------------------------------------------*/
+
+/* The global epoch. Starts at LIMBO_COUNT so that it never needs to
+   be compared against a negative epoch. */
+static size_t uGlobalEpoch = LIMBO_COUNT;
+
+/* Every reader record ever registered, newest first. Records are
+   added under sReaderLock and never removed. */
+static struct Reader *psReaders = NULL;
+static pthread_mutex_t sReaderLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The key under which each thread keeps its reader record. */
+static pthread_key_t iReaderKey;
+static pthread_once_t sReaderOnce = PTHREAD_ONCE_INIT;
+static int iReaderKeyValid = 0;
+
+/*-------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey. The key is consumed a whole size_t
+   word at a time (MurmurHash2 mixing), so a long key costs one
+   multiply per word on the serial path instead of one per byte. */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+	size_t uLength;
+	size_t uTail;
+	size_t uWord;
+	size_t uHash;
+	const char *pcEnd;
+
+	assert(pcKey != NULL);
+
+	uLength = strlen(pcKey);
+	uTail = uLength % sizeof(size_t);
+	uHash = uLength * HASH_MIX;
+
+	/* Mix in each whole word, then the last few bytes, then
+	   avalanche. */
+	for (pcEnd = pcKey + (uLength - uTail); pcKey != pcEnd;
+		pcKey += sizeof(size_t))
+	{
+		memcpy(&uWord, pcKey, sizeof(size_t));
+		uWord *= HASH_MIX;
+		uWord ^= uWord >> HASH_SHIFT;
+		uWord *= HASH_MIX;
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+	if (uTail != 0)
+	{
+		uWord = 0;
+		memcpy(&uWord, pcKey, uTail);
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+	uHash ^= uHash >> HASH_SHIFT;
+	uHash *= HASH_MIX;
+	uHash ^= uHash >> HASH_SHIFT;
+	return uHash;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey under oSymTable's hash function,
+   already multiplied by HASH_FIBONACCI so that its top bits give the
+   stripe and the bucket of pcKey. */
+
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+
+	if (oSymTable->pfHash != NULL)
+		return (*oSymTable->pfHash)(pcKey) * HASH_FIBONACCI;
+	return SymTable_hash(pcKey) * HASH_FIBONACCI;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Give the reader record pvReader of an exiting thread back for
+   reuse. */
+
+static void SymTable_releaseReader(void *pvReader)
+{
+	struct Reader *psReader = (struct Reader *)pvReader;
+
+	assert(psReader != NULL);
+
+	__atomic_store_n(&psReader->uActive, 0, __ATOMIC_RELEASE);
+	pthread_mutex_lock(&sReaderLock);
+	psReader->iInUse = 0;
+	pthread_mutex_unlock(&sReaderLock);
+}
+
+/* Create the key under which threads keep their reader records. */
+
+static void SymTable_createReaderKey(void)
+{
+	iReaderKeyValid =
+		pthread_key_create(&iReaderKey, SymTable_releaseReader) == 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Start a lookup that takes no lock: announce the current epoch in
+   the calling thread's reader record, registering one first if the
+   thread has none. Return the record, or NULL if insufficient memory
+   is available, in which case the caller must lock the stripe
+   instead. */
+
+static struct Reader *SymTable_enter(void)
+{
+	struct Reader *psReader;
+	void *pvReader;
+
+	pthread_once(&sReaderOnce, SymTable_createReaderKey);
+	if (! iReaderKeyValid) return NULL;
+
+	psReader = (struct Reader *)pthread_getspecific(iReaderKey);
+	if (psReader == NULL)
+	{
+	/* Reuse the record of an exited thread, or add a new one. */
+		pthread_mutex_lock(&sReaderLock);
+		for (psReader = psReaders; psReader != NULL;
+			psReader = psReader->psNext)
+			if (! psReader->iInUse) break;
+		if (psReader == NULL &&
+			posix_memalign(&pvReader, CACHE_LINE,
+				sizeof(union PaddedReader)) == 0)
+		{
+			psReader = &((union PaddedReader *)pvReader)->sReader;
+			psReader->uActive = 0;
+			psReader->psNext = psReaders;
+			__atomic_store_n(&psReaders, psReader, __ATOMIC_RELEASE);
+		}
+		if (psReader != NULL)
+		{
+			psReader->iInUse = 1;
+			psReader->uDepth = 0;
+		}
+		pthread_mutex_unlock(&sReaderLock);
+		if (psReader == NULL) return NULL;
+		if (pthread_setspecific(iReaderKey, psReader) != 0)
+		{
+			SymTable_releaseReader(psReader);
+			return NULL;
+		}
+	}
+
+	/* The fence orders the announcement before every load of the
+	   lookup, against the fence in SymTable_advance: either the
+	   advancing thread sees the announcement, or this thread sees
+	   every unlink made before the epoch it read. */
+	if (psReader->uDepth++ == 0)
+	{
+		__atomic_store_n(&psReader->uActive,
+			__atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED) * 2 + 1,
+			__ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+	return psReader;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* End a lookup that SymTable_enter started with psReader. */
+
+static void SymTable_leave(struct Reader *psReader)
+{
+	assert(psReader != NULL);
+	assert(psReader->uDepth > 0);
+
+	if (--psReader->uDepth == 0)
+		__atomic_store_n(&psReader->uActive, 0, __ATOMIC_RELEASE);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Advance the global epoch by one if no thread is in a lookup that
+   started in an earlier epoch. Called by writers after retiring
+   memory; readers never call it. Return 1 if the epoch has moved on
+   since the call began, here or in another thread, or 0 if a reader
+   held it back. */
+
+static int SymTable_advance(void)
+{
+	struct Reader *psReader;
+	size_t uEpoch;
+	size_t uActive;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED);
+	for (psReader = __atomic_load_n(&psReaders, __ATOMIC_ACQUIRE);
+		psReader != NULL; psReader = psReader->psNext)
+	{
+		uActive = __atomic_load_n(&psReader->uActive, __ATOMIC_RELAXED);
+		if (uActive != 0 && uActive != uEpoch * 2 + 1) return 0;
+	}
+	__atomic_compare_exchange_n(&uGlobalEpoch, &uEpoch, uEpoch + 1, 0,
+		__ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Put psNode, which has just been unlinked from the buckets of
+   psStripe, a stripe of oSymTable, on the stripe's limbo list for
+   the current epoch. If that list still holds nodes from LIMBO_COUNT
+   or more epochs ago, free them first. The caller must hold
+   psStripe's mutex. */
+
+static void SymTable_retireNode(SymTable_T oSymTable,
+	struct Stripe *psStripe, struct Node *psNode)
+{
+	size_t uEpoch;
+	size_t uList;
+
+	assert(oSymTable != NULL);
+	assert(psStripe != NULL);
+	assert(psNode != NULL);
+
+	/* The fence orders the unlink before the epoch is read, so that a
+	   reader which can still reach psNode announced that epoch or the
+	   one before it. */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED);
+	uList = uEpoch % LIMBO_COUNT;
+	if (psStripe->auLimboEpoch[uList] != uEpoch)
+	{
+		SymTable_freeLimbo(psStripe, uList);
+		psStripe->auLimboEpoch[uList] = uEpoch;
+	}
+	psNode->psRetired = psStripe->apsLimbo[uList];
+	psStripe->apsLimbo[uList] = psNode;
+	psStripe->auLimboBytes[uList] += sizeof(struct Node) +
+		(oSymTable->iBorrowKeys ? 0 : strlen(psNode->pcKey) + 1);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Free every node on limbo list uList of psStripe and empty it. The
+   caller must hold psStripe's mutex, or be SymTable_free. */
+
+static void SymTable_freeLimbo(struct Stripe *psStripe, size_t uList)
+{
+	struct Node *psCurr;
+	struct Node *psNext;
+
+	assert(psStripe != NULL);
+	assert(uList < LIMBO_COUNT);
+
+	for (psCurr = psStripe->apsLimbo[uList]; psCurr != NULL;
+		psCurr = psNext)
+	{
+		psNext = psCurr->psRetired;
+		free(psCurr);
+	}
+	psStripe->apsLimbo[uList] = NULL;
+	psStripe->auLimboBytes[uList] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Record that a grow or clear of oSymTable retired memory in epoch
+   uEpoch, so that writers sweep the table once all of it may be
+   freed. Keeps the later of this and any sweep already due. */
+
+static void SymTable_setReclaim(SymTable_T oSymTable, size_t uEpoch)
+{
+	size_t uOld;
+
+	assert(oSymTable != NULL);
+
+	uEpoch += LIMBO_COUNT;
+	uOld = __atomic_load_n(&oSymTable->uReclaimEpoch, __ATOMIC_RELAXED);
+	while (uOld < uEpoch &&
+		! __atomic_compare_exchange_n(&oSymTable->uReclaimEpoch, &uOld,
+			uEpoch, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Advance the global epoch as far as readers allow, up to LIMBO_COUNT
+   times, then free every limbo list of oSymTable filled LIMBO_COUNT
+   or more epochs ago and every bucket array retired two or more
+   epochs ago. Without readers in the way, this frees everything
+   retired so far. The caller must hold every stripe. */
+
+static void SymTable_reclaim(SymTable_T oSymTable)
+{
+	struct Stripe *psStripe;
+	struct Table **ppsRetired;
+	struct Table *psTable;
+	size_t uReclaim;
+	size_t uEpoch;
+	size_t uStripe;
+	size_t uList;
+
+	assert(oSymTable != NULL);
+
+	for (uList = 0; uList < LIMBO_COUNT; uList++)
+		if (! SymTable_advance()) break;
+	uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_ACQUIRE);
+
+	for (uStripe = 0; uStripe < STRIPE_COUNT; uStripe++)
+	{
+		psStripe = &oSymTable->psStripes[uStripe].sStripe;
+		for (uList = 0; uList < LIMBO_COUNT; uList++)
+			if (psStripe->apsLimbo[uList] != NULL &&
+				psStripe->auLimboEpoch[uList] + LIMBO_COUNT <= uEpoch)
+				SymTable_freeLimbo(psStripe, uList);
+	}
+	for (ppsRetired = &oSymTable->psRetiredTables; *ppsRetired != NULL; )
+	{
+		if ((*ppsRetired)->uRetireEpoch + 2 > uEpoch)
+		{
+			ppsRetired = &(*ppsRetired)->psRetired;
+			continue;
+		}
+		psTable = *ppsRetired;
+		*ppsRetired = psTable->psRetired;
+		free(psTable);
+	}
+
+	/* Everything that the last grow or clear retired is gone once
+	   its epoch is reached. A clear may have asked for a later sweep
+	   meanwhile, so only clear the epoch that was read. */
+	uReclaim = __atomic_load_n(&oSymTable->uReclaimEpoch,
+		__ATOMIC_RELAXED);
+	if (uReclaim != 0 && uReclaim <= uEpoch)
+		__atomic_compare_exchange_n(&oSymTable->uReclaimEpoch, &uReclaim,
+			0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* If a grow or clear of oSymTable left memory that readers could
+   still hold, advance the global epoch, and sweep the table with
+   SymTable_reclaim once that memory may be freed. Cheap when nothing
+   is waiting. The caller must not hold any stripe. */
+
+static void SymTable_tryReclaim(SymTable_T oSymTable)
+{
+	size_t uReclaim;
+
+	assert(oSymTable != NULL);
+
+	uReclaim = __atomic_load_n(&oSymTable->uReclaimEpoch,
+		__ATOMIC_RELAXED);
+	if (uReclaim == 0) return;
+	(void)SymTable_advance();
+	if (__atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED) < uReclaim)
+		return;
+	SymTable_lockAll(oSymTable);
+	SymTable_reclaim(oSymTable);
+	SymTable_unlockAll(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+	SymTable_T oSymTable;
+	struct Table *psTable;
+	void *pvStripes;
+	size_t uStripe;
+
+	/* Allocate memory and return NULL if it is unsufficient. */
+	oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+	if (oSymTable == NULL) return NULL;
+	if (posix_memalign(&pvStripes, CACHE_LINE,
+		STRIPE_COUNT * sizeof(union PaddedStripe)) != 0)
+	{
+		free(oSymTable);
+		return NULL;
+	}
+	psTable = (struct Table *)calloc(1, sizeof(struct Table) +
+		((size_t)1 << INITIAL_LENGTH_LOG) * sizeof(struct Node *));
+	if (psTable == NULL)
+	{
+		free(pvStripes);
+		free(oSymTable);
+		return NULL;
+	}
+
+	/* Initiate SymTable variables and the stripes. */
+	psTable->uPhysLength = (size_t)1 << INITIAL_LENGTH_LOG;
+	psTable->uShift = HASH_BITS - INITIAL_LENGTH_LOG;
+	oSymTable->psTable = psTable;
+	oSymTable->psRetiredTables = NULL;
+	oSymTable->psStripes = (union PaddedStripe *)pvStripes;
+	oSymTable->uResizeCount = 0;
+	oSymTable->pfHash = NULL;
+	oSymTable->iBorrowKeys = 0;
+	oSymTable->uReclaimEpoch = 0;
+	memset(pvStripes, 0, STRIPE_COUNT * sizeof(union PaddedStripe));
+	for (uStripe = 0; uStripe < STRIPE_COUNT; uStripe++)
+		pthread_mutex_init(&oSymTable->psStripes[uStripe].sStripe.sLock,
+			NULL);
+
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	SymTable_T oSymTable;
+
+	assert(pfHash != NULL);
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->pfHash = pfHash;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	if (! SymTable_reserve(oSymTable, uCapacity))
+	{
+		SymTable_free(oSymTable);
+		return NULL;
+	}
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* A put grows the table once any one stripe holds more bindings than
+   it has buckets, so uCapacity bindings spread over the stripes need
+   room for the fullest stripe, not just the average one. Give each
+   stripe its share plus four times a power of two at least the
+   square root of that share, several standard deviations for keys
+   that hash uniformly, and grow to that in one step. */
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	size_t uShare;
+	size_t uRoot;
+	size_t uShift;
+	int iSuccessful = 1;
+
+	assert(oSymTable != NULL);
+
+	uShare = uCapacity / STRIPE_COUNT + 1;
+	for (uRoot = 1; uRoot < uShare / uRoot; uRoot *= 2)
+		;
+	if (uShare > ((size_t)-1 >> STRIPE_LOG) - 4 * uRoot) return 0;
+	uShare += 4 * uRoot;
+
+	SymTable_lockAll(oSymTable);
+	uShift = oSymTable->psTable->uShift;
+	while (uShift > 1 &&
+		((size_t)1 << (HASH_BITS - uShift - STRIPE_LOG)) < uShare)
+		uShift--;
+	if (((size_t)1 << (HASH_BITS - uShift - STRIPE_LOG)) < uShare)
+		iSuccessful = 0;
+	else if (uShift < oSymTable->psTable->uShift)
+		iSuccessful = SymTable_grow(oSymTable, uShift);
+	SymTable_reclaim(oSymTable);
+	SymTable_unlockAll(oSymTable);
+	return iSuccessful;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+	struct Node **ppsBuckets;
+	struct Node *psCurr;
+	struct Node *psNext;
+	struct Table *psTable;
+	struct Stripe *psStripe;
+	size_t uIndex;
+	size_t uList;
+
+	assert(oSymTable != NULL);
+
+	/* Free every linked node, whose key copy shares its
+	   allocation, then every retired node and bucket array. No
+	   other thread may be using the table any more. */
+	ppsBuckets = (struct Node **)(oSymTable->psTable + 1);
+	for (uIndex = 0; uIndex < oSymTable->psTable->uPhysLength; uIndex++)
+	{
+		for (psCurr = ppsBuckets[uIndex]; psCurr != NULL;
+			psCurr = psNext)
+		{
+			psNext = psCurr->psNext;
+			free(psCurr);
+		}
+	}
+	for (uIndex = 0; uIndex < STRIPE_COUNT; uIndex++)
+	{
+		psStripe = &oSymTable->psStripes[uIndex].sStripe;
+		for (uList = 0; uList < LIMBO_COUNT; uList++)
+			SymTable_freeLimbo(psStripe, uList);
+		pthread_mutex_destroy(&psStripe->sLock);
+	}
+	while (oSymTable->psRetiredTables != NULL)
+	{
+		psTable = oSymTable->psRetiredTables;
+		oSymTable->psRetiredTables = psTable->psRetired;
+		free(psTable);
+	}
+	free(oSymTable->psStripes);
+	free(oSymTable->psTable);
+	free(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+	size_t uStripe;
+	size_t uLength = 0;
+
+	assert(oSymTable != NULL);
+
+	/* Sum the stripes' counts without locking them. While other
+	   threads are changing the table the sum is only a snapshot. */
+	for (uStripe = 0; uStripe < STRIPE_COUNT; uStripe++)
+		uLength += __atomic_load_n(
+			&oSymTable->psStripes[uStripe].sStripe.uCount,
+			__ATOMIC_RELAXED);
+	return uLength;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the node holding pcKey, whose hash code is uHash, or NULL
+   if there is none. Takes no lock: the caller must be between
+   SymTable_enter and SymTable_leave, or hold the key's stripe. Every
+   pointer is loaded with acquire semantics, matching the release
+   stores that publish nodes and bucket arrays. */
+
+static struct Node *SymTable_find(SymTable_T oSymTable,
+	const char *pcKey, size_t uHash)
+{
+	struct Table *psTable;
+	struct Node *psCurr;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psTable = __atomic_load_n(&oSymTable->psTable, __ATOMIC_ACQUIRE);
+	for (psCurr = __atomic_load_n(
+		(struct Node **)(psTable + 1) + (uHash >> psTable->uShift),
+		__ATOMIC_ACQUIRE); psCurr != NULL;
+		psCurr = __atomic_load_n(&psCurr->psNext, __ATOMIC_ACQUIRE))
+	{
+		if (psCurr->uHash == uHash && strcmp(pcKey, psCurr->pcKey) == 0)
+			return psCurr;
+	}
+	return NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the address of the link (bucket or psNext field) that points
+   to the node holding pcKey, whose hash code is uHash, or the address
+   of the NULL link that ends its bucket if there is no such node. The
+   caller must hold the key's stripe, so no link can change. */
+
+static struct Node **SymTable_findLink(SymTable_T oSymTable,
+	const char *pcKey, size_t uHash)
+{
+	struct Node **ppsLink;
+	struct Node *psCurr;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	for (ppsLink = (struct Node **)(oSymTable->psTable + 1) +
+		(uHash >> oSymTable->psTable->uShift);
+		(psCurr = *ppsLink) != NULL; ppsLink = &psCurr->psNext)
+	{
+		if (psCurr->uHash == uHash && strcmp(pcKey, psCurr->pcKey) == 0)
+			break;
+	}
+	return ppsLink;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return a new unlinked node holding pvValue, uHash and a copy of
+   pcKey, or pcKey itself if oSymTable borrows keys. Return NULL if
+   insufficient memory is available. */
+
+static struct Node *SymTable_newNode(SymTable_T oSymTable,
+	const char *pcKey, const void *pvValue, size_t uHash)
+{
+	struct Node *psNode;
+	size_t uSize;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uSize = oSymTable->iBorrowKeys ? 0 : strlen(pcKey) + 1;
+	psNode = (struct Node *)malloc(sizeof(struct Node) + uSize);
+	if (psNode == NULL) return NULL;
+	if (oSymTable->iBorrowKeys)
+		psNode->pcKey = pcKey;
+	else
+	{
+		memcpy(psNode + 1, pcKey, uSize);
+		psNode->pcKey = (const char *)(psNode + 1);
+	}
+	psNode->uHash = uHash;
+	psNode->pvValue = (void *)pvValue;
+	psNode->psNext = NULL;
+	psNode->psRetired = NULL;
+	return psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Lock every stripe of oSymTable. Locks are always taken in stripe
+   order, so two threads doing this cannot deadlock. */
+
+static void SymTable_lockAll(SymTable_T oSymTable)
+{
+	size_t uStripe;
+
+	assert(oSymTable != NULL);
+
+	for (uStripe = 0; uStripe < STRIPE_COUNT; uStripe++)
+		pthread_mutex_lock(&oSymTable->psStripes[uStripe].sStripe.sLock);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Unlock every stripe of oSymTable. */
+
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+	size_t uStripe;
+
+	assert(oSymTable != NULL);
+
+	for (uStripe = STRIPE_COUNT; uStripe > 0; uStripe--)
+		pthread_mutex_unlock(
+			&oSymTable->psStripes[uStripe - 1].sStripe.sLock);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Double the number of buckets of oSymTable if stripe uStripe holds
+   more bindings than buckets, then free what readers no longer hold.
+   The caller must not hold any stripe. */
+
+static void SymTable_resize(SymTable_T oSymTable, size_t uStripe)
+{
+	struct Table *psOld;
+
+	assert(oSymTable != NULL);
+
+	/* Check again with every stripe locked, in case another thread
+	   resized first. Keep the current array if there is insufficient
+	   memory. */
+	SymTable_lockAll(oSymTable);
+	psOld = oSymTable->psTable;
+	if (oSymTable->psStripes[uStripe].sStripe.uCount >
+		psOld->uPhysLength >> STRIPE_LOG && psOld->uShift > 1)
+		(void)SymTable_grow(oSymTable, psOld->uShift - 1);
+	SymTable_reclaim(oSymTable);
+	SymTable_unlockAll(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Replace the bucket array of oSymTable, whose stripes the caller
+   holds, with one of 2^(HASH_BITS - uShift) buckets, more than it has
+   now. Readers may still be walking the old chains, so every node is
+   copied into the new array instead of relinked; the new array is
+   published with one release store, and the old nodes and array are
+   retired for SymTable_reclaim to free. Old bucket i spreads over a
+   contiguous range of new buckets, which belong to the same stripe.
+   Return 1 on success, or 0 (leaving oSymTable unchanged) if the
+   size would overflow or insufficient memory is available. */
+
+static int SymTable_grow(SymTable_T oSymTable, size_t uShift)
+{
+	struct Table *psOld;
+	struct Table *psNew;
+	struct Node **ppsOldBuckets;
+	struct Node **ppsNewBuckets;
+	struct Node *psCurr;
+	struct Node *psCopy;
+	struct Node *psNext;
+	size_t uNewLength;
+	size_t uEpoch;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+
+	psOld = oSymTable->psTable;
+	assert(uShift < psOld->uShift);
+	uNewLength = (size_t)1 << (HASH_BITS - uShift);
+	if (uNewLength > ((size_t)-1 - sizeof(struct Table)) /
+		sizeof(struct Node *))
+		return 0;
+
+	psNew = (struct Table *)calloc(1, sizeof(struct Table) +
+		uNewLength * sizeof(struct Node *));
+	if (psNew == NULL) return 0;
+	psNew->uPhysLength = uNewLength;
+	psNew->uShift = uShift;
+	psNew->psRetired = NULL;
+
+	/* Copy each node to the front of its new bucket. On failure, free
+	   the copies made so far. */
+	ppsOldBuckets = (struct Node **)(psOld + 1);
+	ppsNewBuckets = (struct Node **)(psNew + 1);
+	for (uIndex = 0; uIndex < psOld->uPhysLength; uIndex++)
+	{
+		for (psCurr = ppsOldBuckets[uIndex]; psCurr != NULL;
+			psCurr = psCurr->psNext)
+		{
+			psCopy = SymTable_newNode(oSymTable, psCurr->pcKey,
+				psCurr->pvValue, psCurr->uHash);
+			if (psCopy == NULL) break;
+			psCopy->psNext = ppsNewBuckets[psCurr->uHash >> uShift];
+			ppsNewBuckets[psCurr->uHash >> uShift] = psCopy;
+		}
+		if (psCurr != NULL)
+		{
+			for (uIndex = 0; uIndex < uNewLength; uIndex++)
+				for (psCurr = ppsNewBuckets[uIndex]; psCurr != NULL;
+					psCurr = psNext)
+				{
+					psNext = psCurr->psNext;
+					free(psCurr);
+				}
+			free(psNew);
+			return 0;
+		}
+	}
+
+	/* Publish the new array, then retire the old one and its
+	   nodes. */
+	__atomic_store_n(&oSymTable->psTable, psNew, __ATOMIC_RELEASE);
+	for (uIndex = 0; uIndex < psOld->uPhysLength; uIndex++)
+		for (psCurr = ppsOldBuckets[uIndex]; psCurr != NULL;
+			psCurr = psNext)
+		{
+			psNext = psCurr->psNext;
+			SymTable_retireNode(oSymTable,
+				&oSymTable->psStripes[uIndex >> (HASH_BITS -
+				STRIPE_LOG - psOld->uShift)].sStripe, psCurr);
+		}
+	uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_ACQUIRE);
+	psOld->uRetireEpoch = uEpoch;
+	psOld->psRetired = oSymTable->psRetiredTables;
+	oSymTable->psRetiredTables = psOld;
+	SymTable_setReclaim(oSymTable, uEpoch);
+	oSymTable->uResizeCount++;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Stripe *psStripe;
+	struct Node *psCurr;
+	void *pvOldValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psStripe = &oSymTable->psStripes[
+		uHash >> (HASH_BITS - STRIPE_LOG)].sStripe;
+
+	/* Save & return old value, & overwrite with new value. Readers
+	   load the value atomically, so they see the old or the new. */
+	pthread_mutex_lock(&psStripe->sLock);
+	psCurr = *SymTable_findLink(oSymTable, pcKey, uHash);
+	if (psCurr != NULL)
+	{
+		pvOldValue = psCurr->pvValue;
+		__atomic_store_n(&psCurr->pvValue, (void *)pvValue,
+			__ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&psStripe->sLock);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Stripe *psStripe;
+	struct Reader *psReader;
+	int iFound;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+
+	/* Return 1 if a node's key matches the query key, 0 otherwise.
+	   Lock the stripe only if this thread cannot register as a
+	   reader. */
+	psReader = SymTable_enter();
+	if (psReader != NULL)
+	{
+		iFound = SymTable_find(oSymTable, pcKey, uHash) != NULL;
+		SymTable_leave(psReader);
+		return iFound;
+	}
+	psStripe = &oSymTable->psStripes[
+		uHash >> (HASH_BITS - STRIPE_LOG)].sStripe;
+	pthread_mutex_lock(&psStripe->sLock);
+	iFound = SymTable_find(oSymTable, pcKey, uHash) != NULL;
+	pthread_mutex_unlock(&psStripe->sLock);
+	return iFound;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Stripe *psStripe;
+	struct Reader *psReader;
+	struct Node *psCurr;
+	void *pvValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+
+	/* Return a pointer to the value connected to the query Key.
+	   Lock the stripe only if this thread cannot register as a
+	   reader. */
+	psReader = SymTable_enter();
+	if (psReader != NULL)
+	{
+		psCurr = SymTable_find(oSymTable, pcKey, uHash);
+		if (psCurr != NULL)
+			pvValue = __atomic_load_n(&psCurr->pvValue, __ATOMIC_ACQUIRE);
+		SymTable_leave(psReader);
+		return pvValue;
+	}
+	psStripe = &oSymTable->psStripes[
+		uHash >> (HASH_BITS - STRIPE_LOG)].sStripe;
+	pthread_mutex_lock(&psStripe->sLock);
+	psCurr = SymTable_find(oSymTable, pcKey, uHash);
+	if (psCurr != NULL) pvValue = psCurr->pvValue;
+	pthread_mutex_unlock(&psStripe->sLock);
+	return pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+	struct Stripe *psStripe;
+	struct Table *psTable;
+	struct Node **ppsBuckets;
+	struct Node *psCurr;
+	struct Node *psNext;
+	size_t uStripe;
+	size_t uIndex;
+	size_t uLeft;
+
+	assert(oSymTable != NULL);
+
+	/* Empty one stripe at a time, so that changes to the others can
+	   go on meanwhile. The bucket array cannot be replaced while a
+	   stripe is held. Each chain is unlinked with one release store
+	   and its nodes are retired, since readers may still be on them.
+	   Only occupied buckets are written, and the walk stops at the
+	   stripe's last binding. */
+	for (uStripe = 0; uStripe < STRIPE_COUNT; uStripe++)
+	{
+		psStripe = &oSymTable->psStripes[uStripe].sStripe;
+		pthread_mutex_lock(&psStripe->sLock);
+		psTable = oSymTable->psTable;
+		ppsBuckets = (struct Node **)(psTable + 1);
+		uLeft = psStripe->uCount;
+		for (uIndex = uStripe << (HASH_BITS - STRIPE_LOG - psTable->uShift);
+			uLeft > 0; uIndex++)
+		{
+			psCurr = ppsBuckets[uIndex];
+			if (psCurr == NULL) continue;
+			__atomic_store_n(&ppsBuckets[uIndex], (struct Node *)NULL,
+				__ATOMIC_RELEASE);
+			for ( ; psCurr != NULL; psCurr = psNext)
+			{
+				psNext = psCurr->psNext;
+				SymTable_retireNode(oSymTable, psStripe, psCurr);
+				uLeft--;
+			}
+		}
+		__atomic_store_n(&psStripe->uCount, 0, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&psStripe->sLock);
+	}
+	SymTable_setReclaim(oSymTable,
+		__atomic_load_n(&uGlobalEpoch, __ATOMIC_ACQUIRE));
+	SymTable_tryReclaim(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Stripe *psStripe;
+	struct Node **ppsLink;
+	struct Node *psCurr;
+	void *pvOldValue = NULL;
+	size_t uHash;
+	int iAdvance = 0;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psStripe = &oSymTable->psStripes[
+		uHash >> (HASH_BITS - STRIPE_LOG)].sStripe;
+
+	/* Unlink the query key's Node if there is one. Readers may still
+	   be on it, so retire it instead of freeing it, and try to move
+	   the epoch on once every RETIRE_ADVANCE retirements so that the
+	   stripe's limbo lists can be emptied. */
+	pthread_mutex_lock(&psStripe->sLock);
+	ppsLink = SymTable_findLink(oSymTable, pcKey, uHash);
+	psCurr = *ppsLink;
+	if (psCurr != NULL)
+	{
+		pvOldValue = psCurr->pvValue;
+		__atomic_store_n(ppsLink, psCurr->psNext, __ATOMIC_RELEASE);
+		__atomic_store_n(&psStripe->uCount, psStripe->uCount - 1,
+			__ATOMIC_RELAXED);
+		SymTable_retireNode(oSymTable, psStripe, psCurr);
+		psStripe->uRetired = (psStripe->uRetired + 1) % RETIRE_ADVANCE;
+		iAdvance = psStripe->uRetired == 0;
+	}
+	pthread_mutex_unlock(&psStripe->sLock);
+	if (iAdvance) (void)SymTable_advance();
+	SymTable_tryReclaim(oSymTable);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	struct Stripe *psStripe;
+	struct Node **ppsLink;
+	struct Node *psNode;
+	size_t uHash;
+	size_t uStripe;
+	int iAdded = 0;
+	int iGrow = 0;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	uStripe = uHash >> (HASH_BITS - STRIPE_LOG);
+	psStripe = &oSymTable->psStripes[uStripe].sStripe;
+
+	/* Find the existing node, or publish a complete new one at the
+	   end of the bucket. Grow once this stripe holds more bindings
+	   than buckets; the grow copies the node, and another thread may
+	   remove the key while no lock is held, so look it up or add it
+	   again afterwards. */
+	for (;;)
+	{
+		pthread_mutex_lock(&psStripe->sLock);
+		ppsLink = SymTable_findLink(oSymTable, pcKey, uHash);
+		psNode = *ppsLink;
+		if (psNode == NULL)
+		{
+			psNode = SymTable_newNode(oSymTable, pcKey, pvValue, uHash);
+			if (psNode != NULL)
+			{
+				__atomic_store_n(ppsLink, psNode, __ATOMIC_RELEASE);
+				iAdded = 1;
+				__atomic_store_n(&psStripe->uCount,
+					psStripe->uCount + 1, __ATOMIC_RELAXED);
+				iGrow = psStripe->uCount >
+					oSymTable->psTable->uPhysLength >> STRIPE_LOG;
+			}
+		}
+		pthread_mutex_unlock(&psStripe->sLock);
+		if (psNode == NULL) return NULL;
+		if (! iGrow) break;
+
+		SymTable_resize(oSymTable, uStripe);
+		iGrow = 0;
+	}
+	if (iAdded) SymTable_tryReclaim(oSymTable);
+
+	if (piAdded != NULL) *piAdded = iAdded;
+	return &psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Stripe *psStripe;
+	struct Node **ppsLink;
+	struct Node *psNode;
+	void *pvOldValue = NULL;
+	size_t uHash;
+	size_t uStripe;
+	int iGrow = 0;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	uStripe = uHash >> (HASH_BITS - STRIPE_LOG);
+	psStripe = &oSymTable->psStripes[uStripe].sStripe;
+
+	/* Replace the value in place, or publish a new node, under one
+	   lock so that no other thread sees the key missing in
+	   between. */
+	pthread_mutex_lock(&psStripe->sLock);
+	ppsLink = SymTable_findLink(oSymTable, pcKey, uHash);
+	psNode = *ppsLink;
+	if (psNode != NULL)
+	{
+		pvOldValue = psNode->pvValue;
+		__atomic_store_n(&psNode->pvValue, (void *)pvValue,
+			__ATOMIC_RELEASE);
+	}
+	else
+	{
+		psNode = SymTable_newNode(oSymTable, pcKey, pvValue, uHash);
+		if (psNode != NULL)
+		{
+			__atomic_store_n(ppsLink, psNode, __ATOMIC_RELEASE);
+			__atomic_store_n(&psStripe->uCount, psStripe->uCount + 1,
+				__ATOMIC_RELAXED);
+			iGrow = psStripe->uCount >
+				oSymTable->psTable->uPhysLength >> STRIPE_LOG;
+		}
+	}
+	pthread_mutex_unlock(&psStripe->sLock);
+
+	if (iGrow) SymTable_resize(oSymTable, uStripe);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Reader *psReader;
+	struct Node **ppsBuckets;
+	struct Node *psCurr;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	/* Register as a reader before locking, so that a lookup made by
+	   pfApply nests in this one and never falls back to locking a
+	   stripe this thread already holds. Only a thread that has no
+	   reader record and cannot get one, for want of memory, would
+	   still lock there, and deadlock. */
+	psReader = SymTable_enter();
+
+	/* Traverse all the buckets with every stripe locked, so the
+	   traversal sees one consistent table, and apply function
+	   pfApply to each key, value, and extra value if present */
+	SymTable_lockAll(oSymTable);
+	ppsBuckets = (struct Node **)(oSymTable->psTable + 1);
+	for (uIndex = 0; uIndex < oSymTable->psTable->uPhysLength; uIndex++)
+	{
+		for (psCurr = ppsBuckets[uIndex]; psCurr != NULL;
+			psCurr = psCurr->psNext)
+			(*pfApply)(psCurr->pcKey, psCurr->pvValue, (void *)pvExtra);
+	}
+	SymTable_unlockAll(oSymTable);
+	if (psReader != NULL) SymTable_leave(psReader);
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* auPos[0] is the next bucket to look at. The table cannot be
+	   resized during the traversal, since it gains no bindings. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = NULL;
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	struct Table *psTable;
+	struct Node *psCurr;
+
+	assert(psIter != NULL);
+
+	/* At the end of a chain, move to the next bucket that is not
+	   empty. Links and values are loaded atomically, as a lookup does,
+	   since other threads may replace values meanwhile. */
+	psCurr = (struct Node *)psIter->pvNext;
+	if (psCurr == NULL)
+	{
+		psTable = __atomic_load_n(&psIter->oSymTable->psTable,
+			__ATOMIC_ACQUIRE);
+		while (psCurr == NULL && psIter->auPos[0] < psTable->uPhysLength)
+			psCurr = __atomic_load_n((struct Node **)(psTable + 1) +
+				psIter->auPos[0]++, __ATOMIC_ACQUIRE);
+		if (psCurr == NULL) return 0;
+	}
+
+	psIter->pvNext = __atomic_load_n(&psCurr->psNext, __ATOMIC_ACQUIRE);
+	if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+	if (ppvValue != NULL)
+		*ppvValue = __atomic_load_n(&psCurr->pvValue, __ATOMIC_ACQUIRE);
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Node **ppsBuckets;
+	struct Node *psCurr;
+	struct Table *psTable;
+	size_t uLimboBytes = 0;
+	size_t uIndex;
+	size_t uList;
+	size_t uLength;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+
+	SymTable_lockAll(oSymTable);
+	psStats->uBuckets = oSymTable->psTable->uPhysLength;
+	psStats->uResizes = oSymTable->uResizeCount;
+
+	/* The nth node of a chain is found with n comparisons. */
+	ppsBuckets = (struct Node **)(oSymTable->psTable + 1);
+	for (uIndex = 0; uIndex < psStats->uBuckets; uIndex++)
+	{
+		uLength = 0;
+		for (psCurr = ppsBuckets[uIndex]; psCurr != NULL;
+			psCurr = psCurr->psNext)
+		{
+			uLength++;
+			psStats->auProbes[uLength < SYMTABLE_PROBE_MAX ?
+				uLength - 1 : SYMTABLE_PROBE_MAX - 1]++;
+			if (! oSymTable->iBorrowKeys)
+				psStats->uKeyBytes += strlen(psCurr->pcKey) + 1;
+		}
+		psStats->uBindings += uLength;
+		if (uLength == 0) continue;
+		psStats->uUsedBuckets++;
+		if (uLength > psStats->uMaxChain) psStats->uMaxChain = uLength;
+	}
+
+	/* Bucket arrays awaiting reclamation still hold memory. */
+	psStats->uTableBytes = sizeof(struct Table) +
+		psStats->uBuckets * sizeof(struct Node *);
+	for (psTable = oSymTable->psRetiredTables; psTable != NULL;
+		psTable = psTable->psRetired)
+		psStats->uTableBytes += sizeof(struct Table) +
+			psTable->uPhysLength * sizeof(struct Node *);
+
+	/* So do retired nodes and their key copies. */
+	for (uIndex = 0; uIndex < STRIPE_COUNT; uIndex++)
+		for (uList = 0; uList < LIMBO_COUNT; uList++)
+			uLimboBytes +=
+				oSymTable->psStripes[uIndex].sStripe.auLimboBytes[uList];
+	SymTable_unlockAll(oSymTable);
+
+	psStats->dLoadFactor = (double)psStats->uBindings /
+		(double)psStats->uBuckets;
+	if (psStats->uUsedBuckets != 0)
+		psStats->dMeanChain = (double)psStats->uBindings /
+			(double)psStats->uUsedBuckets;
+
+	/* The stripes are counted with the structure. */
+	psStats->uStructBytes = sizeof(struct SymTable) +
+		STRIPE_COUNT * sizeof(union PaddedStripe);
+	psStats->uNodeBytes = psStats->uBindings * sizeof(struct Node) +
+		uLimboBytes;
+	psStats->uTotalBytes = psStats->uStructBytes + psStats->uTableBytes +
+		psStats->uNodeBytes + psStats->uKeyBytes;
+}
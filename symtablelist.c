@@ -21,20 +21,34 @@ struct SymTable
 
 	/* variable to store size of st */
 	size_t uCount;
+
+	/* The client's hash function, or NULL if keys are compared with
+	   strcmp alone. */
+	size_t (*pfHash)(const char *pcKey);
+
+	/* 1 if Nodes point to the client's keys instead of copies. */
+	int iBorrowKeys;
 };
 
 /*-------------------------------------------------------------------*/
 
 /* Node is a structure that stores and associates a char Key with 
-   a void value and also maintains a pointer to the next node. */
+   a void value and also maintains a pointer to the next node. The
+   Key's bytes follow the Node in the same allocation. */
 
 struct Node
 {
-	/* Char pointer to hold the Key. */
+	/* Hash code of pcKey under the table's hash function, or 0 if the
+	   table has none. Nodes whose codes differ from the query's are
+	   skipped without a strcmp. */
+	size_t uHash;
+
+	/* Char pointer to hold the Key, which is right after the Node
+	   unless the table borrows its keys. */
 	const char *pcKey;
 
 	/* A void pointer to hold the Value. */
-	const void *pvValue;
+	void *pvValue;
 
 	/* Another Node to hold a pointer to the next Node. */
 	struct Node *psNext;
@@ -51,15 +65,64 @@ SymTable_T SymTable_new(void)
 	oSymTable = (SymTable_T)malloc(uSize);
 	if (oSymTable == NULL) return NULL;
 
-	/* Initiate uCount and psHead. */
+	/* Initiate uCount, psHead, pfHash and iBorrowKeys. */
 	oSymTable->uCount = 0;
 	oSymTable->psHead = NULL;
+	oSymTable->pfHash = NULL;
+	oSymTable->iBorrowKeys = 0;
+
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
 
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	SymTable_T oSymTable;
+
+	assert(pfHash != NULL);
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->pfHash = pfHash;
 	return oSymTable;
 }
 
 /*-------------------------------------------------------------------*/
 
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	/* A list has no array to size; its nodes are allocated one at a
+	   time as bindings are put. */
+	(void)uCapacity;
+	return SymTable_new();
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	assert(oSymTable != NULL);
+
+	/* A list never resizes, so it is always big enough. */
+	(void)uCapacity;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
 void SymTable_free(SymTable_T oSymTable)
 {
 	struct Node *psCurr;
@@ -70,11 +133,10 @@ void SymTable_free(SymTable_T oSymTable)
 	psCurr = oSymTable->psHead;
 
 	/* Traverse list and free the memory associated with 
-	   each Key and Node. */
+	   each Node and its Key. */
 	while (psCurr != NULL)
 	{
 		psNext = psCurr->psNext;
-		free((char *)psCurr->pcKey);
 		free(psCurr);
 		psCurr = psNext;
 	}
@@ -93,36 +155,33 @@ size_t SymTable_getLength(SymTable_T oSymTable)
 
 /*-------------------------------------------------------------------*/
 
+/* Return the hash code of pcKey under oSymTable's hash function, or 0
+   if oSymTable has none. */
+
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	if (oSymTable->pfHash == NULL) return 0;
+	return (*oSymTable->pfHash)(pcKey);
+}
+
+/*-------------------------------------------------------------------*/
+
 int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
 	const void *pvValue)
 {
-	struct Node *psNodePut;
+	int iAdded;
 
 	assert(oSymTable != NULL);
 	assert(pcKey != NULL);
 
-	/* Return 0 if oSymTable already contains pcKey... */
-	if (SymTable_contains(oSymTable, pcKey) == 1) return 0;
-
-	/* ...if not, allocate memory for the node and key in copies
-	   and check to ensure there is suffcient memory. 
-	   Return 0 if not */
-	psNodePut = (struct Node*)malloc(sizeof(struct Node));
-	if (psNodePut == NULL) return 0;
-	psNodePut->pcKey = (const char*)malloc(strlen(pcKey) + 1);
-	if (psNodePut->pcKey == NULL) return 0;
-
-	/* Copy pcKey to the new  Node we are placing, then copy over 
-	   the value and insert the node as the head with a next pointer 
-	   to the old head. */
-	strcpy((char*)psNodePut->pcKey, pcKey);
-	psNodePut->pvValue = pvValue;
-	psNodePut->psNext = oSymTable->psHead;
-	oSymTable->psHead = psNodePut;
-
-	/* Increment binding count of oSymTable. */
-	oSymTable->uCount++;
-	return 1;
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
 }
 
 /*-------------------------------------------------------------------*/
@@ -130,18 +189,20 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey,
 void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
 	const void *pvValue)
 {
+	size_t uHash;
 	struct Node *psCurr;
 	const void *pvOldValue;
 
 	assert (oSymTable != NULL);
 	assert (pcKey != NULL);
 
+	uHash = SymTable_hashKey(oSymTable, pcKey);
 	psCurr = oSymTable->psHead;
 
 	/* Traverse  oSymTable until finding the key that matchs pcKey. */
 	while (psCurr != NULL)
 	{
-		if (strcmp(psCurr->pcKey, pcKey) == 0) 
+		if (psCurr->uHash == uHash && strcmp(psCurr->pcKey, pcKey) == 0)
 		{
 			/* Save & return old value, & overwrite with new value */
 			pvOldValue = psCurr->pvValue;
@@ -157,18 +218,21 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 {
+	size_t uHash;
 	struct Node *psCurr;
 
 	assert(oSymTable != NULL); 
 	assert(pcKey != NULL);
 
+	uHash = SymTable_hashKey(oSymTable, pcKey);
 	psCurr = oSymTable->psHead;
 
 	/* Traverse list and return 1 if a key in the table matches the 
 	   query key. */
 	while (psCurr != NULL)
 	{
-		if (strcmp(pcKey, psCurr->pcKey) == 0) return 1; 
+		if (psCurr->uHash == uHash && strcmp(pcKey, psCurr->pcKey) == 0)
+			return 1;
 		psCurr = psCurr->psNext;
 	}
 
@@ -178,18 +242,20 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 {
+	size_t uHash;
 	struct Node *psCurr;
 
 	assert(oSymTable != NULL);
 	assert(pcKey != NULL);
 
+	uHash = SymTable_hashKey(oSymTable, pcKey);
 	psCurr = oSymTable->psHead;
 
 	/* Traverse oSymbolTable and return a pointer to the value
 	   connected to the query Key */
 	while(psCurr != NULL)
 	{
-		if (strcmp(psCurr->pcKey, pcKey) == 0) 
+		if (psCurr->uHash == uHash && strcmp(psCurr->pcKey, pcKey) == 0)
 			return (void *)psCurr->pvValue;
 		psCurr = psCurr->psNext;
 	}
@@ -198,8 +264,29 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 
 /*-------------------------------------------------------------------*/
 
+void SymTable_clear(SymTable_T oSymTable)
+{
+	struct Node *psCurr;
+	struct Node *psNext;
+
+	assert(oSymTable != NULL);
+
+	/* A list has no array to keep, and each Node and its Key is its
+	   own allocation, so free them as SymTable_free does. */
+	for (psCurr = oSymTable->psHead; psCurr != NULL; psCurr = psNext)
+	{
+		psNext = psCurr->psNext;
+		free(psCurr);
+	}
+	oSymTable->psHead = NULL;
+	oSymTable->uCount = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 {
+	size_t uHash;
 	struct Node *psCurr;
 	struct Node *psPrev;
 	const void *pvOldValue;
@@ -212,12 +299,13 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 
 	/* Special case if removed Node is the head of the list.
 	   Retrun removed value. */
-	if (strcmp(pcKey, oSymTable->psHead->pcKey) == 0)
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	if (oSymTable->psHead->uHash == uHash &&
+		strcmp(pcKey, oSymTable->psHead->pcKey) == 0)
 	{
 		psCurr = oSymTable->psHead;
 		pvOldValue = psCurr->pvValue;
 		oSymTable->psHead = oSymTable->psHead->psNext;
-		free((char *)psCurr->pcKey);
 		free(psCurr);
 		oSymTable->uCount--;
 		return (void *)pvOldValue;
@@ -231,11 +319,10 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 	   Return removed value */
 	while (psCurr != NULL)
 	{
-		if (strcmp(pcKey, psCurr->pcKey) == 0)
+		if (psCurr->uHash == uHash && strcmp(pcKey, psCurr->pcKey) == 0)
 		{	
 			pvOldValue = psCurr->pvValue;
 			psPrev->psNext = psCurr->psNext;
-			free((char *)psCurr->pcKey);
 			free(psCurr);
 			oSymTable->uCount--;
 			return (void *) pvOldValue;
@@ -248,6 +335,80 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 
 /*-------------------------------------------------------------------*/
 
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	size_t uHash;
+	size_t uSize;
+	struct Node *psCurr;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+
+	/* Traverse list once and return the address of the value
+	   connected to the query Key if there is one. */
+	for (psCurr = oSymTable->psHead; psCurr != NULL;
+		psCurr = psCurr->psNext)
+	{
+		if (psCurr->uHash == uHash && strcmp(psCurr->pcKey, pcKey) == 0)
+		{
+			if (piAdded != NULL) *piAdded = 0;
+			return &psCurr->pvValue;
+		}
+	}
+
+	/* Otherwise allocate memory for the node and its key copy
+	   together, so that comparing the key reads the node's own
+	   memory, and return NULL if there is insufficient memory. A
+	   table that borrows its keys needs no copy. */
+	uSize = oSymTable->iBorrowKeys ? 0 : strlen(pcKey) + 1;
+	psCurr = (struct Node*)malloc(sizeof(struct Node) + uSize);
+	if (psCurr == NULL) return NULL;
+
+	/* Copy pcKey and the value to the new Node and insert it as the
+	   head with a next pointer to the old head. */
+	if (oSymTable->iBorrowKeys) psCurr->pcKey = pcKey;
+	else
+	{
+		memcpy(psCurr + 1, pcKey, uSize);
+		psCurr->pcKey = (const char*)(psCurr + 1);
+	}
+	psCurr->pvValue = (void *)pvValue;
+	psCurr->uHash = uHash;
+	psCurr->psNext = oSymTable->psHead;
+	oSymTable->psHead = psCurr;
+
+	/* Increment binding count of oSymTable. */
+	oSymTable->uCount++;
+	if (piAdded != NULL) *piAdded = 1;
+	return &psCurr->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	void **ppvValue;
+	void *pvOldValue;
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded);
+	if (ppvValue == NULL || iAdded) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = *ppvValue;
+	*ppvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
 void SymTable_map(SymTable_T oSymTable,
 	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
 	const void *pvExtra)
@@ -263,10 +424,79 @@ void SymTable_map(SymTable_T oSymTable,
 	   value, and extra value if present */
 	while (psCurr != NULL)
 	{
-		(*pfApply)(psCurr->pcKey, (void *)psCurr->pvValue, 
-			(void *)pvExtra);
+		(*pfApply)(psCurr->pcKey, psCurr->pvValue, (void *)pvExtra);
 		psCurr = psCurr->psNext;
 	}
 }
 
 
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* Start at the head of the list. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = oSymTable->psHead;
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	struct Node *psCurr;
+
+	assert(psIter != NULL);
+
+	/* Hand out the next node and step past it. */
+	psCurr = (struct Node *)psIter->pvNext;
+	if (psCurr == NULL) return 0;
+	psIter->pvNext = psCurr->psNext;
+	if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+	if (ppvValue != NULL) *ppvValue = psCurr->pvValue;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Node *psCurr;
+	size_t uProbes;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+
+	/* The whole list is one bucket, and its one chain. */
+	psStats->uBindings = oSymTable->uCount;
+	psStats->uBuckets = 1;
+	psStats->uUsedBuckets = oSymTable->uCount != 0;
+	psStats->dLoadFactor = (double)oSymTable->uCount;
+	psStats->uMaxChain = oSymTable->uCount;
+	psStats->dMeanChain = (double)oSymTable->uCount;
+	psStats->uStructBytes = sizeof(struct SymTable);
+
+	/* The nth node from the head is found with n comparisons. */
+	for (psCurr = oSymTable->psHead, uProbes = 0; psCurr != NULL;
+		psCurr = psCurr->psNext)
+	{
+		if (uProbes < SYMTABLE_PROBE_MAX) uProbes++;
+		psStats->auProbes[uProbes - 1]++;
+		psStats->uNodeBytes += sizeof(struct Node);
+		if (! oSymTable->iBorrowKeys)
+			psStats->uKeyBytes += strlen(psCurr->pcKey) + 1;
+	}
+
+	psStats->uTotalBytes = psStats->uStructBytes + psStats->uNodeBytes +
+		psStats->uKeyBytes;
+}
@@ -0,0 +1,700 @@
+/*-------------------------------------------------------------------*/
+/* symtableprobe.c                                                   */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+#include <string.h>
+#include "symtable.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <limits.h>
+
+/*-------------------------------------------------------------------*/
+
+/* Multiplier and shift of the built-in hash function, sized to the
+   width of size_t. */
+#if ULONG_MAX > 0xffffffffUL
+#define HASH_MIX ((size_t)0xc6a4a7935bd1e995UL)
+#define HASH_SHIFT 47
+#else
+#define HASH_MIX ((size_t)0x5bd1e995UL)
+#define HASH_SHIFT 24
+#endif
+
+/*-------------------------------------------------------------------*/
+
+/* Number of slots in a new table. Always a power of two so that a
+   hash code can be reduced to a slot index with a mask. */
+enum {INITIAL_PHYS_LENGTH = 64};
+
+/* The table grows once more than MAX_LOAD_NUM/MAX_LOAD_DEN of its
+   slots are occupied. Linear probing degrades quickly past that. */
+enum {MAX_LOAD_NUM = 3, MAX_LOAD_DEN = 4};
+
+/*-------------------------------------------------------------------*/
+
+/* Special function to create full-width size_t hash codes for
+   pcKey. */
+static size_t SymTable_hash(const char *pcKey);
+
+/* Special function to hash pcKey with the hash function of
+   oSymTable. */
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey);
+
+/* Special function to find the slot that holds pcKey, or the empty
+   slot where pcKey would be placed. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+	size_t uHash);
+
+/* Special function to move the table into an array of uNewLength
+   slots. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewLength);
+
+/*-------------------------------------------------------------------*/
+
+/* Slot is a structure that stores and associates a char Key with a
+   void value directly inside the table's slot array, so that a probe
+   sequence walks contiguous memory instead of chasing pointers. */
+
+struct Slot
+{
+	/* Full hash code of pcKey, compared before any strcmp. */
+	size_t uHash;
+
+	/* Char pointer to hold the Key, or NULL if the slot is empty. */
+	const char *pcKey;
+
+	/* A void pointer to hold the Value. */
+	void *pvValue;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain a counter for the number of
+   bindings in a Symbol Table and the flat array of slots that holds
+   those bindings. */
+
+struct SymTable
+{
+	/* Count of the bindings contained in the slot array. */
+	size_t uBindCount;
+
+	/* Count of slots in the slot array, always a power of two. */
+	size_t uPhysLength;
+
+	/* Number of times the slot array has been grown. */
+	size_t uResizeCount;
+
+	/* The client's hash function, or NULL to use SymTable_hash. */
+	size_t (*pfHash)(const char *pcKey);
+
+	/* 1 if slots point to the client's keys instead of copies. */
+	int iBorrowKeys;
+
+	/* The flat array of slots that underlies the SymTable. */
+	struct Slot *psSlots;
+};
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+	SymTable_T oSymTable;
+
+	/* Allocate memory and return NULL if it is unsufficient. */
+	oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+	if (oSymTable == NULL) return NULL;
+
+	/* Initiate SymTable variables. An all-zero slot is empty. */
+	oSymTable->uBindCount = 0;
+	oSymTable->uPhysLength = INITIAL_PHYS_LENGTH;
+	oSymTable->uResizeCount = 0;
+	oSymTable->pfHash = NULL;
+	oSymTable->iBorrowKeys = 0;
+	oSymTable->psSlots = (struct Slot *)calloc(oSymTable->uPhysLength,
+		sizeof(struct Slot));
+	if (oSymTable->psSlots == NULL)
+	{
+		free(oSymTable);
+		return NULL;
+	}
+
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	SymTable_T oSymTable;
+
+	assert(pfHash != NULL);
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->pfHash = pfHash;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	if (! SymTable_reserve(oSymTable, uCapacity))
+	{
+		SymTable_free(oSymTable);
+		return NULL;
+	}
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Find the smallest power of two of slots that keeps uCapacity
+   bindings within the load limit, and move the table there in one
+   step. Each binding's Key copy is still allocated when it is put,
+   since its length is not known yet. */
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	size_t uNewLength;
+
+	assert(oSymTable != NULL);
+
+	if (uCapacity > ((size_t)-1) / MAX_LOAD_DEN) return 0;
+	uNewLength = oSymTable->uPhysLength;
+	while (uCapacity * MAX_LOAD_DEN > uNewLength * MAX_LOAD_NUM)
+	{
+		if (uNewLength > ((size_t)-1) / 2 / MAX_LOAD_NUM) return 0;
+		uNewLength *= 2;
+	}
+
+	if (uNewLength == oSymTable->uPhysLength) return 1;
+	return SymTable_resize(oSymTable, uNewLength);
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+
+	/* Free the Key of every occupied slot, unless the keys are
+	   borrowed, then the slots. */
+	if (! oSymTable->iBorrowKeys)
+		for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+			free((char *)oSymTable->psSlots[uIndex].pcKey);
+	free(oSymTable->psSlots);
+	free(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	/* Return length count from SymTable structure. */
+	return oSymTable->uBindCount;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey. The key is consumed a whole size_t
+   word at a time (MurmurHash2 mixing), so a long key costs one
+   multiply per word on the serial path instead of one per byte. */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+	size_t uLength;
+	size_t uTail;
+	size_t uWord;
+	size_t uHash;
+	const char *pcEnd;
+
+	assert(pcKey != NULL);
+
+	uLength = strlen(pcKey);
+	uTail = uLength % sizeof(size_t);
+	uHash = uLength * HASH_MIX;
+
+/* Mix in each whole word. The per-word mixing does not depend on
+   uHash, so consecutive words overlap in the pipeline. */
+	for (pcEnd = pcKey + (uLength - uTail); pcKey != pcEnd;
+		pcKey += sizeof(size_t))
+	{
+		memcpy(&uWord, pcKey, sizeof(size_t));
+		uWord *= HASH_MIX;
+		uWord ^= uWord >> HASH_SHIFT;
+		uWord *= HASH_MIX;
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+
+/* Mix in the last few bytes, then avalanche. */
+	if (uTail != 0)
+	{
+		uWord = 0;
+		memcpy(&uWord, pcKey, uTail);
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+	uHash ^= uHash >> HASH_SHIFT;
+	uHash *= HASH_MIX;
+	uHash ^= uHash >> HASH_SHIFT;
+	return uHash;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey under oSymTable's hash function. A
+   client's hash code is avalanched before use, because slot indices
+   come from its low bits alone. */
+
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+
+	if (oSymTable->pfHash == NULL) return SymTable_hash(pcKey);
+
+	uHash = (*oSymTable->pfHash)(pcKey);
+	uHash ^= uHash >> HASH_SHIFT;
+	uHash *= HASH_MIX;
+	uHash ^= uHash >> HASH_SHIFT;
+	return uHash;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Walk the probe sequence for pcKey, whose hash code is uHash, and
+   return the index of the slot holding pcKey, or of the first empty
+   slot if oSymTable does not contain pcKey. The load limit
+   guarantees that an empty slot exists. */
+
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+	size_t uHash)
+{
+	size_t uMask;
+	size_t uIndex;
+	struct Slot *psSlot;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uMask = oSymTable->uPhysLength - 1;
+	for (uIndex = uHash & uMask; ; uIndex = (uIndex + 1) & uMask)
+	{
+		psSlot = &oSymTable->psSlots[uIndex];
+		if (psSlot->pcKey == NULL) return uIndex;
+		if (psSlot->uHash == uHash && strcmp(psSlot->pcKey, pcKey) == 0)
+			return uIndex;
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Move every binding of oSymTable into a slot array of uNewLength
+   slots, a larger power of two. Cached hash codes are reused, so no
+   Key is read. Return 1 on success, or 0 (leaving oSymTable
+   unchanged) if insufficient memory is available. */
+
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewLength)
+{
+	size_t uIndex;
+	size_t uNewIndex;
+	size_t uNewMask;
+	struct Slot *psNewSlots;
+	struct Slot *psSlot;
+
+	assert(oSymTable != NULL);
+	assert(uNewLength > oSymTable->uPhysLength);
+
+	if (uNewLength > ((size_t)-1) / sizeof(struct Slot))
+		return 0;
+	psNewSlots = (struct Slot *)calloc(uNewLength, sizeof(struct Slot));
+	if (psNewSlots == NULL) return 0;
+
+	/* Reinsert each occupied slot at the end of its probe sequence in
+	   the new array. Keys are already unique, so no compare is
+	   needed. */
+	uNewMask = uNewLength - 1;
+	for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+	{
+		psSlot = &oSymTable->psSlots[uIndex];
+		if (psSlot->pcKey == NULL) continue;
+		uNewIndex = psSlot->uHash & uNewMask;
+		while (psNewSlots[uNewIndex].pcKey != NULL)
+			uNewIndex = (uNewIndex + 1) & uNewMask;
+		psNewSlots[uNewIndex] = *psSlot;
+	}
+
+	free(oSymTable->psSlots);
+	oSymTable->psSlots = psNewSlots;
+	oSymTable->uPhysLength = uNewLength;
+	oSymTable->uResizeCount++;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Slot *psSlot;
+	void *pvOldValue;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psSlot = &oSymTable->psSlots[SymTable_find(oSymTable, pcKey,
+		SymTable_hashKey(oSymTable, pcKey))];
+	if (psSlot->pcKey == NULL) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = psSlot->pvValue;
+	psSlot->pvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uIndex = SymTable_find(oSymTable, pcKey,
+		SymTable_hashKey(oSymTable, pcKey));
+	return oSymTable->psSlots[uIndex].pcKey != NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uIndex = SymTable_find(oSymTable, pcKey,
+		SymTable_hashKey(oSymTable, pcKey));
+	return oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+	size_t uIndex;
+	size_t uLeft;
+	struct Slot *psSlot;
+
+	assert(oSymTable != NULL);
+
+	/* Free the Key of every occupied slot, unless it is borrowed,
+	   and empty it, keeping the slot array. Stop at the last binding
+	   rather than the end of the array. */
+	uLeft = oSymTable->uBindCount;
+	for (uIndex = 0; uLeft > 0; uIndex++)
+	{
+		psSlot = &oSymTable->psSlots[uIndex];
+		if (psSlot->pcKey == NULL) continue;
+		if (! oSymTable->iBorrowKeys) free((char *)psSlot->pcKey);
+		psSlot->pcKey = NULL;
+		psSlot->pvValue = NULL;
+		uLeft--;
+	}
+	oSymTable->uBindCount = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+	size_t uMask;
+	size_t uHole;
+	size_t uIndex;
+	size_t uHome;
+	void *pvOldValue;
+	struct Slot *psSlots;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return NULL if oSymTable does not contain pcKey. */
+	psSlots = oSymTable->psSlots;
+	uHole = SymTable_find(oSymTable, pcKey,
+		SymTable_hashKey(oSymTable, pcKey));
+	if (psSlots[uHole].pcKey == NULL) return NULL;
+
+	pvOldValue = psSlots[uHole].pvValue;
+	if (! oSymTable->iBorrowKeys) free((char *)psSlots[uHole].pcKey);
+
+	/* Close the hole by shifting later members of the cluster back,
+	   so that lookups never need tombstones. A slot may move into
+	   the hole only if its home slot does not lie cyclically in
+	   (uHole, uIndex]. */
+	uMask = oSymTable->uPhysLength - 1;
+	uIndex = uHole;
+	for (;;)
+	{
+		uIndex = (uIndex + 1) & uMask;
+		if (psSlots[uIndex].pcKey == NULL) break;
+		uHome = psSlots[uIndex].uHash & uMask;
+		if (((uIndex - uHome) & uMask) >= ((uIndex - uHole) & uMask))
+		{
+			psSlots[uHole] = psSlots[uIndex];
+			uHole = uIndex;
+		}
+	}
+	psSlots[uHole].pcKey = NULL;
+	psSlots[uHole].pvValue = NULL;
+
+	oSymTable->uBindCount--;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	size_t uHash;
+	size_t uIndex;
+	char *pcKeyCopy;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return the address of the existing value if oSymTable already
+	   contains pcKey... */
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	uIndex = SymTable_find(oSymTable, pcKey, uHash);
+	if (oSymTable->psSlots[uIndex].pcKey != NULL)
+	{
+		if (piAdded != NULL) *piAdded = 0;
+		return &oSymTable->psSlots[uIndex].pvValue;
+	}
+
+	/* ...if not, allocate memory for the key copy, or use the
+	   client's key if it is borrowed. Return NULL if there is
+	   insufficient memory. */
+	if (oSymTable->iBorrowKeys)
+		pcKeyCopy = (char *)pcKey;
+	else
+	{
+		pcKeyCopy = (char *)malloc(strlen(pcKey) + 1);
+		if (pcKeyCopy == NULL) return NULL;
+		strcpy(pcKeyCopy, pcKey);
+	}
+
+	/* Grow first if the new binding would pass the load limit. The
+	   slot found above moves, so find it again. If growing fails we
+	   can keep going as long as an empty slot remains after this
+	   insert. */
+	if ((oSymTable->uBindCount + 1) * MAX_LOAD_DEN >
+		oSymTable->uPhysLength * MAX_LOAD_NUM)
+	{
+		if (oSymTable->uPhysLength <= ((size_t)-1) / 2 &&
+			SymTable_resize(oSymTable, oSymTable->uPhysLength * 2))
+			uIndex = SymTable_find(oSymTable, pcKey, uHash);
+		else if (oSymTable->uBindCount + 2 > oSymTable->uPhysLength)
+		{
+			if (! oSymTable->iBorrowKeys) free(pcKeyCopy);
+			return NULL;
+		}
+	}
+
+	oSymTable->psSlots[uIndex].uHash = uHash;
+	oSymTable->psSlots[uIndex].pcKey = pcKeyCopy;
+	oSymTable->psSlots[uIndex].pvValue = (void *)pvValue;
+
+	/* Increment binding count and return. */
+	oSymTable->uBindCount++;
+	if (piAdded != NULL) *piAdded = 1;
+	return &oSymTable->psSlots[uIndex].pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	void **ppvValue;
+	void *pvOldValue;
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded);
+	if (ppvValue == NULL || iAdded) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = *ppvValue;
+	*ppvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	size_t uIndex;
+	struct Slot *psSlot;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	/* Traverse the slot array and apply function pfApply to each
+	   occupied slot's key, value, and extra value if present */
+	for (uIndex = 0; uIndex < oSymTable->uPhysLength; uIndex++)
+	{
+		psSlot = &oSymTable->psSlots[uIndex];
+		if (psSlot->pcKey != NULL)
+			(*pfApply)(psSlot->pcKey, psSlot->pvValue, (void *)pvExtra);
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* auPos[0] is the next slot to look at. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = NULL;
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	SymTable_T oSymTable;
+	struct Slot *psSlot;
+
+	assert(psIter != NULL);
+
+	/* Skip empty slots up to the next occupied one. */
+	oSymTable = psIter->oSymTable;
+	while (psIter->auPos[0] < oSymTable->uPhysLength)
+	{
+		psSlot = &oSymTable->psSlots[psIter->auPos[0]++];
+		if (psSlot->pcKey == NULL) continue;
+		if (ppcKey != NULL) *ppcKey = psSlot->pcKey;
+		if (ppvValue != NULL) *ppvValue = psSlot->pvValue;
+		return 1;
+	}
+	return 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Slot *psSlot;
+	size_t uMask;
+	size_t uStart;
+	size_t uIndex;
+	size_t uProbes;
+	size_t uRun = 0;
+	size_t uRuns = 0;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+	psStats->uBindings = oSymTable->uBindCount;
+	psStats->uBuckets = oSymTable->uPhysLength;
+	psStats->uUsedBuckets = oSymTable->uBindCount;
+	psStats->dLoadFactor = (double)oSymTable->uBindCount /
+		(double)oSymTable->uPhysLength;
+	psStats->uResizes = oSymTable->uResizeCount;
+
+	/* A chain is a run of occupied slots, which a probe sequence may
+	   walk to its end. Start the scan just after an empty slot (the
+	   load limit guarantees one) so that no run wraps around. */
+	uMask = oSymTable->uPhysLength - 1;
+	for (uStart = 0; oSymTable->psSlots[uStart].pcKey != NULL;
+		uStart++);
+	for (uIndex = (uStart + 1) & uMask; ; uIndex = (uIndex + 1) & uMask)
+	{
+		psSlot = &oSymTable->psSlots[uIndex];
+		if (psSlot->pcKey == NULL)
+		{
+			if (uRun > psStats->uMaxChain) psStats->uMaxChain = uRun;
+			if (uRun != 0) uRuns++;
+			uRun = 0;
+			if (uIndex == uStart) break;
+			continue;
+		}
+
+	/* A binding is found after one comparison per slot from its home
+	   slot to its own. */
+		uRun++;
+		uProbes = ((uIndex - (psSlot->uHash & uMask)) & uMask) + 1;
+		if (uProbes > SYMTABLE_PROBE_MAX) uProbes = SYMTABLE_PROBE_MAX;
+		psStats->auProbes[uProbes - 1]++;
+		if (! oSymTable->iBorrowKeys)
+			psStats->uKeyBytes += strlen(psSlot->pcKey) + 1;
+	}
+	if (uRuns != 0)
+		psStats->dMeanChain = (double)oSymTable->uBindCount /
+			(double)uRuns;
+
+	/* Bindings live in the slots, so there are no separate nodes. */
+	psStats->uStructBytes = sizeof(struct SymTable);
+	psStats->uTableBytes = oSymTable->uPhysLength * sizeof(struct Slot);
+	psStats->uTotalBytes = psStats->uStructBytes + psStats->uTableBytes +
+		psStats->uKeyBytes;
+}
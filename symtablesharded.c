@@ -0,0 +1,1167 @@
+/*-------------------------------------------------------------------*/
+/* symtablesharded.c                                                 */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* A hash table whose functions may be called from several threads at
+   once, built for tables that are written as often as they are read.
+
+   The table is split into shards, a few per processor. The top bits
+   of a key's hash code pick its shard, and the next bits pick its
+   bucket within the shard. Each shard is a complete chained hash
+   table with its own mutex, its own bucket array that it doubles on
+   its own, and its own arena of nodes. A resize therefore stops only
+   the writers and readers of one shard, and threads working in
+   different shards never take the same lock, touch the same bucket
+   array, or share a cache line.
+
+   Only SymTable_free must not overlap any other call on the same
+   table. The address returned by SymTable_getOrPut stays valid until
+   the binding is removed, but storing through it races with other
+   threads using that binding; use SymTable_replace or SymTable_upsert
+   to change a shared value. The function passed to SymTable_map runs
+   with every shard locked, so it must not call any function on the
+   same table. A client hash function must be safe to call from
+   several threads. */
+
+/* The pthread functions, posix_memalign and sysconf are POSIX, not
+   ANSI C. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include "symtable.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*-------------------------------------------------------------------*/
+
+/* Multiplier and shift of the built-in hash function, and the
+   Fibonacci multiplier that spreads hash codes over the shards and
+   buckets, sized to the width of size_t. */
+#if ULONG_MAX > 0xffffffffUL
+#define HASH_MIX ((size_t)0xc6a4a7935bd1e995UL)
+#define HASH_SHIFT 47
+#define HASH_FIBONACCI ((size_t)0x9e3779b97f4a7c15UL)
+#else
+#define HASH_MIX ((size_t)0x5bd1e995UL)
+#define HASH_SHIFT 24
+#define HASH_FIBONACCI ((size_t)0x9e3779b9UL)
+#endif
+
+/* Number of bits in a size_t hash code. */
+#define HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+/*-------------------------------------------------------------------*/
+
+/* Number of shards per online processor, and the base 2 logarithms
+   of the fewest and most shards a table may have. The shard count is
+   rounded up to a power of two. */
+enum {SHARDS_PER_CPU = 4, SHARD_LOG_MIN = 2, SHARD_LOG_MAX = 8};
+
+/* Base 2 logarithm of the number of buckets in a new shard. */
+enum {INITIAL_LENGTH_LOG = 4};
+
+/* Size of a cache line. Shards are padded to a multiple of it so
+   that threads using neighbouring shards do not share a line. */
+enum {CACHE_LINE = 64};
+
+/* A node and its key copy share one block of a multiple of
+   BLOCK_GRANULE bytes. Blocks of up to BLOCK_CLASS_COUNT granules
+   are carved from the shard's chunks and kept on a free list per
+   size once removed; longer ones get their own malloc. */
+enum {BLOCK_GRANULE = 16, BLOCK_CLASS_COUNT = 16};
+
+/* Smallest and largest number of bytes in one chunk. Each new chunk
+   of a shard is twice the size of the last, up to the maximum. */
+enum {CHUNK_MIN = 1024, CHUNK_MAX = 65536};
+
+/*-------------------------------------------------------------------*/
+
+/* Node is a structure that stores and associates a char Key with
+   a void value and also maintains a pointer to the next node. The
+   key copy follows the node in the same block. */
+
+struct Node
+{
+	/* Full hash code of pcKey, already multiplied by HASH_FIBONACCI,
+	   so that resizing never rehashes a key and chain walks can skip
+	   most strcmp calls. */
+	size_t uHash;
+
+	/* Char pointer to hold the Key. */
+	const char *pcKey;
+
+	/* A void pointer to hold the Value. */
+	void *pvValue;
+
+	/* Another Node to hold a pointer to the next Node. Also links
+	   the shard's free lists. */
+	struct Node *psNext;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Chunk is the header of one large block of memory that nodes are
+   carved from. The usable memory follows the header. */
+
+struct Chunk
+{
+	/* The chunk allocated before this one. */
+	struct Chunk *psNext;
+
+	/* Keeps the memory after the header aligned for a Node. */
+	size_t uUnused;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Shard is a structure that holds one independent part of a Symbol
+   Table: the mutex that guards it, its bucket array, and the arena
+   its nodes come from. */
+
+struct Shard
+{
+	/* Held by every call that reads or changes the shard. */
+	pthread_mutex_t sLock;
+
+	/* The shard's bucket array. */
+	struct Node **ppsBuckets;
+
+	/* Count of buckets, always a power of two. */
+	size_t uPhysLength;
+
+	/* HASH_BITS minus the base 2 logarithm of uPhysLength. */
+	size_t uShift;
+
+	/* Number of bindings in the shard. Changed only with sLock held;
+	   read atomically by SymTable_getLength. */
+	size_t uCount;
+
+	/* Number of times the bucket array has been doubled. */
+	size_t uResizeCount;
+
+	/* Every chunk allocated for this shard. */
+	struct Chunk *psChunks;
+
+	/* Next never-used byte of the newest chunk, and how many remain
+	   after it. */
+	char *pcNext;
+	size_t uBytesLeft;
+
+	/* Number of bytes to put in the next chunk. */
+	size_t uChunkLength;
+
+	/* Bytes held in chunks, and in blocks too long for a size
+	   class. */
+	size_t uChunkBytes;
+	size_t uLongBytes;
+
+	/* Removed blocks of each size class, linked through psNext. */
+	struct Node *apsFree[BLOCK_CLASS_COUNT];
+};
+
+/*-------------------------------------------------------------------*/
+
+/* PaddedShard is a Shard rounded up to a whole number of cache
+   lines, which adds nothing if it already fills them. */
+
+union PaddedShard
+{
+	/* The shard itself. */
+	struct Shard sShard;
+
+	/* Room to the end of the shard's last cache line. */
+	char acLines[(sizeof(struct Shard) + CACHE_LINE - 1) /
+		CACHE_LINE * CACHE_LINE];
+};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain the shards of a Symbol
+   Table. */
+
+struct SymTable
+{
+	/* The shards, aligned to a cache line. */
+	union PaddedShard *psShards;
+
+	/* Base 2 logarithm of the number of shards. */
+	size_t uShardLog;
+
+	/* The client's hash function, or NULL to use SymTable_hash. */
+	size_t (*pfHash)(const char *pcKey);
+
+	/* 1 if nodes point to the client's keys instead of copies. */
+	int iBorrowKeys;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Special function to create full-width size_t hash codes for
+   pcKey */
+static size_t SymTable_hash(const char *pcKey);
+
+/* Special function to hash pcKey with the hash function of
+   oSymTable */
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey);
+
+/* Special function to find the shard that holds a key whose hash
+   code is uHash */
+static struct Shard *SymTable_shard(SymTable_T oSymTable, size_t uHash);
+
+/* Special function to find the link that points to the node holding
+   pcKey, or the NULL link at the end of its bucket */
+static struct Node **SymTable_findLink(SymTable_T oSymTable,
+	struct Shard *psShard, const char *pcKey, size_t uHash);
+
+/* Special function to find the number of key bytes stored with the
+   node for pcKey in oSymTable */
+static size_t SymTable_keySize(SymTable_T oSymTable, const char *pcKey);
+
+/* Special function to find the size of the block that holds a node
+   and a key copy of uKeySize bytes */
+static size_t SymTable_blockSize(size_t uKeySize);
+
+/* Special functions to take a node and its key copy from a shard's
+   arena and give them back */
+static struct Node *SymTable_newNode(SymTable_T oSymTable,
+	struct Shard *psShard, const char *pcKey, const void *pvValue,
+	size_t uHash);
+static void SymTable_freeNode(SymTable_T oSymTable,
+	struct Shard *psShard, struct Node *psNode);
+
+/* Special function to give a shard a larger bucket array of
+   2^(HASH_BITS - uShift) buckets */
+static int SymTable_resize(SymTable_T oSymTable, struct Shard *psShard,
+	size_t uShift);
+
+/* Special functions to lock and unlock every shard in order */
+static void SymTable_lockAll(SymTable_T oSymTable);
+static void SymTable_unlockAll(SymTable_T oSymTable);
+
+/*-------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey. The key is consumed a whole size_t
+   word at a time (MurmurHash2 mixing), so a long key costs one
+   multiply per word on the serial path instead of one per byte. */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+	size_t uLength;
+	size_t uTail;
+	size_t uWord;
+	size_t uHash;
+	const char *pcEnd;
+
+	assert(pcKey != NULL);
+
+	uLength = strlen(pcKey);
+	uTail = uLength % sizeof(size_t);
+	uHash = uLength * HASH_MIX;
+
+	/* Mix in each whole word, then the last few bytes, then
+	   avalanche. */
+	for (pcEnd = pcKey + (uLength - uTail); pcKey != pcEnd;
+		pcKey += sizeof(size_t))
+	{
+		memcpy(&uWord, pcKey, sizeof(size_t));
+		uWord *= HASH_MIX;
+		uWord ^= uWord >> HASH_SHIFT;
+		uWord *= HASH_MIX;
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+	if (uTail != 0)
+	{
+		uWord = 0;
+		memcpy(&uWord, pcKey, uTail);
+		uHash ^= uWord;
+		uHash *= HASH_MIX;
+	}
+	uHash ^= uHash >> HASH_SHIFT;
+	uHash *= HASH_MIX;
+	uHash ^= uHash >> HASH_SHIFT;
+	return uHash;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey under oSymTable's hash function,
+   already multiplied by HASH_FIBONACCI so that its top bits give the
+   shard of pcKey and the bits after them its bucket. */
+
+static size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+
+	if (oSymTable->pfHash != NULL)
+		return (*oSymTable->pfHash)(pcKey) * HASH_FIBONACCI;
+	return SymTable_hash(pcKey) * HASH_FIBONACCI;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the shard of oSymTable that holds, or would hold, a key
+   whose hash code is uHash. */
+
+static struct Shard *SymTable_shard(SymTable_T oSymTable, size_t uHash)
+{
+	assert(oSymTable != NULL);
+
+	return &oSymTable->psShards[uHash >>
+		(HASH_BITS - oSymTable->uShardLog)].sShard;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the address of the link (bucket or psNext field) that points
+   to the node holding pcKey, whose hash code is uHash, or the address
+   of the NULL link that ends its bucket if there is no such node. The
+   caller must hold psShard, the key's shard. */
+
+static struct Node **SymTable_findLink(SymTable_T oSymTable,
+	struct Shard *psShard, const char *pcKey, size_t uHash)
+{
+	struct Node **ppsLink;
+	struct Node *psCurr;
+
+	assert(oSymTable != NULL);
+	assert(psShard != NULL);
+	assert(pcKey != NULL);
+
+	/* The shard bits are shifted out before the bucket bits are
+	   taken. */
+	for (ppsLink = &psShard->ppsBuckets[(uHash << oSymTable->uShardLog)
+		>> psShard->uShift]; (psCurr = *ppsLink) != NULL;
+		ppsLink = &psCurr->psNext)
+	{
+		if (psCurr->uHash == uHash && strcmp(pcKey, psCurr->pcKey) == 0)
+			break;
+	}
+	return ppsLink;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the number of bytes of pcKey, terminating '\0' included,
+   that are copied into its node in oSymTable, or 0 if oSymTable
+   borrows keys. */
+
+static size_t SymTable_keySize(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	return oSymTable->iBorrowKeys ? 0 : strlen(pcKey) + 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the number of bytes in the block of a node whose key has
+   uKeySize bytes, terminating '\0' included. */
+
+static size_t SymTable_blockSize(size_t uKeySize)
+{
+	return (sizeof(struct Node) + uKeySize + BLOCK_GRANULE - 1) /
+		BLOCK_GRANULE * BLOCK_GRANULE;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return a new unlinked node of psShard, a shard of oSymTable,
+   holding pvValue, uHash and a copy of pcKey, or pcKey itself if
+   oSymTable borrows keys. Return NULL if insufficient memory is
+   available. The caller must hold psShard. */
+
+static struct Node *SymTable_newNode(SymTable_T oSymTable,
+	struct Shard *psShard, const char *pcKey, const void *pvValue,
+	size_t uHash)
+{
+	struct Chunk *psChunk;
+	struct Node *psNode;
+	size_t uKeySize;
+	size_t uSize;
+	size_t uClass;
+
+	assert(psShard != NULL);
+	assert(pcKey != NULL);
+
+	uKeySize = SymTable_keySize(oSymTable, pcKey);
+	uSize = SymTable_blockSize(uKeySize);
+	uClass = uSize / BLOCK_GRANULE - 1;
+
+	if (uClass >= BLOCK_CLASS_COUNT)
+	{
+	/* Too long for the arena. */
+		psNode = (struct Node *)malloc(uSize);
+		if (psNode == NULL) return NULL;
+		psShard->uLongBytes += uSize;
+	}
+	else if (psShard->apsFree[uClass] != NULL)
+	{
+	/* Reuse a removed block of the same size. */
+		psNode = psShard->apsFree[uClass];
+		psShard->apsFree[uClass] = psNode->psNext;
+	}
+	else
+	{
+	/* Carve from the newest chunk, starting a new one when it is too
+	   full. The rest of the old chunk is wasted. */
+		if (psShard->uBytesLeft < uSize)
+		{
+			psChunk = (struct Chunk *)malloc(sizeof(struct Chunk) +
+				psShard->uChunkLength);
+			if (psChunk == NULL) return NULL;
+			psChunk->psNext = psShard->psChunks;
+			psShard->psChunks = psChunk;
+			psShard->pcNext = (char *)(psChunk + 1);
+			psShard->uBytesLeft = psShard->uChunkLength;
+			psShard->uChunkBytes += sizeof(struct Chunk) +
+				psShard->uChunkLength;
+			if (psShard->uChunkLength < CHUNK_MAX)
+				psShard->uChunkLength *= 2;
+		}
+		psNode = (struct Node *)psShard->pcNext;
+		psShard->pcNext += uSize;
+		psShard->uBytesLeft -= uSize;
+	}
+
+	if (oSymTable->iBorrowKeys)
+		psNode->pcKey = pcKey;
+	else
+	{
+		memcpy(psNode + 1, pcKey, uKeySize);
+		psNode->pcKey = (const char *)(psNode + 1);
+	}
+	psNode->uHash = uHash;
+	psNode->pvValue = (void *)pvValue;
+	psNode->psNext = NULL;
+	return psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Give the block of psNode, which has been unlinked from psShard, a
+   shard of oSymTable, back to the shard. The caller must hold
+   psShard. */
+
+static void SymTable_freeNode(SymTable_T oSymTable,
+	struct Shard *psShard, struct Node *psNode)
+{
+	size_t uSize;
+	size_t uClass;
+
+	assert(psShard != NULL);
+	assert(psNode != NULL);
+
+	uSize = SymTable_blockSize(SymTable_keySize(oSymTable,
+		psNode->pcKey));
+	uClass = uSize / BLOCK_GRANULE - 1;
+	if (uClass >= BLOCK_CLASS_COUNT)
+	{
+		psShard->uLongBytes -= uSize;
+		free(psNode);
+		return;
+	}
+	psNode->psNext = psShard->apsFree[uClass];
+	psShard->apsFree[uClass] = psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Move the nodes of psShard, a shard of oSymTable, into a new array
+   of 2^(HASH_BITS - uShift) buckets, more than it has now, in one
+   step. The caller must hold psShard, and no other shard is touched.
+   Each node is relinked to the front of its new bucket. Return 1 on
+   success, or 0 (keeping the current array) if insufficient memory
+   is available or the hash codes have too few bits left. */
+
+static int SymTable_resize(SymTable_T oSymTable, struct Shard *psShard,
+	size_t uShift)
+{
+	struct Node **ppsNew;
+	struct Node *psCurr;
+	struct Node *psNext;
+	size_t uNewLength;
+	size_t uIndex;
+	size_t uHashedIndex;
+
+	assert(oSymTable != NULL);
+	assert(psShard != NULL);
+	assert(uShift < psShard->uShift);
+
+	if (uShift <= oSymTable->uShardLog) return 0;
+	uNewLength = (size_t)1 << (HASH_BITS - uShift);
+	if (uNewLength > (size_t)-1 / sizeof(struct Node *)) return 0;
+	ppsNew = (struct Node **)calloc(uNewLength, sizeof(struct Node *));
+	if (ppsNew == NULL) return 0;
+
+	for (uIndex = 0; uIndex < psShard->uPhysLength; uIndex++)
+	{
+		for (psCurr = psShard->ppsBuckets[uIndex]; psCurr != NULL;
+			psCurr = psNext)
+		{
+			psNext = psCurr->psNext;
+			uHashedIndex = (psCurr->uHash << oSymTable->uShardLog) >>
+				uShift;
+			psCurr->psNext = ppsNew[uHashedIndex];
+			ppsNew[uHashedIndex] = psCurr;
+		}
+	}
+
+	free(psShard->ppsBuckets);
+	psShard->ppsBuckets = ppsNew;
+	psShard->uPhysLength = uNewLength;
+	psShard->uShift = uShift;
+	psShard->uResizeCount++;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Lock every shard of oSymTable. Locks are always taken in shard
+   order, so two threads doing this cannot deadlock. */
+
+static void SymTable_lockAll(SymTable_T oSymTable)
+{
+	size_t uShard;
+
+	assert(oSymTable != NULL);
+
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+		pthread_mutex_lock(
+			&oSymTable->psShards[uShard].sShard.sLock);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Unlock every shard of oSymTable. */
+
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+	size_t uShard;
+
+	assert(oSymTable != NULL);
+
+	for (uShard = (size_t)1 << oSymTable->uShardLog; uShard > 0;
+		uShard--)
+		pthread_mutex_unlock(
+			&oSymTable->psShards[uShard - 1].sShard.sLock);
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+	SymTable_T oSymTable;
+	struct Shard *psShard;
+	void *pvShards;
+	long lCpus = 1;
+	size_t uShardLog = SHARD_LOG_MIN;
+	size_t uShard;
+
+	/* Give each online processor SHARDS_PER_CPU shards. */
+#ifdef _SC_NPROCESSORS_ONLN
+	lCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (lCpus < 1) lCpus = 1;
+#endif
+	while (uShardLog < SHARD_LOG_MAX &&
+		(size_t)1 << uShardLog < (size_t)lCpus * SHARDS_PER_CPU)
+		uShardLog++;
+
+	/* Allocate memory and return NULL if it is unsufficient. */
+	oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+	if (oSymTable == NULL) return NULL;
+	if (posix_memalign(&pvShards, CACHE_LINE,
+		((size_t)1 << uShardLog) * sizeof(union PaddedShard)) != 0)
+	{
+		free(oSymTable);
+		return NULL;
+	}
+	memset(pvShards, 0,
+		((size_t)1 << uShardLog) * sizeof(union PaddedShard));
+	oSymTable->psShards = (union PaddedShard *)pvShards;
+	oSymTable->uShardLog = uShardLog;
+	oSymTable->pfHash = NULL;
+	oSymTable->iBorrowKeys = 0;
+
+	/* Give each shard its own bucket array; chunks are allocated on
+	   demand. */
+	for (uShard = 0; uShard < (size_t)1 << uShardLog; uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		psShard->ppsBuckets = (struct Node **)calloc(
+			(size_t)1 << INITIAL_LENGTH_LOG, sizeof(struct Node *));
+		if (psShard->ppsBuckets == NULL)
+		{
+			while (uShard-- > 0)
+				free(oSymTable->psShards[uShard].sShard.ppsBuckets);
+			free(pvShards);
+			free(oSymTable);
+			return NULL;
+		}
+		psShard->uPhysLength = (size_t)1 << INITIAL_LENGTH_LOG;
+		psShard->uShift = HASH_BITS - INITIAL_LENGTH_LOG;
+		psShard->uChunkLength = CHUNK_MIN;
+	}
+	for (uShard = 0; uShard < (size_t)1 << uShardLog; uShard++)
+		pthread_mutex_init(&oSymTable->psShards[uShard].sShard.sLock,
+			NULL);
+
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	SymTable_T oSymTable;
+
+	assert(pfHash != NULL);
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->pfHash = pfHash;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	if (! SymTable_reserve(oSymTable, uCapacity))
+	{
+		SymTable_free(oSymTable);
+		return NULL;
+	}
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* A put grows a shard once it holds more bindings than buckets, so
+   each shard needs room for its share of uCapacity plus however many
+   more its keys happen to hash to. Give it four times a power of two
+   at least the square root of its share on top, several standard
+   deviations for keys that hash uniformly, and grow each shard that
+   is smaller to that in one step. A shard's node blocks hold the key
+   copies too, whose lengths are not known yet, so they are still
+   carved as bindings are put. */
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	struct Shard *psShard;
+	size_t uShare;
+	size_t uRoot;
+	size_t uShift = HASH_BITS - INITIAL_LENGTH_LOG;
+	size_t uShard;
+	int iSuccessful = 1;
+
+	assert(oSymTable != NULL);
+
+	uShare = (uCapacity >> oSymTable->uShardLog) + 1;
+	for (uRoot = 1; uRoot < uShare / uRoot; uRoot *= 2)
+		;
+	if (uShare > (size_t)-1 - 4 * uRoot) return 0;
+	uShare += 4 * uRoot;
+	while (((size_t)1 << (HASH_BITS - uShift)) < uShare)
+	{
+		if (uShift <= oSymTable->uShardLog + 1) return 0;
+		uShift--;
+	}
+
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		pthread_mutex_lock(&psShard->sLock);
+		if (uShift < psShard->uShift &&
+			! SymTable_resize(oSymTable, psShard, uShift))
+			iSuccessful = 0;
+		pthread_mutex_unlock(&psShard->sLock);
+	}
+	return iSuccessful;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+	struct Shard *psShard;
+	struct Chunk *psChunk;
+	struct Node *psCurr;
+	void *pvTemp;
+	size_t uShard;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+
+	/* Free the nodes too long for the arena, then every chunk and
+	   bucket array. No other thread may be using the table any
+	   more. */
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		if (psShard->uLongBytes != 0)
+			for (uIndex = 0; uIndex < psShard->uPhysLength; uIndex++)
+				for (psCurr = psShard->ppsBuckets[uIndex];
+					psCurr != NULL; psCurr = (struct Node *)pvTemp)
+				{
+					pvTemp = psCurr->psNext;
+					if (SymTable_blockSize(SymTable_keySize(oSymTable,
+						psCurr->pcKey)) / BLOCK_GRANULE >
+						BLOCK_CLASS_COUNT)
+						free(psCurr);
+				}
+		for (psChunk = psShard->psChunks; psChunk != NULL;
+			psChunk = (struct Chunk *)pvTemp)
+		{
+			pvTemp = psChunk->psNext;
+			free(psChunk);
+		}
+		free(psShard->ppsBuckets);
+		pthread_mutex_destroy(&psShard->sLock);
+	}
+	free(oSymTable->psShards);
+	free(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+	size_t uShard;
+	size_t uLength = 0;
+
+	assert(oSymTable != NULL);
+
+	/* Sum the shards' counts without locking them. While other
+	   threads are changing the table the sum is only a snapshot. */
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+		uLength += __atomic_load_n(
+			&oSymTable->psShards[uShard].sShard.uCount,
+			__ATOMIC_RELAXED);
+	return uLength;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Shard *psShard;
+	struct Node *psCurr;
+	void *pvOldValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Save & return old value, & overwrite with new value. */
+	pthread_mutex_lock(&psShard->sLock);
+	psCurr = *SymTable_findLink(oSymTable, psShard, pcKey, uHash);
+	if (psCurr != NULL)
+	{
+		pvOldValue = psCurr->pvValue;
+		psCurr->pvValue = (void *)pvValue;
+	}
+	pthread_mutex_unlock(&psShard->sLock);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Shard *psShard;
+	int iFound;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Return 1 if a node's key matches the query key, 0 otherwise. */
+	pthread_mutex_lock(&psShard->sLock);
+	iFound = *SymTable_findLink(oSymTable, psShard, pcKey, uHash) !=
+		NULL;
+	pthread_mutex_unlock(&psShard->sLock);
+	return iFound;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Shard *psShard;
+	struct Node *psCurr;
+	void *pvValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Return a pointer to the value connected to the query Key. */
+	pthread_mutex_lock(&psShard->sLock);
+	psCurr = *SymTable_findLink(oSymTable, psShard, pcKey, uHash);
+	if (psCurr != NULL) pvValue = psCurr->pvValue;
+	pthread_mutex_unlock(&psShard->sLock);
+	return pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+	struct Shard *psShard;
+	struct Node *psCurr;
+	struct Node *psNext;
+	size_t uShard;
+	size_t uIndex;
+	size_t uLeft;
+
+	assert(oSymTable != NULL);
+
+	/* Empty one shard at a time, giving every node back to the
+	   shard's arena. Only occupied buckets are written, and the walk
+	   stops at the shard's last binding. */
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		pthread_mutex_lock(&psShard->sLock);
+		uLeft = psShard->uCount;
+		for (uIndex = 0; uLeft > 0; uIndex++)
+		{
+			if (psShard->ppsBuckets[uIndex] == NULL) continue;
+			for (psCurr = psShard->ppsBuckets[uIndex]; psCurr != NULL;
+				psCurr = psNext)
+			{
+				psNext = psCurr->psNext;
+				SymTable_freeNode(oSymTable, psShard, psCurr);
+				uLeft--;
+			}
+			psShard->ppsBuckets[uIndex] = NULL;
+		}
+		__atomic_store_n(&psShard->uCount, 0, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&psShard->sLock);
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Shard *psShard;
+	struct Node **ppsLink;
+	struct Node *psCurr;
+	void *pvOldValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Unlink the query key's Node if there is one, and give it back
+	   to the shard's arena. */
+	pthread_mutex_lock(&psShard->sLock);
+	ppsLink = SymTable_findLink(oSymTable, psShard, pcKey, uHash);
+	psCurr = *ppsLink;
+	if (psCurr != NULL)
+	{
+		pvOldValue = psCurr->pvValue;
+		*ppsLink = psCurr->psNext;
+		__atomic_store_n(&psShard->uCount, psShard->uCount - 1,
+			__ATOMIC_RELAXED);
+		SymTable_freeNode(oSymTable, psShard, psCurr);
+	}
+	pthread_mutex_unlock(&psShard->sLock);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	struct Shard *psShard;
+	struct Node **ppsLink;
+	struct Node *psNode;
+	size_t uHash;
+	int iAdded = 0;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Find the existing node, or add a new one at the end of the
+	   bucket. Grow the shard once it holds more bindings than
+	   buckets; its nodes do not move, so the address stays good. */
+	pthread_mutex_lock(&psShard->sLock);
+	ppsLink = SymTable_findLink(oSymTable, psShard, pcKey, uHash);
+	psNode = *ppsLink;
+	if (psNode == NULL)
+	{
+		psNode = SymTable_newNode(oSymTable, psShard, pcKey, pvValue,
+			uHash);
+		if (psNode != NULL)
+		{
+			*ppsLink = psNode;
+			iAdded = 1;
+			__atomic_store_n(&psShard->uCount, psShard->uCount + 1,
+				__ATOMIC_RELAXED);
+			if (psShard->uCount > psShard->uPhysLength)
+				(void)SymTable_resize(oSymTable, psShard,
+					psShard->uShift - 1);
+		}
+	}
+	pthread_mutex_unlock(&psShard->sLock);
+	if (psNode == NULL) return NULL;
+
+	if (piAdded != NULL) *piAdded = iAdded;
+	return &psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Shard *psShard;
+	struct Node **ppsLink;
+	struct Node *psNode;
+	void *pvOldValue = NULL;
+	size_t uHash;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	uHash = SymTable_hashKey(oSymTable, pcKey);
+	psShard = SymTable_shard(oSymTable, uHash);
+
+	/* Replace the value in place, or add a new node, under one lock
+	   so that no other thread sees the key missing in between. */
+	pthread_mutex_lock(&psShard->sLock);
+	ppsLink = SymTable_findLink(oSymTable, psShard, pcKey, uHash);
+	psNode = *ppsLink;
+	if (psNode != NULL)
+	{
+		pvOldValue = psNode->pvValue;
+		psNode->pvValue = (void *)pvValue;
+	}
+	else
+	{
+		psNode = SymTable_newNode(oSymTable, psShard, pcKey, pvValue,
+			uHash);
+		if (psNode != NULL)
+		{
+			*ppsLink = psNode;
+			__atomic_store_n(&psShard->uCount, psShard->uCount + 1,
+				__ATOMIC_RELAXED);
+			if (psShard->uCount > psShard->uPhysLength)
+				(void)SymTable_resize(oSymTable, psShard,
+					psShard->uShift - 1);
+		}
+	}
+	pthread_mutex_unlock(&psShard->sLock);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Shard *psShard;
+	struct Node *psCurr;
+	size_t uShard;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	/* Traverse every shard's buckets with every shard locked, so the
+	   traversal sees one consistent table, and apply function
+	   pfApply to each key, value, and extra value if present */
+	SymTable_lockAll(oSymTable);
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		for (uIndex = 0; uIndex < psShard->uPhysLength; uIndex++)
+			for (psCurr = psShard->ppsBuckets[uIndex]; psCurr != NULL;
+				psCurr = psCurr->psNext)
+				(*pfApply)(psCurr->pcKey, psCurr->pvValue,
+					(void *)pvExtra);
+	}
+	SymTable_unlockAll(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* auPos[0] is the shard and auPos[1] the next bucket in it to look
+	   at. Shards cannot resize during the traversal, since they gain
+	   no bindings. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = NULL;
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	SymTable_T oSymTable;
+	struct Shard *psShard;
+	struct Node *psCurr;
+
+	assert(psIter != NULL);
+
+	/* Step with the current shard locked, since other threads may
+	   replace its values meanwhile. At the end of a chain, move to
+	   the next bucket that is not empty, shard by shard. */
+	oSymTable = psIter->oSymTable;
+	while (psIter->auPos[0] < (size_t)1 << oSymTable->uShardLog)
+	{
+		psShard = &oSymTable->psShards[psIter->auPos[0]].sShard;
+		pthread_mutex_lock(&psShard->sLock);
+		psCurr = (struct Node *)psIter->pvNext;
+		while (psCurr == NULL && psIter->auPos[1] < psShard->uPhysLength)
+			psCurr = psShard->ppsBuckets[psIter->auPos[1]++];
+		if (psCurr != NULL)
+		{
+			psIter->pvNext = psCurr->psNext;
+			if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+			if (ppvValue != NULL) *ppvValue = psCurr->pvValue;
+		}
+		pthread_mutex_unlock(&psShard->sLock);
+		if (psCurr != NULL) return 1;
+		psIter->auPos[0]++;
+		psIter->auPos[1] = 0;
+	}
+	return 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Shard *psShard;
+	struct Node *psCurr;
+	size_t uShard;
+	size_t uIndex;
+	size_t uLength;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+
+	/* The shards' buckets are counted as one table. The nth node of a
+	   chain is found with n comparisons. */
+	SymTable_lockAll(oSymTable);
+	for (uShard = 0; uShard < (size_t)1 << oSymTable->uShardLog;
+		uShard++)
+	{
+		psShard = &oSymTable->psShards[uShard].sShard;
+		psStats->uBuckets += psShard->uPhysLength;
+		psStats->uResizes += psShard->uResizeCount;
+		psStats->uNodeBytes += psShard->uChunkBytes +
+			psShard->uLongBytes;
+		for (uIndex = 0; uIndex < psShard->uPhysLength; uIndex++)
+		{
+			uLength = 0;
+			for (psCurr = psShard->ppsBuckets[uIndex]; psCurr != NULL;
+				psCurr = psCurr->psNext)
+			{
+				uLength++;
+				psStats->auProbes[uLength < SYMTABLE_PROBE_MAX ?
+					uLength - 1 : SYMTABLE_PROBE_MAX - 1]++;
+				psStats->uKeyBytes += SymTable_keySize(oSymTable,
+					psCurr->pcKey);
+			}
+			psStats->uBindings += uLength;
+			if (uLength == 0) continue;
+			psStats->uUsedBuckets++;
+			if (uLength > psStats->uMaxChain) psStats->uMaxChain = uLength;
+		}
+	}
+	SymTable_unlockAll(oSymTable);
+
+	psStats->dLoadFactor = (double)psStats->uBindings /
+		(double)psStats->uBuckets;
+	if (psStats->uUsedBuckets != 0)
+		psStats->dMeanChain = (double)psStats->uBindings /
+			(double)psStats->uUsedBuckets;
+
+	/* Key copies share their blocks with the nodes, so the arena's
+	   bytes less the key bytes are node bytes. */
+	psStats->uStructBytes = sizeof(struct SymTable) +
+		((size_t)1 << oSymTable->uShardLog) * sizeof(union PaddedShard);
+	psStats->uTableBytes = psStats->uBuckets * sizeof(struct Node *);
+	psStats->uNodeBytes -= psStats->uKeyBytes;
+	psStats->uTotalBytes = psStats->uStructBytes + psStats->uTableBytes +
+		psStats->uNodeBytes + psStats->uKeyBytes;
+}
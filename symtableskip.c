@@ -0,0 +1,563 @@
+/*-------------------------------------------------------------------*/
+/* symtableskip.c                                                    */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* A SymTable kept as a skip list: a sorted linked list in which some
+   nodes also link ahead to later ones, so that put, get, and remove
+   take O(log n) key comparisons on average instead of the O(n) of
+   symtablelist.c. SymTable_map and SymTable_iterNext visit the
+   bindings in increasing strcmp order of their keys. */
+
+#include <string.h>
+#include "symtable.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/*-------------------------------------------------------------------*/
+
+/* The most levels a node can have. Each level holds about a quarter
+   of the nodes of the one below it, so 16 levels stay O(log n) up to
+   about 4^16 bindings. */
+
+enum {MAX_LEVEL = 16};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain a counter for the number of
+   bindings in a Symbol Table and the head links of each level. */
+
+struct SymTable
+{
+	/* apsHead[i] is the first Node on level i, or NULL. */
+	struct Node *apsHead[MAX_LEVEL];
+
+	/* Number of levels in use: apsHead[i] is NULL for every i at or
+	   above it. */
+	size_t uLevels;
+
+	/* variable to store size of st */
+	size_t uCount;
+
+	/* State of the random number generator that picks the level of
+	   each new Node. */
+	unsigned long ulSeed;
+
+	/* 1 if Nodes point to the client's keys instead of copies. */
+	int iBorrowKeys;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Node is a structure that stores and associates a char Key with
+   a void value. Each Node is one allocation: the structure, then
+   its uLevels next pointers (see SymTable_links), then its key. */
+
+struct Node
+{
+	/* Char pointer to hold the Key. */
+	const char *pcKey;
+
+	/* A void pointer to hold the Value. */
+	void *pvValue;
+
+	/* Number of levels that this Node is linked into. */
+	size_t uLevels;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Return the array of next pointers of Node psNode: element i is the
+   Node after psNode on level i. */
+
+#define SymTable_links(psNode) ((struct Node **)((psNode) + 1))
+
+/*-------------------------------------------------------------------*/
+
+/* Special function to find pcKey in oSymTable. */
+
+static struct Node *SymTable_find(SymTable_T oSymTable,
+	const char *pcKey, struct Node ***pppsPrev, size_t *puCompares);
+
+/* Special function to pick the level of a new Node. */
+
+static size_t SymTable_randomLevels(SymTable_T oSymTable);
+
+/* Special function to free every Node of oSymTable. */
+
+static void SymTable_freeNodes(SymTable_T oSymTable);
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+	SymTable_T oSymTable;
+	size_t uLevel;
+
+	/* Allocate memory and return if it is unsufficient. */
+	oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+	if (oSymTable == NULL) return NULL;
+
+	/* Start with every level empty. */
+	for (uLevel = 0; uLevel < MAX_LEVEL; uLevel++)
+		oSymTable->apsHead[uLevel] = NULL;
+	oSymTable->uLevels = 0;
+	oSymTable->uCount = 0;
+	oSymTable->ulSeed = 2463534242UL;
+	oSymTable->iBorrowKeys = 0;
+
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	assert(pfHash != NULL);
+
+	/* A skip list orders its keys with strcmp, which a hash code
+	   cannot stand in for, so *pfHash is never called. */
+	(void)pfHash;
+	return SymTable_new();
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	/* A skip list has no array to size; its nodes are allocated one
+	   at a time as bindings are put. */
+	(void)uCapacity;
+	return SymTable_new();
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	assert(oSymTable != NULL);
+
+	/* A skip list never resizes, so it is always big enough. */
+	(void)uCapacity;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Free every Node of oSymTable, together with its key, which shares
+   its allocation. Leave the head links and count as they are. */
+
+static void SymTable_freeNodes(SymTable_T oSymTable)
+{
+	struct Node *psCurr;
+	struct Node *psNext;
+
+	assert(oSymTable != NULL);
+
+	/* Level 0 links every Node. */
+	for (psCurr = oSymTable->apsHead[0]; psCurr != NULL; psCurr = psNext)
+	{
+		psNext = SymTable_links(psCurr)[0];
+		free(psCurr);
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	SymTable_freeNodes(oSymTable);
+	free(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	/* Return length count from SymTable structure. */
+	return oSymTable->uCount;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node of oSymTable whose key is pcKey, or NULL if there
+   is none. If pppsPrev is not NULL, store in pppsPrev[i], for each
+   level i in use, the address of the link on level i that points to
+   the first Node whose key is not less than pcKey; those are the
+   links that an insert or remove of pcKey must change. If puCompares
+   is not NULL, add the number of strcmp calls made to *puCompares. */
+
+static struct Node *SymTable_find(SymTable_T oSymTable,
+	const char *pcKey, struct Node ***pppsPrev, size_t *puCompares)
+{
+	struct Node **ppsLinks;
+	struct Node *psCurr;
+	struct Node *psBound = NULL;
+	size_t uLevel;
+	int iCmp;
+	int iBoundCmp = 1;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Start at the head and, on each level from the top down, move
+	   right while the next key is less than pcKey. The Node that
+	   stops one level, psBound, is on every level below it too and
+	   stops them as well unless a smaller key comes first, so do not
+	   compare against it again. */
+	ppsLinks = oSymTable->apsHead;
+	for (uLevel = oSymTable->uLevels; uLevel-- > 0; )
+	{
+		while ((psCurr = ppsLinks[uLevel]) != NULL && psCurr != psBound)
+		{
+			if (puCompares != NULL) (*puCompares)++;
+			iCmp = strcmp(psCurr->pcKey, pcKey);
+			if (iCmp >= 0)
+			{
+				psBound = psCurr;
+				iBoundCmp = iCmp;
+				break;
+			}
+			ppsLinks = SymTable_links(psCurr);
+		}
+
+		/* A lookup can stop as soon as it meets the key. */
+		if (pppsPrev == NULL && iBoundCmp == 0) return psBound;
+		if (pppsPrev != NULL) pppsPrev[uLevel] = &ppsLinks[uLevel];
+	}
+
+	/* On level 0, psBound is the first Node not less than pcKey. */
+	if (iBoundCmp == 0) return psBound;
+	return NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the number of levels, from 1 to MAX_LEVEL, to link a new
+   Node of oSymTable into. Each level past the first is taken with
+   probability 1/4. */
+
+static size_t SymTable_randomLevels(SymTable_T oSymTable)
+{
+	unsigned long ulBits;
+	size_t uLevels = 1;
+
+	assert(oSymTable != NULL);
+
+	/* Step a 32-bit xorshift generator, then count the pairs of zero
+	   bits at the bottom of its output. */
+	ulBits = oSymTable->ulSeed;
+	ulBits ^= (ulBits << 13) & 0xffffffffUL;
+	ulBits ^= ulBits >> 17;
+	ulBits ^= (ulBits << 5) & 0xffffffffUL;
+	oSymTable->ulSeed = ulBits;
+
+	while (uLevels < MAX_LEVEL && (ulBits & 3) == 0)
+	{
+		uLevels++;
+		ulBits >>= 2;
+	}
+	return uLevels;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Node *psNode;
+	void *pvOldValue;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psNode = SymTable_find(oSymTable, pcKey, NULL, NULL);
+	if (psNode == NULL) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = psNode->pvValue;
+	psNode->pvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	return SymTable_find(oSymTable, pcKey, NULL, NULL) != NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Node *psNode;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psNode = SymTable_find(oSymTable, pcKey, NULL, NULL);
+	if (psNode == NULL) return NULL;
+	return psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+	size_t uLevel;
+
+	assert(oSymTable != NULL);
+
+	/* Each Node, its links and its Key are one allocation sized for
+	   that Key, so there is no pool to keep them in and no array to
+	   keep; free them as SymTable_free does, which symtable.h allows
+	   of a table without pooled nodes. */
+	SymTable_freeNodes(oSymTable);
+	for (uLevel = 0; uLevel < oSymTable->uLevels; uLevel++)
+		oSymTable->apsHead[uLevel] = NULL;
+	oSymTable->uLevels = 0;
+	oSymTable->uCount = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Node **appsPrev[MAX_LEVEL];
+	struct Node *psNode;
+	void *pvOldValue;
+	size_t uLevel;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psNode = SymTable_find(oSymTable, pcKey, appsPrev, NULL);
+	if (psNode == NULL) return NULL;
+
+	/* Unlink the Node from every level it is on; on each of them the
+	   link before pcKey's place points to it. */
+	for (uLevel = 0; uLevel < psNode->uLevels; uLevel++)
+		*appsPrev[uLevel] = SymTable_links(psNode)[uLevel];
+
+	/* Drop the levels that are now empty. */
+	while (oSymTable->uLevels > 0 &&
+		oSymTable->apsHead[oSymTable->uLevels - 1] == NULL)
+		oSymTable->uLevels--;
+
+	pvOldValue = psNode->pvValue;
+	free(psNode);
+	oSymTable->uCount--;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	struct Node **appsPrev[MAX_LEVEL];
+	struct Node *psNode;
+	size_t uLevels;
+	size_t uLevel;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Search once, keeping the links before pcKey's place, and return
+	   the address of the value connected to the query Key if there
+	   is one. */
+	psNode = SymTable_find(oSymTable, pcKey, appsPrev, NULL);
+	if (psNode != NULL)
+	{
+		if (piAdded != NULL) *piAdded = 0;
+		return &psNode->pvValue;
+	}
+
+	/* Otherwise allocate the node, its links, and its key (unless it
+	   is borrowed) in one block and return NULL if there is
+	   insufficient memory. */
+	uLevels = SymTable_randomLevels(oSymTable);
+	psNode = (struct Node *)malloc(sizeof(struct Node) +
+		uLevels * sizeof(struct Node *) +
+		(oSymTable->iBorrowKeys ? 0 : strlen(pcKey) + 1));
+	if (psNode == NULL) return NULL;
+	if (oSymTable->iBorrowKeys)
+		psNode->pcKey = pcKey;
+	else
+	{
+		psNode->pcKey = (const char *)(SymTable_links(psNode) + uLevels);
+		strcpy((char *)psNode->pcKey, pcKey);
+	}
+	psNode->pvValue = (void *)pvValue;
+	psNode->uLevels = uLevels;
+
+	/* Levels that were empty are entered straight from the head. */
+	for (uLevel = oSymTable->uLevels; uLevel < uLevels; uLevel++)
+		appsPrev[uLevel] = &oSymTable->apsHead[uLevel];
+	if (uLevels > oSymTable->uLevels) oSymTable->uLevels = uLevels;
+
+	/* Link the Node in after the last key less than pcKey on each of
+	   its levels. */
+	for (uLevel = 0; uLevel < uLevels; uLevel++)
+	{
+		SymTable_links(psNode)[uLevel] = *appsPrev[uLevel];
+		*appsPrev[uLevel] = psNode;
+	}
+
+	/* Increment binding count of oSymTable. */
+	oSymTable->uCount++;
+	if (piAdded != NULL) *piAdded = 1;
+	return &psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	void **ppvValue;
+	void *pvOldValue;
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded);
+	if (ppvValue == NULL || iAdded) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = *ppvValue;
+	*ppvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Node *psCurr;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	/* Level 0 links every Node in increasing order of key, so walk
+	   it and apply function pfApply to each binding. */
+	for (psCurr = oSymTable->apsHead[0]; psCurr != NULL;
+		psCurr = SymTable_links(psCurr)[0])
+		(*pfApply)(psCurr->pcKey, psCurr->pvValue, (void *)pvExtra);
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* Start at the smallest key. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = oSymTable->apsHead[0];
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	struct Node *psCurr;
+
+	assert(psIter != NULL);
+
+	/* Hand out the next node and step past it on level 0. */
+	psCurr = (struct Node *)psIter->pvNext;
+	if (psCurr == NULL) return 0;
+	psIter->pvNext = SymTable_links(psCurr)[0];
+	if (ppcKey != NULL) *ppcKey = psCurr->pcKey;
+	if (ppvValue != NULL) *ppvValue = psCurr->pvValue;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Node *psCurr;
+	size_t uCompares;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+
+	/* As with a list, the whole skip list is one bucket, and its
+	   one chain. */
+	psStats->uBindings = oSymTable->uCount;
+	psStats->uBuckets = 1;
+	psStats->uUsedBuckets = oSymTable->uCount != 0;
+	psStats->dLoadFactor = (double)oSymTable->uCount;
+	psStats->uMaxChain = oSymTable->uCount;
+	psStats->dMeanChain = (double)oSymTable->uCount;
+	psStats->uStructBytes = sizeof(struct SymTable);
+
+	/* Count the comparisons that a lookup of each key makes. */
+	for (psCurr = oSymTable->apsHead[0]; psCurr != NULL;
+		psCurr = SymTable_links(psCurr)[0])
+	{
+		uCompares = 0;
+		SymTable_find(oSymTable, psCurr->pcKey, NULL, &uCompares);
+		if (uCompares > SYMTABLE_PROBE_MAX)
+			uCompares = SYMTABLE_PROBE_MAX;
+		psStats->auProbes[uCompares - 1]++;
+		psStats->uNodeBytes += sizeof(struct Node) +
+			psCurr->uLevels * sizeof(struct Node *);
+		if (! oSymTable->iBorrowKeys)
+			psStats->uKeyBytes += strlen(psCurr->pcKey) + 1;
+	}
+
+	psStats->uTotalBytes = psStats->uStructBytes + psStats->uNodeBytes +
+		psStats->uKeyBytes;
+}
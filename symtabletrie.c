@@ -0,0 +1,1036 @@
+/*-------------------------------------------------------------------*/
+/* symtabletrie.c                                                    */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* A SymTable kept as a radix tree: keys that share a prefix share the
+   path of Nodes that spells it, so a lookup looks at each byte of its
+   key once instead of comparing the whole key against every key in a
+   chain. As in an adaptive radix tree, each Node's child array grows
+   through a few sizes as children are added, and a Node with a
+   single child and no binding is merged into that child, so that
+   runs of unbranched bytes cost one Node. */
+
+#include <string.h>
+#include "symtabletrie.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/*-------------------------------------------------------------------*/
+
+/* The sizes that a child array may have, smallest first. A Node can
+   have at most one child per byte value. */
+
+static const size_t auSlotCounts[] = {4, 16, 48, 256};
+
+/*-------------------------------------------------------------------*/
+
+/* SymTable is a structure to maintain a counter for the number of
+   bindings in a Symbol Table and a pointer to the root Node. */
+
+struct SymTable
+{
+	/* The root of the tree, or NULL if it is empty. */
+	struct Node *psRoot;
+
+	/* variable to store size of st */
+	size_t uCount;
+
+	/* 1 if Nodes point to the client's keys instead of copies. */
+	int iBorrowKeys;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Node is a structure that stands for the key prefix that leads to
+   it. It holds a binding if that prefix is itself a key, and has a
+   child for each byte that follows the prefix in a longer key. */
+
+struct Node
+{
+	/* The key of some binding at or below this Node. Its first uEnd
+	   bytes are the prefix that leads to this Node; those after the
+	   parent's uEnd + 1 are the ones that the Node adds. If the Node
+	   holds a binding, this is that binding's key. */
+	const char *pcKey;
+	size_t uEnd;
+
+	/* 1 if the Node holds a binding, with value pvValue. */
+	int iBound;
+	void *pvValue;
+
+	/* The Node one level up, or NULL for the root. */
+	struct Node *psParent;
+
+	/* ppsChildren[i] is the child reached by byte pucBytes[i]; the
+	   bytes are in increasing order. Both arrays live in one block
+	   with room for uSlots children, of which uChildren are used. */
+	struct Node **ppsChildren;
+	unsigned char *pucBytes;
+	size_t uChildren;
+	size_t uSlots;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Special function to allocate a Node with no children. */
+
+static struct Node *SymTable_newNode(const char *pcKey, size_t uEnd);
+
+/* Special function to free a Node of a SymTable. */
+
+static void SymTable_freeNode(SymTable_T oSymTable,
+	struct Node *psNode);
+
+/* Special function to give a Node room for uSlots children. */
+
+static int SymTable_setSlots(struct Node *psNode, size_t uSlots);
+
+/* Special function to make room for one more child. */
+
+static int SymTable_makeRoom(struct Node *psNode);
+
+/* Special function to find the child reached by a byte. */
+
+static size_t SymTable_findChild(struct Node *psNode, char cByte);
+
+/* Special function to add a child. */
+
+static void SymTable_addChild(struct Node *psNode, struct Node *psChild,
+	char cByte);
+
+/* Special function to remove a child. */
+
+static void SymTable_removeChild(struct Node *psNode, size_t uIndex);
+
+/* Special function to find the first binding under a Node. */
+
+static struct Node *SymTable_first(struct Node *psNode);
+
+/* Special function to find the first binding after a subtree. */
+
+static struct Node *SymTable_skip(struct Node *psNode,
+	struct Node *psTop);
+
+/* Special function to find the binding after a Node. */
+
+static struct Node *SymTable_next(struct Node *psNode,
+	struct Node *psTop);
+
+/* Special function to find the first binding not less than a key. */
+
+static struct Node *SymTable_lowerBound(SymTable_T oSymTable,
+	const char *pcLow);
+
+/* Special function to free every Node of oSymTable. */
+
+static void SymTable_freeNodes(SymTable_T oSymTable);
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+	SymTable_T oSymTable;
+
+	/* Allocate memory and return if it is unsufficient. */
+	oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+	if (oSymTable == NULL) return NULL;
+
+	oSymTable->psRoot = NULL;
+	oSymTable->uCount = 0;
+	oSymTable->iBorrowKeys = 0;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithHash(size_t (*pfHash)(const char *pcKey))
+{
+	assert(pfHash != NULL);
+
+	/* A radix tree branches on the bytes of its keys, which a hash
+	   code cannot stand in for, so *pfHash is never called. */
+	(void)pfHash;
+	return SymTable_new();
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void)
+{
+	SymTable_T oSymTable;
+
+	oSymTable = SymTable_new();
+	if (oSymTable == NULL) return NULL;
+	oSymTable->iBorrowKeys = 1;
+	return oSymTable;
+}
+
+/*-------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+	/* A radix tree has no array to size; its nodes are allocated as
+	   bindings are put. */
+	(void)uCapacity;
+	return SymTable_new();
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+	assert(oSymTable != NULL);
+
+	/* A radix tree never resizes as a whole, so it is always big
+	   enough. */
+	(void)uCapacity;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return a new Node that holds no binding and has no children, whose
+   prefix is the first uEnd bytes of pcKey, or NULL if insufficient
+   memory is available. */
+
+static struct Node *SymTable_newNode(const char *pcKey, size_t uEnd)
+{
+	struct Node *psNode;
+
+	assert(pcKey != NULL);
+
+	psNode = (struct Node *)malloc(sizeof(struct Node));
+	if (psNode == NULL) return NULL;
+	psNode->pcKey = pcKey;
+	psNode->uEnd = uEnd;
+	psNode->iBound = 0;
+	psNode->pvValue = NULL;
+	psNode->psParent = NULL;
+	psNode->ppsChildren = NULL;
+	psNode->pucBytes = NULL;
+	psNode->uChildren = 0;
+	psNode->uSlots = 0;
+	return psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Free psNode, a Node of oSymTable, its child array, and its key if
+   it holds a binding and oSymTable owns its keys, but not its
+   children. */
+
+static void SymTable_freeNode(SymTable_T oSymTable,
+	struct Node *psNode)
+{
+	assert(oSymTable != NULL);
+	assert(psNode != NULL);
+
+	free(psNode->ppsChildren);
+	if (psNode->iBound && ! oSymTable->iBorrowKeys)
+		free((char *)psNode->pcKey);
+	free(psNode);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Move the children of psNode to a block with room for uSlots of
+   them, or free its block if uSlots is 0. Return 1, or 0 with psNode
+   unchanged if insufficient memory is available. */
+
+static int SymTable_setSlots(struct Node *psNode, size_t uSlots)
+{
+	struct Node **ppsChildren = NULL;
+	unsigned char *pucBytes = NULL;
+
+	assert(psNode != NULL);
+	assert(uSlots >= psNode->uChildren);
+
+	/* The pointers come first, so that they are aligned. */
+	if (uSlots > 0)
+	{
+		ppsChildren = (struct Node **)malloc(uSlots *
+			(sizeof(struct Node *) + 1));
+		if (ppsChildren == NULL) return 0;
+		pucBytes = (unsigned char *)(ppsChildren + uSlots);
+		if (psNode->uChildren > 0)
+		{
+			memcpy(ppsChildren, psNode->ppsChildren,
+				psNode->uChildren * sizeof(struct Node *));
+			memcpy(pucBytes, psNode->pucBytes, psNode->uChildren);
+		}
+	}
+
+	free(psNode->ppsChildren);
+	psNode->ppsChildren = ppsChildren;
+	psNode->pucBytes = pucBytes;
+	psNode->uSlots = uSlots;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Make sure psNode has room for one more child, growing its child
+   array to the next size if it is full. Return 1, or 0 with psNode
+   unchanged if insufficient memory is available. */
+
+static int SymTable_makeRoom(struct Node *psNode)
+{
+	size_t uClass;
+
+	assert(psNode != NULL);
+
+	if (psNode->uChildren < psNode->uSlots) return 1;
+	for (uClass = 0; auSlotCounts[uClass] <= psNode->uSlots; uClass++)
+		;
+	return SymTable_setSlots(psNode, auSlotCounts[uClass]);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the index in psNode's child array of the child reached by
+   byte cByte, or psNode->uChildren if there is none. */
+
+static size_t SymTable_findChild(struct Node *psNode, char cByte)
+{
+	const unsigned char *pucFound;
+
+	assert(psNode != NULL);
+
+	if (psNode->uChildren == 0) return 0;
+	pucFound = (const unsigned char *)memchr(psNode->pucBytes,
+		(unsigned char)cByte, psNode->uChildren);
+	if (pucFound == NULL) return psNode->uChildren;
+	return (size_t)(pucFound - psNode->pucBytes);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Add psChild as the child of psNode reached by byte cByte, keeping
+   the bytes in order. psNode must have room for it and no child for
+   cByte yet. */
+
+static void SymTable_addChild(struct Node *psNode, struct Node *psChild,
+	char cByte)
+{
+	size_t uIndex;
+
+	assert(psNode != NULL);
+	assert(psChild != NULL);
+	assert(psNode->uChildren < psNode->uSlots);
+
+	for (uIndex = psNode->uChildren; uIndex > 0 &&
+		psNode->pucBytes[uIndex - 1] > (unsigned char)cByte; uIndex--)
+	{
+		psNode->ppsChildren[uIndex] = psNode->ppsChildren[uIndex - 1];
+		psNode->pucBytes[uIndex] = psNode->pucBytes[uIndex - 1];
+	}
+	psNode->ppsChildren[uIndex] = psChild;
+	psNode->pucBytes[uIndex] = (unsigned char)cByte;
+	psNode->uChildren++;
+	psChild->psParent = psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Remove the child at index uIndex of psNode's child array, but do
+   not free it. Move the rest to a smaller array once they fit in
+   half of one. */
+
+static void SymTable_removeChild(struct Node *psNode, size_t uIndex)
+{
+	size_t uClass;
+
+	assert(psNode != NULL);
+	assert(uIndex < psNode->uChildren);
+
+	psNode->uChildren--;
+	memmove(psNode->ppsChildren + uIndex,
+		psNode->ppsChildren + uIndex + 1,
+		(psNode->uChildren - uIndex) * sizeof(struct Node *));
+	memmove(psNode->pucBytes + uIndex, psNode->pucBytes + uIndex + 1,
+		psNode->uChildren - uIndex);
+
+	/* A smaller array is only a saving, so keep this one if there is
+	   not enough memory to move. */
+	if (psNode->uChildren == 0)
+	{
+		(void)SymTable_setSlots(psNode, 0);
+		return;
+	}
+	for (uClass = 0; auSlotCounts[uClass] < psNode->uSlots; uClass++)
+		;
+	if (uClass > 0 && psNode->uChildren <= auSlotCounts[uClass - 1] / 2)
+		(void)SymTable_setSlots(psNode, auSlotCounts[uClass - 1]);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node holding the binding with the smallest key at or
+   below psNode. A Node without a binding always has a child. */
+
+static struct Node *SymTable_first(struct Node *psNode)
+{
+	assert(psNode != NULL);
+
+	while (! psNode->iBound)
+	{
+		assert(psNode->uChildren > 0);
+		psNode = psNode->ppsChildren[0];
+	}
+	return psNode;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node holding the first binding in key order that is
+   after every binding at or below psNode, but still at or below
+   psTop, or NULL if there is none. If psTop is NULL, any binding of
+   the tree will do. */
+
+static struct Node *SymTable_skip(struct Node *psNode,
+	struct Node *psTop)
+{
+	struct Node *psParent;
+	size_t uIndex;
+
+	assert(psNode != NULL);
+
+	/* Climb until some ancestor has a later child. */
+	while (psNode != psTop && psNode->psParent != NULL)
+	{
+		psParent = psNode->psParent;
+		uIndex = SymTable_findChild(psParent,
+			psNode->pcKey[psParent->uEnd]);
+		if (uIndex + 1 < psParent->uChildren)
+			return SymTable_first(psParent->ppsChildren[uIndex + 1]);
+		psNode = psParent;
+	}
+	return NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node holding the binding that follows psNode's in key
+   order and is at or below psTop, or NULL if there is none. If psTop
+   is NULL, any binding of the tree will do. */
+
+static struct Node *SymTable_next(struct Node *psNode,
+	struct Node *psTop)
+{
+	assert(psNode != NULL);
+
+	/* A Node's key is a prefix of, and so less than, every key below
+	   it. */
+	if (psNode->uChildren > 0)
+		return SymTable_first(psNode->ppsChildren[0]);
+	return SymTable_skip(psNode, psTop);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Free every Node of oSymTable and its key, children before their
+   parents. Leave the root pointer and count as they are. */
+
+static void SymTable_freeNodes(SymTable_T oSymTable)
+{
+	struct Node *psNode;
+	struct Node *psParent;
+
+	assert(oSymTable != NULL);
+
+	psNode = oSymTable->psRoot;
+	while (psNode != NULL)
+	{
+		if (psNode->uChildren > 0)
+		{
+			psNode->uChildren--;
+			psNode = psNode->ppsChildren[psNode->uChildren];
+		}
+		else
+		{
+			psParent = psNode->psParent;
+			SymTable_freeNode(oSymTable, psNode);
+			psNode = psParent;
+		}
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	SymTable_freeNodes(oSymTable);
+	free(oSymTable);
+}
+
+/*-------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	/* Return length count from SymTable structure. */
+	return oSymTable->uCount;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node of oSymTable that holds the binding with key pcKey,
+   or NULL if there is none. */
+
+static struct Node *SymTable_find(SymTable_T oSymTable,
+	const char *pcKey)
+{
+	struct Node *psNode;
+	size_t uPos = 0;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Match each Node's bytes, then branch on the byte after them. A
+	   key that ends early differs at its '\0'. */
+	for (psNode = oSymTable->psRoot; psNode != NULL;
+		psNode = psNode->ppsChildren[uIndex])
+	{
+		for (; uPos < psNode->uEnd; uPos++)
+			if (pcKey[uPos] != psNode->pcKey[uPos]) return NULL;
+		if (pcKey[uPos] == '\0')
+			return psNode->iBound ? psNode : NULL;
+		uIndex = SymTable_findChild(psNode, pcKey[uPos]);
+		if (uIndex == psNode->uChildren) return NULL;
+		uPos++;
+	}
+	return NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Return 1 only if a new binding was added; leave an existing
+	   binding with key pcKey unchanged. */
+	if (SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded) == NULL)
+		return 0;
+	return iAdded;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	struct Node *psNode;
+	void *pvOldValue;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psNode = SymTable_find(oSymTable, pcKey);
+	if (psNode == NULL) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = psNode->pvValue;
+	psNode->pvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	return SymTable_find(oSymTable, pcKey) != NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Node *psNode;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	psNode = SymTable_find(oSymTable, pcKey);
+	if (psNode == NULL) return NULL;
+	return psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+	assert(oSymTable != NULL);
+
+	/* Every Node and child array is shaped by the keys it leads to,
+	   so a refill with other keys could not reuse them. With no pool
+	   and no bucket array, symtable.h lets clear free them as
+	   SymTable_free does. */
+	SymTable_freeNodes(oSymTable);
+	oSymTable->psRoot = NULL;
+	oSymTable->uCount = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+	struct Node **ppsSlot = &oSymTable->psRoot;
+	struct Node **ppsParentSlot = NULL;
+	struct Node *psNode;
+	struct Node *psParent;
+	struct Node *psLeft;
+	const char *pcGone;
+	const char *pcSpare;
+	void *pvOldValue;
+	size_t uPos = 0;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Find the Node as SymTable_find does, keeping the slots that
+	   point to it and to its parent. */
+	for (;;)
+	{
+		psNode = *ppsSlot;
+		if (psNode == NULL) return NULL;
+		for (; uPos < psNode->uEnd; uPos++)
+			if (pcKey[uPos] != psNode->pcKey[uPos]) return NULL;
+		if (pcKey[uPos] == '\0') break;
+		uIndex = SymTable_findChild(psNode, pcKey[uPos]);
+		if (uIndex == psNode->uChildren) return NULL;
+		ppsParentSlot = ppsSlot;
+		ppsSlot = &psNode->ppsChildren[uIndex];
+		uPos++;
+	}
+	if (! psNode->iBound) return NULL;
+
+	pvOldValue = psNode->pvValue;
+	pcGone = psNode->pcKey;
+	psNode->iBound = 0;
+	oSymTable->uCount--;
+
+	/* Keep every Node without a binding branching: drop the Node if
+	   it has no children left, then merge whichever of it or its
+	   parent has a single child into that child. psLeft is the
+	   deepest Node left on the path. */
+	psParent = psNode->psParent;
+	if (psNode->uChildren == 0)
+	{
+		if (psParent == NULL) *ppsSlot = NULL;
+		else
+			SymTable_removeChild(psParent,
+				SymTable_findChild(psParent, pcGone[psParent->uEnd]));
+		SymTable_freeNode(oSymTable, psNode);
+		psLeft = psParent;
+		if (psParent != NULL && ! psParent->iBound &&
+			psParent->uChildren == 1)
+		{
+			psLeft = psParent->ppsChildren[0];
+			psLeft->psParent = psParent->psParent;
+			*ppsParentSlot = psLeft;
+			SymTable_freeNode(oSymTable, psParent);
+		}
+	}
+	else if (psNode->uChildren == 1)
+	{
+		psLeft = psNode->ppsChildren[0];
+		psLeft->psParent = psParent;
+		*ppsSlot = psLeft;
+		SymTable_freeNode(oSymTable, psNode);
+	}
+	else psLeft = psNode;
+
+	/* Nodes on the path may still read their bytes from the removed
+	   key, which is uPos bytes long; point them at another key below
+	   the deepest one left, which has all of their prefixes. */
+	if (psLeft != NULL)
+	{
+		pcSpare = SymTable_first(psLeft)->pcKey;
+		for (psNode = oSymTable->psRoot; psNode != NULL;
+			psNode = psNode->ppsChildren[uIndex])
+		{
+			if (psNode->pcKey == pcGone) psNode->pcKey = pcSpare;
+			if (psNode->uEnd >= uPos) break;
+			uIndex = SymTable_findChild(psNode, pcGone[psNode->uEnd]);
+			if (uIndex == psNode->uChildren) break;
+		}
+	}
+
+	if (! oSymTable->iBorrowKeys) free((char *)pcGone);
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue, int *piAdded)
+{
+	struct Node **ppsSlot = &oSymTable->psRoot;
+	struct Node *psParent = NULL;
+	struct Node *psNode;
+	struct Node *psSplit = NULL;
+	struct Node *psLeaf = NULL;
+	char *pcCopy;
+	size_t uPos = 0;
+	size_t uLength;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	/* Walk down as SymTable_find does, and return the address of the
+	   value connected to the query Key if there is one. The walk
+	   stops at the first byte that no Node matches. */
+	for (;;)
+	{
+		psNode = *ppsSlot;
+		if (psNode == NULL) break;
+		for (; uPos < psNode->uEnd; uPos++)
+			if (pcKey[uPos] != psNode->pcKey[uPos]) break;
+		if (uPos < psNode->uEnd) break;
+		if (pcKey[uPos] == '\0')
+		{
+			if (psNode->iBound)
+			{
+				if (piAdded != NULL) *piAdded = 0;
+				return &psNode->pvValue;
+			}
+			break;
+		}
+		uIndex = SymTable_findChild(psNode, pcKey[uPos]);
+		if (uIndex == psNode->uChildren) break;
+		psParent = psNode;
+		ppsSlot = &psNode->ppsChildren[uIndex];
+		uPos++;
+	}
+
+	/* Otherwise allocate the key copy, unless the key is borrowed,
+	   and every Node and array that the insert needs before changing
+	   anything, and return NULL if there is insufficient memory. */
+	uLength = uPos + strlen(pcKey + uPos);
+	if (oSymTable->iBorrowKeys)
+		pcCopy = (char *)pcKey;
+	else
+	{
+		pcCopy = (char *)malloc(uLength + 1);
+		if (pcCopy == NULL) return NULL;
+		strcpy(pcCopy, pcKey);
+	}
+	if (psNode != NULL && uPos < psNode->uEnd)
+	{
+		/* The key leaves psNode's bytes part way: a new Node for the
+		   shared part takes psNode's place, with psNode as a child. */
+		psSplit = SymTable_newNode(psNode->pcKey, uPos);
+		if (psSplit == NULL || ! SymTable_setSlots(psSplit,
+			auSlotCounts[0]))
+		{
+			if (psSplit != NULL) SymTable_freeNode(oSymTable, psSplit);
+			if (! oSymTable->iBorrowKeys) free(pcCopy);
+			return NULL;
+		}
+	}
+	else if (psNode != NULL && pcKey[uPos] != '\0' &&
+		! SymTable_makeRoom(psNode))
+	{
+		if (! oSymTable->iBorrowKeys) free(pcCopy);
+		return NULL;
+	}
+	if (psNode == NULL || pcKey[uPos] != '\0')
+	{
+		psLeaf = SymTable_newNode(pcCopy, uLength);
+		if (psLeaf == NULL)
+		{
+			if (psSplit != NULL) SymTable_freeNode(oSymTable, psSplit);
+			if (! oSymTable->iBorrowKeys) free(pcCopy);
+			return NULL;
+		}
+	}
+
+	/* Link in the split Node, then bind the key to a new leaf or to
+	   the Node whose prefix it is. */
+	if (psSplit != NULL)
+	{
+		psSplit->psParent = psParent;
+		SymTable_addChild(psSplit, psNode, psNode->pcKey[uPos]);
+		*ppsSlot = psSplit;
+		psNode = psSplit;
+	}
+	if (psLeaf != NULL)
+	{
+		if (psNode == NULL) *ppsSlot = psLeaf;
+		else SymTable_addChild(psNode, psLeaf, pcKey[uPos]);
+		psNode = psLeaf;
+	}
+	psNode->pcKey = pcCopy;
+	psNode->iBound = 1;
+	psNode->pvValue = (void *)pvValue;
+
+	/* Increment binding count of oSymTable. */
+	oSymTable->uCount++;
+	if (piAdded != NULL) *piAdded = 1;
+	return &psNode->pvValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+	const void *pvValue)
+{
+	void **ppvValue;
+	void *pvOldValue;
+	int iAdded;
+
+	assert(oSymTable != NULL);
+	assert(pcKey != NULL);
+
+	ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iAdded);
+	if (ppvValue == NULL || iAdded) return NULL;
+
+	/* Save & return old value, & overwrite with new value */
+	pvOldValue = *ppvValue;
+	*ppvValue = (void *)pvValue;
+	return pvOldValue;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Node *psNode;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	if (oSymTable->psRoot == NULL) return;
+
+	/* Visit the bindings in key order and apply function pfApply to
+	   each one. */
+	for (psNode = SymTable_first(oSymTable->psRoot); psNode != NULL;
+		psNode = SymTable_next(psNode, NULL))
+		(*pfApply)(psNode->pcKey, psNode->pvValue, (void *)pvExtra);
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Node *psTop;
+	struct Node *psNode;
+	size_t uPos = 0;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcPrefix != NULL);
+	assert(pfApply != NULL);
+
+	/* Walk down as SymTable_find does until pcPrefix runs out; the
+	   keys that begin with it are those at or below that Node. */
+	for (psTop = oSymTable->psRoot; psTop != NULL;
+		psTop = psTop->ppsChildren[uIndex])
+	{
+		for (; uPos < psTop->uEnd && pcPrefix[uPos] != '\0'; uPos++)
+			if (pcPrefix[uPos] != psTop->pcKey[uPos]) return;
+		if (pcPrefix[uPos] == '\0') break;
+		uIndex = SymTable_findChild(psTop, pcPrefix[uPos]);
+		if (uIndex == psTop->uChildren) return;
+		uPos++;
+	}
+	if (psTop == NULL) return;
+
+	for (psNode = SymTable_first(psTop); psNode != NULL;
+		psNode = SymTable_next(psNode, psTop))
+		(*pfApply)(psNode->pcKey, psNode->pvValue, (void *)pvExtra);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* Return the Node of oSymTable holding the binding with the smallest
+   key that is not less than pcLow, or NULL if there is none. */
+
+static struct Node *SymTable_lowerBound(SymTable_T oSymTable,
+	const char *pcLow)
+{
+	struct Node *psNode;
+	size_t uPos = 0;
+	size_t uIndex;
+
+	assert(oSymTable != NULL);
+	assert(pcLow != NULL);
+
+	psNode = oSymTable->psRoot;
+	while (psNode != NULL)
+	{
+		/* Where pcLow leaves this Node's bytes, every key below the
+		   Node is on the same side of pcLow. */
+		for (; uPos < psNode->uEnd; uPos++)
+			if (pcLow[uPos] != psNode->pcKey[uPos]) break;
+		if (uPos < psNode->uEnd)
+		{
+			if ((unsigned char)psNode->pcKey[uPos] >
+				(unsigned char)pcLow[uPos])
+				return SymTable_first(psNode);
+			return SymTable_skip(psNode, NULL);
+		}
+		if (pcLow[uPos] == '\0') return SymTable_first(psNode);
+
+		/* Otherwise psNode's own key is less than pcLow, and so is
+		   every key below a child for a smaller byte. */
+		for (uIndex = 0; uIndex < psNode->uChildren &&
+			psNode->pucBytes[uIndex] < (unsigned char)pcLow[uPos];
+			uIndex++)
+			;
+		if (uIndex == psNode->uChildren)
+			return SymTable_skip(psNode, NULL);
+		if (psNode->pucBytes[uIndex] > (unsigned char)pcLow[uPos])
+			return SymTable_first(psNode->ppsChildren[uIndex]);
+		psNode = psNode->ppsChildren[uIndex];
+		uPos++;
+	}
+	return NULL;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+	const char *pcHigh,
+	void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+	const void *pvExtra)
+{
+	struct Node *psNode;
+
+	assert(oSymTable != NULL);
+	assert(pfApply != NULL);
+
+	if (oSymTable->psRoot == NULL) return;
+
+	/* Start at the first key not less than pcLow and stop at the
+	   first key not less than pcHigh. */
+	if (pcLow == NULL) psNode = SymTable_first(oSymTable->psRoot);
+	else psNode = SymTable_lowerBound(oSymTable, pcLow);
+	for (; psNode != NULL; psNode = SymTable_next(psNode, NULL))
+	{
+		if (pcHigh != NULL && strcmp(psNode->pcKey, pcHigh) >= 0) break;
+		(*pfApply)(psNode->pcKey, psNode->pvValue, (void *)pvExtra);
+	}
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+	struct SymTable_Iter *psIter)
+{
+	assert(oSymTable != NULL);
+	assert(psIter != NULL);
+
+	/* Start at the smallest key. */
+	psIter->oSymTable = oSymTable;
+	psIter->pvNext = NULL;
+	if (oSymTable->psRoot != NULL)
+		psIter->pvNext = SymTable_first(oSymTable->psRoot);
+	psIter->auPos[0] = 0;
+	psIter->auPos[1] = 0;
+}
+
+/*-------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTable_Iter *psIter,
+	const char **ppcKey, void **ppvValue)
+{
+	struct Node *psNode;
+
+	assert(psIter != NULL);
+
+	/* Hand out the next binding and step past it. */
+	psNode = (struct Node *)psIter->pvNext;
+	if (psNode == NULL) return 0;
+	psIter->pvNext = SymTable_next(psNode, NULL);
+	if (ppcKey != NULL) *ppcKey = psNode->pcKey;
+	if (ppvValue != NULL) *ppvValue = psNode->pvValue;
+	return 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable,
+	struct SymTable_Stats *psStats)
+{
+	struct Node *psNode;
+	struct Node *psParent;
+	size_t uDepth;
+	size_t uIndex = 0;
+
+	assert(oSymTable != NULL);
+	assert(psStats != NULL);
+
+	memset(psStats, 0, sizeof(struct SymTable_Stats));
+
+	/* The whole tree is one bucket, and a lookup compares its key
+	   with one binding's at most. */
+	psStats->uBindings = oSymTable->uCount;
+	psStats->uBuckets = 1;
+	psStats->uUsedBuckets = oSymTable->uCount != 0;
+	psStats->dLoadFactor = (double)oSymTable->uCount;
+	psStats->uMaxChain = oSymTable->uCount != 0;
+	psStats->dMeanChain = (double)psStats->uMaxChain;
+	psStats->uStructBytes = sizeof(struct SymTable);
+
+	/* Visit every Node, parents before children. A lookup of a
+	   binding's key visits the Node and each of its ancestors. */
+	psNode = oSymTable->psRoot;
+	while (psNode != NULL)
+	{
+		psStats->uNodeBytes += sizeof(struct Node);
+		psStats->uTableBytes += psNode->uSlots *
+			(sizeof(struct Node *) + 1);
+		if (psNode->iBound)
+		{
+			for (uDepth = 1, psParent = psNode->psParent;
+				psParent != NULL; psParent = psParent->psParent)
+				uDepth++;
+			if (uDepth > SYMTABLE_PROBE_MAX)
+				uDepth = SYMTABLE_PROBE_MAX;
+			psStats->auProbes[uDepth - 1]++;
+			if (! oSymTable->iBorrowKeys)
+				psStats->uKeyBytes += strlen(psNode->pcKey) + 1;
+		}
+		if (psNode->uChildren > 0)
+		{
+			psNode = psNode->ppsChildren[0];
+			continue;
+		}
+
+		/* Climb until some ancestor has a later child. */
+		for (psParent = psNode->psParent; psParent != NULL;
+			psParent = psParent->psParent)
+		{
+			uIndex = SymTable_findChild(psParent,
+				psNode->pcKey[psParent->uEnd]) + 1;
+			if (uIndex < psParent->uChildren) break;
+			psNode = psParent;
+		}
+		psNode = NULL;
+		if (psParent != NULL) psNode = psParent->ppsChildren[uIndex];
+	}
+
+	psStats->uTotalBytes = psStats->uStructBytes +
+		psStats->uTableBytes + psStats->uNodeBytes + psStats->uKeyBytes;
+}
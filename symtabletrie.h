@@ -0,0 +1,45 @@
+/*-------------------------------------------------------------------*/
+/* symtabletrie.h                                                    */
+/* Author: Isaac Wolfe                                               */
+/* netid: iwolfe                                                     */
+/*-------------------------------------------------------------------*/
+
+/* Functions that only the radix tree implementation of SymTable
+   (symtabletrie.c) provides, in addition to those of symtable.h. Its
+   SymTable_map and SymTable_iterNext visit the bindings in increasing
+   strcmp order of their keys, and so do the functions below. */
+
+#include "symtable.h"
+
+/*-------------------------------------------------------------------*/
+
+#ifndef SYMTABLETRIE_INCLUDED
+#define SYMTABLETRIE_INCLUDED
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_mapPrefix: Like SymTable_map, applies function *pfApply  *
+ *                     to bindings of oSymTable, but only to those   *
+ *                     whose keys begin with pcPrefix, and without   *
+ *                     visiting any other binding. *pfApply must not *
+ *                     change oSymTable.                             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * SymTable_mapRange: Like SymTable_map, applies function *pfApply   *
+ *                    to bindings of oSymTable, but only to those    *
+ *                    whose keys are not less than pcLow and less    *
+ *                    than pcHigh, as strcmp orders them. Either     *
+ *                    bound may be NULL to leave that end open.      *
+ *                    *pfApply must not change oSymTable.            *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+   const char *pcHigh,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
@@ -0,0 +1,887 @@
+/*--------------------------------------------------------------------*/
+/* testhash.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that only the hash table implementation of
+   SymTable provides (symtablehash.h). */
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* Largest number of threads that the tests ask for. */
+enum {MAX_THREADS = 33};
+
+/* Number of bindings that a small table keeps in its structure, as
+   INLINE_MAX in symtablehash.c. */
+enum {INLINE_MAX = 8};
+
+/*--------------------------------------------------------------------*/
+
+/* A Tally holds what one thread of SymTable_mapParallel has seen. */
+
+struct Tally
+{
+   /* Number of bindings visited, and the sum of their values. */
+   size_t uCount;
+   size_t uSum;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding whose value pvValue points to an int in the
+   Tally pvExtra, and mark the binding as visited by incrementing
+   that int. */
+
+static void tallyBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Tally *psTally = (struct Tally*)pvExtra;
+   int *piValue = (int*)pvValue;
+
+   assert(pcKey != NULL);
+   assert(piValue != NULL);
+   assert(psTally != NULL);
+
+   psTally->uCount++;
+   psTally->uSum += (size_t)atoi(pcKey);
+   (*piValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the Tally pvFrom to the Tally pvInto. */
+
+static void addTally(void *pvInto, void *pvFrom)
+{
+   struct Tally *psInto = (struct Tally*)pvInto;
+   struct Tally *psFrom = (struct Tally*)pvFrom;
+
+   assert(psInto != NULL);
+   assert(psFrom != NULL);
+
+   psInto->uCount += psFrom->uCount;
+   psInto->uSum += psFrom->uSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Map over oSymTable, whose keys are the decimal forms of 0 to
+   iCount - 1 bound to the elements of aiVisits, on uThreads threads,
+   and make sure every binding is visited exactly once. Reduce the
+   tallies if iReduce, and add them up here otherwise. */
+
+static void checkMap(SymTable_T oSymTable, int *aiVisits, int iCount,
+   size_t uThreads, int iReduce)
+{
+   struct Tally asTallies[MAX_THREADS];
+   void *apvExtras[MAX_THREADS];
+   struct Tally sTotal;
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(uThreads <= MAX_THREADS);
+
+   for (u = 0; u < uThreads; u++)
+   {
+      asTallies[u].uCount = 0;
+      asTallies[u].uSum = 0;
+      apvExtras[u] = &asTallies[u];
+   }
+   memset(aiVisits, 0, sizeof(int) * (size_t)(iCount + 1));
+
+   SymTable_mapParallel(oSymTable, tallyBinding, apvExtras, uThreads,
+      iReduce ? addTally : NULL);
+
+   sTotal = asTallies[0];
+   if (! iReduce)
+      for (u = 1; u < uThreads; u++)
+         addTally(&sTotal, &asTallies[u]);
+   ASSURE(sTotal.uCount == (size_t)iCount);
+   ASSURE(sTotal.uSum == (size_t)iCount * (size_t)(iCount - 1) / 2);
+   for (i = 0; i < iCount; i++)
+      ASSURE(aiVisits[i] == 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_mapParallel() function on tables of up to
+   iBindingCount bindings: empty, small enough to keep their bindings
+   inline, in the middle of a resize, and large. */
+
+static void testMapParallel(int iBindingCount)
+{
+   static const size_t auThreads[] = {1, 2, 4, 8, MAX_THREADS};
+   enum {STEP_LIMIT = 3000};
+
+   SymTable_T oSymTable;
+   char acKey[16];
+   int *aiVisits;
+   size_t u;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapParallel() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiVisits = (int*)malloc(sizeof(int) * (size_t)(iBindingCount + 1));
+   ASSURE(aiVisits != NULL);
+   if (aiVisits == NULL) return;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Check every count up to STEP_LIMIT, which passes through small
+      tables and several incremental resizes. */
+   checkMap(oSymTable, aiVisits, 0, 4, 1);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+      if (i < STEP_LIMIT)
+         checkMap(oSymTable, aiVisits, i + 1, auThreads[i % 5], i % 2);
+   }
+
+   /* Check the full table on every thread count. */
+   for (u = 0; u < sizeof(auThreads) / sizeof(auThreads[0]); u++)
+   {
+      checkMap(oSymTable, aiVisits, iBindingCount, auThreads[u], 1);
+      checkMap(oSymTable, aiVisits, iBindingCount, auThreads[u], 0);
+   }
+
+   SymTable_free(oSymTable);
+   free(aiVisits);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure oSymTable holds exactly the keys that are the decimal
+   forms of the multiples of iStride below iCount, each bound to its
+   own aiVisits element. */
+
+static void checkKeys(SymTable_T oSymTable, int *aiVisits, int iCount,
+   int iStride)
+{
+   char acKey[16];
+   int i;
+
+   assert(oSymTable != NULL);
+
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)((iCount + iStride - 1) / iStride));
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % iStride == 0)
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiVisits[i]);
+      else
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a table of iBindingCount bindings shrinks as nearly all
+   of them are removed, without any one remove moving the whole of
+   an array, does not resize back and forth when bindings are added
+   and removed around a size boundary, and that SymTable_compact()
+   shrinks it at once. */
+
+static void testShrink(int iBindingCount)
+{
+   enum {KEPT_STRIDE = 100, THRASH_ROUNDS = 1000};
+   enum {DRAIN_COUNT = 4096, REMOVE_STEP_MAX = 16};
+
+   SymTable_T oSymTable;
+   struct SymTable_Stats sStats;
+   char acKey[16];
+   int *aiVisits;
+   size_t uPeakBuckets;
+   size_t uBuckets;
+   size_t uResizes;
+   int iSuccessful;
+   int iDrainCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing shrinking and the SymTable_compact() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiVisits = (int*)malloc(sizeof(int) * (size_t)(iBindingCount + 1));
+   ASSURE(aiVisits != NULL);
+   if (aiVisits == NULL) return;
+
+   /* Drain a table one remove at a time. The buckets counted by
+      SymTable_getStats() are the new array and what is left of the
+      old one, so they may fall only by the few old buckets that a
+      remove moves, even when a remove starts a shrink while the last
+      one is still going. */
+   iDrainCount = iBindingCount < DRAIN_COUNT ? iBindingCount :
+      DRAIN_COUNT;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iDrainCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   for (i = 0; i < iDrainCount; i++)
+   {
+      uBuckets = sStats.uBuckets;
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[i]);
+      SymTable_getStats(oSymTable, &sStats);
+      ASSURE(sStats.uBuckets + REMOVE_STEP_MAX >= uBuckets);
+   }
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   uPeakBuckets = sStats.uBuckets;
+
+   /* Remove all but every KEPT_STRIDEth key. Every lookup must still
+      succeed while the table shrinks under it. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % KEPT_STRIDE == 0) continue;
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[i]);
+   }
+   checkKeys(oSymTable, aiVisits, iBindingCount, KEPT_STRIDE);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBuckets <= uPeakBuckets);
+   ASSURE(iBindingCount < 100000 || sStats.uBuckets < uPeakBuckets / 8);
+
+   /* Add and remove one binding over and over. */
+   uResizes = sStats.uResizes;
+   for (i = 0; i < THRASH_ROUNDS; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, "thrash", NULL);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_remove(oSymTable, "thrash") == NULL);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uResizes <= uResizes + 2);
+
+   /* Compact what is left, twice, and make sure nothing was lost. A
+      table small enough to keep its bindings inline counts as one
+      bucket, and a bucket array never has fewer than 512. */
+   SymTable_compact(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBuckets == 1 ||
+      sStats.uBuckets >= 2 * sStats.uBindings);
+   ASSURE(sStats.uBuckets <= 512 ||
+      sStats.uBuckets < 4 * sStats.uBindings);
+   uResizes = sStats.uResizes;
+   SymTable_compact(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uResizes == uResizes);
+   checkKeys(oSymTable, aiVisits, iBindingCount, KEPT_STRIDE);
+
+   /* Remove the rest; the table must keep working afterwards. */
+   for (i = 0; i < iBindingCount; i += KEPT_STRIDE)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[i]);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_compact(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "0", &aiVisits[0]);
+   ASSURE(iSuccessful);
+   checkKeys(oSymTable, aiVisits, 1, 1);
+
+   SymTable_free(oSymTable);
+   free(aiVisits);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new copy of the key for number i: its decimal form, padded
+   out with 'x's past the length of any size class if i is a multiple
+   of LONG_KEY_STRIDE. Exit with EXIT_FAILURE if insufficient memory
+   is available. */
+
+static char *makeKey(int i)
+{
+   enum {LONG_KEY_STRIDE = 7, LONG_KEY_LENGTH = 300};
+
+   char *pcKey;
+
+   pcKey = (char*)malloc(LONG_KEY_LENGTH + 1);
+   if (pcKey == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   sprintf(pcKey, "%d", i);
+   if (i % LONG_KEY_STRIDE == 0)
+   {
+      memset(pcKey + strlen(pcKey), 'x', LONG_KEY_LENGTH - strlen(pcKey));
+      pcKey[LONG_KEY_LENGTH] = '\0';
+   }
+   return pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_putMany() function with iBindingCount keys, some
+   of them long, some already in the table, and some repeated later in
+   the same call, on several numbers of threads. Then make sure the
+   bulk-loaded bindings can be removed and put back one at a time. */
+
+static void testPutMany(int iBindingCount)
+{
+   static const size_t auThreads[] = {1, 4, MAX_THREADS};
+   static const char *const apcSmallKeys[] = {"a", "b", "a"};
+   enum {EXISTING_STRIDE = 3, REPEAT_DIVISOR = 4};
+
+   SymTable_T oSymTable;
+   struct SymTable_Stats sStats;
+   void *apvSmallValues[3];
+   int aiSmallVisits[3];
+   char **ppcKeys;
+   void **ppvValues;
+   int *aiVisits;
+   int *aiAdded;
+   size_t uResizes;
+   size_t u;
+   int iCount;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_putMany() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Every key once, then the first quarter of them again. */
+   iCount = iBindingCount + iBindingCount / REPEAT_DIVISOR;
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)iCount);
+   ppvValues = (void**)malloc(sizeof(void*) * (size_t)iCount);
+   aiVisits = (int*)malloc(sizeof(int) * (size_t)iBindingCount);
+   aiAdded = (int*)malloc(sizeof(int) * ((size_t)iCount + 3));
+   ASSURE(ppcKeys != NULL && ppvValues != NULL && aiVisits != NULL &&
+      aiAdded != NULL);
+   if (ppcKeys == NULL || ppvValues == NULL || aiVisits == NULL ||
+      aiAdded == NULL)
+      return;
+   for (i = 0; i < iCount; i++)
+   {
+      ppcKeys[i] = makeKey(i % iBindingCount);
+      ppvValues[i] = i < iBindingCount ? &aiVisits[i] : NULL;
+   }
+
+   for (u = 0; u < sizeof(auThreads) / sizeof(auThreads[0]); u++)
+   {
+      /* Some keys are in the table before the bulk put. */
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      for (i = 0; i < iBindingCount; i += EXISTING_STRIDE)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[i], &aiVisits[i]);
+         ASSURE(iSuccessful);
+      }
+
+      SymTable_getStats(oSymTable, &sStats);
+      uResizes = sStats.uResizes;
+      iSuccessful = SymTable_putMany(oSymTable,
+         (const char *const *)ppcKeys, ppvValues, (size_t)iCount,
+         auThreads[u], aiAdded);
+      ASSURE(iSuccessful);
+      SymTable_getStats(oSymTable, &sStats);
+      ASSURE(sStats.uResizes <= uResizes + 1);
+      for (i = 0; i < iCount; i++)
+         ASSURE(aiAdded[i] ==
+            (i < iBindingCount && i % EXISTING_STRIDE != 0));
+
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(SymTable_get(oSymTable, ppcKeys[i]) == &aiVisits[i]);
+
+      /* Remove every other binding and put it back by itself. */
+      for (i = 0; i < iBindingCount; i += 2)
+         ASSURE(SymTable_remove(oSymTable, ppcKeys[i]) == &aiVisits[i]);
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount / 2));
+      for (i = 0; i < iBindingCount; i += 2)
+      {
+         iSuccessful = SymTable_put(oSymTable, ppcKeys[i], &aiVisits[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(SymTable_get(oSymTable, ppcKeys[i]) == &aiVisits[i]);
+      SymTable_free(oSymTable);
+   }
+
+   /* Calls small enough for the table to keep inline, one with a
+      repeat, and an empty call. */
+   for (i = 0; i < 3; i++)
+      apvSmallValues[i] = &aiSmallVisits[i];
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_putMany(oSymTable, apcSmallKeys,
+      apvSmallValues, 3, 4, aiAdded);
+   ASSURE(iSuccessful);
+   ASSURE(aiAdded[0] == 1 && aiAdded[1] == 1 && aiAdded[2] == 0);
+   iSuccessful = SymTable_putMany(oSymTable, apcSmallKeys + 1,
+      apvSmallValues + 1, 2, 1, NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putMany(oSymTable, apcSmallKeys,
+      apvSmallValues, 0, 1, aiAdded);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(SymTable_get(oSymTable, "a") == &aiSmallVisits[0]);
+   ASSURE(SymTable_get(oSymTable, "b") == &aiSmallVisits[1]);
+   SymTable_free(oSymTable);
+
+   for (i = 0; i < iCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+   free(ppvValues);
+   free(aiVisits);
+   free(aiAdded);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pvBuffer, if they fit in uRoom bytes, the int that pvValue
+   points to and then as many filler bytes as that int modulo
+   FILLER_MODULUS times 100, so that some values are large. Return
+   the number of bytes written, or that would have been. */
+
+static size_t serializeInt(const char *pcKey, void *pvValue,
+   void *pvBuffer, size_t uRoom, void *pvExtra)
+{
+   enum {FILLER_MODULUS = 11};
+
+   size_t uSize;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvBuffer != NULL);
+
+   (void)pvExtra;
+   uSize = sizeof(int) +
+      (size_t)(*(int*)pvValue % FILLER_MODULUS) * 100;
+   if (uSize <= uRoom)
+   {
+      memcpy(pvBuffer, pvValue, sizeof(int));
+      memset((char*)pvBuffer + sizeof(int), 'v', uSize - sizeof(int));
+   }
+   return uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count in the int that pvExtra points to the binding whose value
+   pvValue is an int equal to three times the number that its key
+   pcKey starts with. */
+
+static void countMapped(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   if (*(int*)pvValue == 3 * atoi(pcKey)) (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure the mapped oSymTable holds exactly the iCount keys
+   ppcKeys, each bound to the serialized form of three times its
+   number, and that its map, iterator and statistics agree. */
+
+static void checkMapped(SymTable_T oSymTable, char **ppcKeys,
+   int iCount)
+{
+   struct SymTable_Iter sIter;
+   struct SymTable_Stats sStats;
+   const char *pcKey;
+   void *pvValue;
+   size_t uProbed = 0;
+   int iGood = 0;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(ppcKeys != NULL);
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iCount);
+   for (i = 0; i < iCount; i++)
+   {
+      pvValue = SymTable_get(oSymTable, ppcKeys[i]);
+      ASSURE(pvValue != NULL);
+      ASSURE(((size_t)pvValue & 15) == 0);
+      if (pvValue != NULL) ASSURE(*(int*)pvValue == 3 * i);
+      ASSURE(SymTable_contains(oSymTable, ppcKeys[i]));
+   }
+   ASSURE(! SymTable_contains(oSymTable, "-1"));
+   ASSURE(SymTable_get(oSymTable, "") == NULL);
+
+   SymTable_map(oSymTable, countMapped, &iGood);
+   ASSURE(iGood == iCount);
+   SymTable_iterBegin(oSymTable, &sIter);
+   for (i = 0; SymTable_iterNext(&sIter, &pcKey, &pvValue); i++)
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   ASSURE(i == iCount);
+
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBindings == (size_t)iCount);
+   ASSURE(sStats.uUsedBuckets <= sStats.uBuckets);
+   ASSURE(sStats.uMaxChain <= (size_t)iCount);
+   for (i = 0; i < SYMTABLE_PROBE_MAX; i++)
+      uProbed += sStats.auProbes[i];
+   ASSURE(uProbed == (size_t)iCount);
+   ASSURE(sStats.uTotalBytes == sStats.uStructBytes +
+      sStats.uTableBytes + sStats.uNodeBytes + sStats.uKeyBytes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_save() and SymTable_openMapped() with iBindingCount
+   bindings, some with long keys or large values: a saved table maps
+   back with the same bindings, a mapped table saves again, and files
+   that do not hold a whole image are refused. */
+
+static void testSaveMapped(int iBindingCount)
+{
+   static const char acPath[] = "testhash.img";
+   static const char acOtherPath[] = "testhash2.img";
+
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   SymTable_T oRemapped;
+   FILE *psFile;
+   char **ppcKeys;
+   int *aiValues;
+   char *pcImage;
+   long lBytes;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_save() and SymTable_openMapped().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)iBindingCount);
+   aiValues = (int*)malloc(sizeof(int) * (size_t)iBindingCount);
+   oSymTable = SymTable_new();
+   ASSURE(ppcKeys != NULL && aiValues != NULL && oSymTable != NULL);
+   if (ppcKeys == NULL || aiValues == NULL || oSymTable == NULL)
+      return;
+
+   /* An empty table maps back empty. */
+   iSuccessful = SymTable_save(oSymTable, acPath, serializeInt, NULL);
+   ASSURE(iSuccessful);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      checkMapped(oMapped, ppcKeys, 0);
+      SymTable_free(oMapped);
+   }
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      ppcKeys[i] = makeKey(i);
+      aiValues[i] = 3 * i;
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Save and map the table, then save and map the mapped table. */
+   iSuccessful = SymTable_save(oSymTable, acPath, serializeInt, NULL);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      checkMapped(oMapped, ppcKeys, iBindingCount);
+      iSuccessful = SymTable_save(oMapped, acOtherPath, serializeInt,
+         NULL);
+      ASSURE(iSuccessful);
+      oRemapped = SymTable_openMapped(acOtherPath);
+      ASSURE(oRemapped != NULL);
+      if (oRemapped != NULL)
+      {
+         checkMapped(oRemapped, ppcKeys, iBindingCount);
+         SymTable_free(oRemapped);
+      }
+
+      /* Saving another table over the file a table maps leaves the
+         mapped table intact. */
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable != NULL)
+      {
+         iSuccessful = SymTable_save(oSymTable, acPath, serializeInt,
+            NULL);
+         ASSURE(iSuccessful);
+         SymTable_free(oSymTable);
+      }
+      checkMapped(oMapped, ppcKeys, iBindingCount);
+      SymTable_free(oMapped);
+   }
+
+   /* A file that cannot be written or read, or that holds part of an
+      image, gives no table. */
+   ASSURE(! SymTable_save(oSymTable = SymTable_new(),
+      "no/such/directory/testhash.img", serializeInt, NULL));
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_openMapped("no/such/directory/testhash.img") ==
+      NULL);
+   psFile = fopen(acPath, "rb");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      fseek(psFile, 0, SEEK_END);
+      lBytes = ftell(psFile);
+      rewind(psFile);
+      pcImage = (char*)malloc((size_t)lBytes);
+      ASSURE(pcImage != NULL);
+      if (pcImage != NULL)
+      {
+         ASSURE(fread(pcImage, 1, (size_t)lBytes, psFile) ==
+            (size_t)lBytes);
+         fclose(psFile);
+         psFile = fopen(acOtherPath, "wb");
+         ASSURE(psFile != NULL);
+         ASSURE(fwrite(pcImage, 1, (size_t)lBytes - 1, psFile) ==
+            (size_t)lBytes - 1);
+         fclose(psFile);
+         ASSURE(SymTable_openMapped(acOtherPath) == NULL);
+         psFile = fopen(acOtherPath, "wb");
+         ASSURE(psFile != NULL);
+         pcImage[0] ^= 1;
+         ASSURE(fwrite(pcImage, 1, (size_t)lBytes, psFile) ==
+            (size_t)lBytes);
+         fclose(psFile);
+         ASSURE(SymTable_openMapped(acOtherPath) == NULL);
+         free(pcImage);
+      }
+      else fclose(psFile);
+   }
+
+   remove(acPath);
+   remove(acOtherPath);
+   for (i = 0; i < iBindingCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+   free(aiValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the same hash code for every key pcKey. */
+
+static size_t hashConstant(const char *pcKey)
+{
+   assert(pcKey != NULL);
+
+   return 42;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure frozen oSymTable, whose keys are the decimal forms of
+   the multiples of iStride below iCount, reports one probe per
+   binding and iterates over each of them once. */
+
+static void checkFrozen(SymTable_T oSymTable, int *aiVisits,
+   int iCount, int iStride)
+{
+   struct SymTable_Iter sIter;
+   struct SymTable_Stats sStats;
+   const char *pcKey;
+   void *pvValue;
+   size_t uLength;
+   size_t uSeen = 0;
+
+   assert(oSymTable != NULL);
+
+   checkKeys(oSymTable, aiVisits, iCount, iStride);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(! SymTable_contains(oSymTable, "-1"));
+   ASSURE(SymTable_get(oSymTable, "") == NULL);
+
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      ASSURE(pvValue == &aiVisits[atoi(pcKey)]);
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+      uSeen++;
+   }
+   ASSURE(uSeen == uLength);
+
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBindings == uLength);
+   ASSURE(sStats.uBuckets == uLength);
+   ASSURE(sStats.uUsedBuckets == uLength);
+   ASSURE(sStats.auProbes[0] == uLength);
+   ASSURE(sStats.uMaxChain == (uLength != 0));
+   ASSURE(sStats.uTotalBytes == sStats.uStructBytes +
+      sStats.uTableBytes + sStats.uNodeBytes + sStats.uKeyBytes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_freeze() on tables of up to iBindingCount bindings:
+   full, thinned out by removes, empty, and with a client hash
+   function that sends every key to the same bucket. */
+
+static void testFreeze(int iBindingCount)
+{
+   enum {KEPT_STRIDE = 3, CONSTANT_MAX = 200};
+
+   SymTable_T oSymTable;
+   struct SymTable_Stats sStats;
+   char acKey[16];
+   int *aiVisits;
+   size_t uBytes;
+   int iSuccessful;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_freeze() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiVisits = (int*)malloc(sizeof(int) * (size_t)(iBindingCount + 1));
+   ASSURE(aiVisits != NULL);
+   if (aiVisits == NULL) return;
+
+   /* A full table, frozen twice, must keep every binding, in less
+      memory unless it is small enough to fit in its structure, and
+      still map over them in parallel. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   uBytes = sStats.uTotalBytes;
+   ASSURE(SymTable_freeze(oSymTable));
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, aiVisits, iBindingCount, 1);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(iBindingCount <= INLINE_MAX || sStats.uTotalBytes < uBytes);
+   checkMap(oSymTable, aiVisits, iBindingCount, MAX_THREADS, 1);
+   SymTable_free(oSymTable);
+
+   /* A table that has shrunk, with most of its keys removed. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % KEPT_STRIDE == 0) continue;
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[i]);
+   }
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, aiVisits, iBindingCount, KEPT_STRIDE);
+   SymTable_free(oSymTable);
+
+   /* An empty table. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, aiVisits, 0, 1);
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+   SymTable_free(oSymTable);
+
+   /* A table whose own hash function is useless. */
+   iCount = iBindingCount < CONSTANT_MAX ? iBindingCount : CONSTANT_MAX;
+   oSymTable = SymTable_newWithHash(hashConstant);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, aiVisits, iCount, 1);
+   SymTable_free(oSymTable);
+
+   free(aiVisits);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions of symtablehash.h. argv[1] is the number of
+   bindings in the largest table. Exit with EXIT_FAILURE if argv[1]
+   is missing or not a positive number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount <= 0)
+   {
+      fprintf(stderr, "bindingcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testMapParallel(iBindingCount);
+   testShrink(iBindingCount);
+   testPutMany(iBindingCount);
+   testSaveMapped(iBindingCount);
+   testFreeze(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,219 @@
+/*--------------------------------------------------------------------*/
+/* testskip.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+/* Test what only the skip list implementation of SymTable
+   (symtableskip.c) promises: that SymTable_map and SymTable_iterNext
+   visit the bindings in increasing strcmp order of their keys. */
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* Room for the decimal digits of an int and a trailing '\0'. */
+enum {KEY_LENGTH = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* An Order holds what SymTable_map has seen so far. */
+
+struct Order
+{
+   /* Number of bindings visited, and the key of the last one. */
+   size_t uCount;
+   const char *pcLast;
+
+   /* 1 while every key has followed the one before it. */
+   int iSorted;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the greatest common divisor of positive ints i and j. */
+
+static int gcd(int i, int j)
+{
+   int iRest;
+
+   while (j != 0)
+   {
+      iRest = i % j;
+      i = j;
+      j = iRest;
+   }
+   return i;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record in the Order pvExtra the binding whose key is pcKey. */
+
+static void orderBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Order *psOrder = (struct Order*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psOrder != NULL);
+
+   /* The key of a binding is also its value. */
+   if (strcmp(pcKey, (const char*)pvValue) != 0)
+      psOrder->iSorted = 0;
+   if (psOrder->pcLast != NULL && strcmp(psOrder->pcLast, pcKey) >= 0)
+      psOrder->iSorted = 0;
+   psOrder->pcLast = pcKey;
+   psOrder->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that SymTable_map and an iteration of oSymTable both visit
+   its uCount bindings in increasing order of key. */
+
+static void checkOrder(SymTable_T oSymTable, size_t uCount)
+{
+   struct Order sOrder;
+   struct SymTable_Iter sIter;
+   const char *pcKey;
+   const char *pcLast = NULL;
+   size_t uSeen = 0;
+   int iSorted = 1;
+
+   assert(oSymTable != NULL);
+
+   sOrder.uCount = 0;
+   sOrder.pcLast = NULL;
+   sOrder.iSorted = 1;
+   SymTable_map(oSymTable, orderBinding, &sOrder);
+   ASSURE(sOrder.iSorted);
+   ASSURE(sOrder.uCount == uCount);
+
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, NULL))
+   {
+      if (pcLast != NULL && strcmp(pcLast, pcKey) >= 0) iSorted = 0;
+      pcLast = pcKey;
+      uSeen++;
+   }
+   ASSURE(iSorted);
+   ASSURE(uSeen == uCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount keys into a skip list in scrambled order, then
+   remove every other one and clear it, checking the order of the
+   bindings after each step. */
+
+static void testOrder(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iCount = iBindingCount + 1;
+   int iStep;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of bindings.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)iCount * KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL) return;
+   for (i = 0; i < iCount; i++)
+      sprintf(pcKeys + i * KEY_LENGTH, "%d", i);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+   {
+      free(pcKeys);
+      return;
+   }
+
+   /* Visit the keys with a step that is coprime to iCount, so that
+      each is put once but far from its neighbours in order. */
+   for (iStep = iCount / 2 + 1; gcd(iStep, iCount) != 1; iStep++)
+      ;
+   for (i = 0, j = 0; i < iCount; i++, j = (j + iStep) % iCount)
+      ASSURE(SymTable_put(oSymTable, pcKeys + j * KEY_LENGTH,
+         pcKeys + j * KEY_LENGTH));
+   for (i = 0; i < iCount; i++)
+      ASSURE(SymTable_contains(oSymTable, pcKeys + i * KEY_LENGTH));
+   checkOrder(oSymTable, (size_t)iCount);
+
+   /* Remove the even keys. */
+   for (i = 0; i < iCount; i += 2)
+      ASSURE(SymTable_remove(oSymTable, pcKeys + i * KEY_LENGTH) ==
+         pcKeys + i * KEY_LENGTH);
+   for (i = 0; i < iCount; i++)
+      ASSURE(SymTable_contains(oSymTable, pcKeys + i * KEY_LENGTH) ==
+         (i % 2 == 1));
+   checkOrder(oSymTable, (size_t)(iCount / 2));
+
+   /* Put them back in reverse. */
+   for (i = (iCount - 1) / 2 * 2; i >= 0; i -= 2)
+      ASSURE(SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+         pcKeys + i * KEY_LENGTH));
+   checkOrder(oSymTable, (size_t)iCount);
+
+   SymTable_clear(oSymTable);
+   checkOrder(oSymTable, 0);
+   ASSURE(SymTable_put(oSymTable, "b", "b"));
+   ASSURE(SymTable_put(oSymTable, "a", "a"));
+   ASSURE(SymTable_put(oSymTable, "", ""));
+   checkOrder(oSymTable, 3);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the order of the bindings of a SymTable holding up to argv[1]
+   of them. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount <= 0)
+   {
+      fprintf(stderr, "bindingcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testOrder(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
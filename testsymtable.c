@@ -273,6 +273,86 @@ static void testKeyOwnership(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test a table made by SymTable_newBorrowedKeys(), which keeps the
+   key pointers that it is given. */
+
+static void testBorrowedKeys(void)
+{
+   enum {BORROWED_BINDING_COUNT = 500};
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTable_Iter sIter;
+   struct SymTable_Stats sStats;
+   static char aacKeys[BORROWED_BINDING_COUNT][MAX_KEY_LENGTH];
+   char acCopy[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   int iSuccessful;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newBorrowedKeys() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newBorrowedKeys();
+   ASSURE(oSymTable != NULL);
+
+   /* Bind each key to itself, enough of them to grow the table. */
+   for (i = 0; i < BORROWED_BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BORROWED_BINDING_COUNT);
+
+   /* Keys are still compared by content, so an equal key at another
+      address finds the binding and adds none. */
+   for (i = 0; i < BORROWED_BINDING_COUNT; i++)
+   {
+      strcpy(acCopy, aacKeys[i]);
+      ASSURE(SymTable_get(oSymTable, acCopy) == aacKeys[i]);
+      ASSURE(! SymTable_put(oSymTable, acCopy, acCopy));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BORROWED_BINDING_COUNT);
+
+   /* A traversal hands back the very pointers that were put. */
+   iCount = 0;
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      ASSURE(pcKey == (const char *)pvValue);
+      iCount++;
+   }
+   ASSURE(iCount == BORROWED_BINDING_COUNT);
+
+   /* The table holds no key bytes of its own. */
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBindings == BORROWED_BINDING_COUNT);
+   ASSURE(sStats.uKeyBytes == 0);
+
+   /* Removing, clearing and freeing must leave the keys alone. */
+   for (i = 0; i < BORROWED_BINDING_COUNT; i += 2)
+      ASSURE(SymTable_remove(oSymTable, aacKeys[i]) == aacKeys[i]);
+   for (i = 1; i < BORROWED_BINDING_COUNT; i += 2)
+      ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(strcmp(aacKeys[1], "1") == 0);
+   for (i = 0; i < BORROWED_BINDING_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+      ASSURE(iSuccessful);
+   }
+   SymTable_free(oSymTable);
+   ASSURE(strcmp(aacKeys[BORROWED_BINDING_COUNT - 1], "499") == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the SymTable_remove() function. */
 
 static void testRemove(void)
@@ -749,6 +829,463 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the SymTable_getOrPut() and SymTable_upsert() functions. */
+
+static void testUpsert(void)
+{
+   SymTable_T oSymTable;
+   char acJeter[] = "Jeter";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char *pcValue;
+   void **ppvValue;
+   int iAdded;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getOrPut() and SymTable_upsert()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Test SymTable_getOrPut(). */
+
+   ppvValue = SymTable_getOrPut(oSymTable, acJeter, acShortstop,
+      &iAdded);
+   ASSURE(ppvValue != NULL);
+   ASSURE(iAdded);
+   ASSURE((ppvValue != NULL) && (*ppvValue == acShortstop));
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   ppvValue = SymTable_getOrPut(oSymTable, "Jeter", acCenterField,
+      &iAdded);
+   ASSURE(ppvValue != NULL);
+   ASSURE(! iAdded);
+   ASSURE((ppvValue != NULL) && (*ppvValue == acShortstop));
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   if (ppvValue != NULL)
+      *ppvValue = acFirstBase;
+   pcValue = (char*)SymTable_get(oSymTable, acJeter);
+   ASSURE(pcValue == acFirstBase);
+
+   ppvValue = SymTable_getOrPut(oSymTable, "Mantle", NULL, NULL);
+   ASSURE((ppvValue != NULL) && (*ppvValue == NULL));
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+
+   /* Test SymTable_upsert(). */
+
+   pcValue = (char*)SymTable_upsert(oSymTable, "Gehrig", acFirstBase);
+   ASSURE(pcValue == NULL);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 3);
+
+   pcValue = (char*)SymTable_upsert(oSymTable, "Gehrig", acShortstop);
+   ASSURE(pcValue == acFirstBase);
+
+   pcValue = (char*)SymTable_get(oSymTable, "Gehrig");
+   ASSURE(pcValue == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 3);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Traverse oSymTable, whose keys are the decimal forms of 0 to
+   iCount - 1 bound to the elements of aiVisits, and make sure the
+   traversal hands out every binding exactly once. Look a key up and
+   replace the value just handed out at each step, which a traversal
+   must survive. */
+
+static void checkIter(SymTable_T oSymTable, int *aiVisits, int iCount)
+{
+   struct SymTable_Iter sIter;
+   const char *pcKey;
+   void *pvValue;
+   int iSteps = 0;
+   int i;
+
+   for (i = 0; i < iCount; i++)
+      aiVisits[i] = 0;
+
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      iSteps++;
+      ASSURE(pvValue == &aiVisits[atoi(pcKey)]);
+      (*(int*)pvValue)++;
+      ASSURE(SymTable_contains(oSymTable, "0"));
+      ASSURE(SymTable_replace(oSymTable, pcKey, pvValue) == pvValue);
+   }
+   ASSURE(iSteps == iCount);
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, &pvValue));
+   for (i = 0; i < iCount; i++)
+      ASSURE(aiVisits[i] == 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_iterBegin() and SymTable_iterNext() functions. */
+
+static void testIter(void)
+{
+   enum {ITER_BINDING_COUNT = 2000};
+   enum {ITER_STEP_LIMIT = 600};
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTable_Iter sIter;
+   static int aiVisits[ITER_BINDING_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   int iSuccessful;
+   int iSteps;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_iterBegin() and SymTable_iterNext()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing to hand out, however often asked. */
+   SymTable_iterBegin(oSymTable, &sIter);
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, NULL));
+   ASSURE(! SymTable_iterNext(&sIter, NULL, NULL));
+
+   /* Traverse after every put up to ITER_STEP_LIMIT, which passes
+      through small tables and resizes, and once at the end. */
+   for (i = 0; i < ITER_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+      if (i < ITER_STEP_LIMIT)
+         checkIter(oSymTable, aiVisits, i + 1);
+   }
+   checkIter(oSymTable, aiVisits, ITER_BINDING_COUNT);
+
+   /* Stop at the first match, then resume and count the rest. */
+   iSteps = 0;
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, NULL))
+   {
+      iSteps++;
+      if (strcmp(pcKey, "1000") == 0) break;
+   }
+   ASSURE(iSteps > 0 && iSteps <= ITER_BINDING_COUNT);
+   ASSURE(strcmp(pcKey, "1000") == 0);
+   while (SymTable_iterNext(&sIter, NULL, NULL))
+      iSteps++;
+   ASSURE(iSteps == ITER_BINDING_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure that the statistics in *psStats agree with each other
+   and describe a table of uBindings bindings. */
+
+static void checkStats(const struct SymTable_Stats *psStats,
+   size_t uBindings)
+{
+   size_t uProbed = 0;
+   int i;
+
+   ASSURE(psStats->uBindings == uBindings);
+   ASSURE(psStats->uUsedBuckets <= psStats->uBuckets);
+   ASSURE(psStats->uUsedBuckets <= uBindings);
+   ASSURE(psStats->uMaxChain <= uBindings);
+   ASSURE((uBindings == 0) == (psStats->uMaxChain == 0));
+   ASSURE((uBindings == 0) || (psStats->dMeanChain >= 1.0));
+   ASSURE(psStats->dMeanChain <= (double)psStats->uMaxChain);
+   ASSURE((psStats->uBuckets == 0) ||
+      (psStats->dLoadFactor * (double)psStats->uBuckets >
+         (double)uBindings - 0.5));
+   for (i = 0; i < SYMTABLE_PROBE_MAX; i++)
+      uProbed += psStats->auProbes[i];
+   ASSURE(uProbed == uBindings);
+   ASSURE(psStats->uStructBytes > 0);
+   ASSURE(psStats->uTotalBytes == psStats->uStructBytes +
+      psStats->uTableBytes + psStats->uNodeBytes + psStats->uKeyBytes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_getStats() function. */
+
+static void testStats(void)
+{
+   enum {STATS_BINDING_COUNT = 1000};
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oReserved;
+   struct SymTable_Stats sStats;
+   struct SymTable_Stats sReserved;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uKeyBytes = 0;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getStats() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, 0);
+   ASSURE(sStats.uKeyBytes == 0);
+
+   for (i = 0; i < STATS_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      uKeyBytes += strlen(acKey) + 1;
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+      if (i == 2)
+      {
+         SymTable_getStats(oSymTable, &sStats);
+         checkStats(&sStats, 3);
+      }
+   }
+
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, STATS_BINDING_COUNT);
+   ASSURE(sStats.uKeyBytes >= uKeyBytes);
+
+   /* Once the load is over, the nodes and keys left behind by
+      resizing must have been freed: they take not much more memory
+      than in a table sized for all of the bindings up front. Pooled
+      nodes not yet used may make up the difference. */
+   oReserved = SymTable_newWithCapacity(STATS_BINDING_COUNT);
+   ASSURE(oReserved != NULL);
+   for (i = 0; i < STATS_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oReserved, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oReserved, &sReserved);
+   ASSURE(2 * (sStats.uNodeBytes + sStats.uKeyBytes) <=
+      3 * (sReserved.uNodeBytes + sReserved.uKeyBytes));
+   SymTable_free(oReserved);
+
+   for (i = 0; i < STATS_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      SymTable_remove(oSymTable, acKey);
+   }
+
+   SymTable_getStats(oSymTable, &sStats);
+   checkStats(&sStats, STATS_BINDING_COUNT / 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the keys that are the decimal forms of iFirst to iLast - 1 into
+   oSymTable, each bound to NULL, and make sure that doing
+   so resized oSymTable no more than uMaxResizes times. */
+
+static void putRange(SymTable_T oSymTable, int iFirst, int iLast,
+   size_t uMaxResizes)
+{
+   struct SymTable_Stats sStats;
+   char acKey[16];
+   size_t uResizes;
+   int iSuccessful;
+   int i;
+
+   assert(oSymTable != NULL);
+
+   SymTable_getStats(oSymTable, &sStats);
+   uResizes = sStats.uResizes;
+   for (i = iFirst; i < iLast; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uResizes - uResizes <= uMaxResizes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure oSymTable holds exactly the keys that are the decimal
+   forms of 0 to iCount - 1. */
+
+static void checkRange(SymTable_T oSymTable, int iCount)
+{
+   char acKey[16];
+   int i;
+
+   assert(oSymTable != NULL);
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iCount);
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_newWithCapacity() and SymTable_reserve()
+   functions: a table sized up front must take all of its bindings
+   without resizing, whether it starts empty, small or part full. */
+
+static void testReserve(void)
+{
+   enum {RESERVE_BINDING_COUNT = 5000, SMALL_BINDING_COUNT = 5};
+
+   SymTable_T oSymTable;
+   struct SymTable_Stats sStats;
+   size_t uResizes;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithCapacity() and "
+      "SymTable_reserve() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A table created with room for every binding. */
+   oSymTable = SymTable_newWithCapacity(RESERVE_BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   putRange(oSymTable, 0, RESERVE_BINDING_COUNT, 0);
+   checkRange(oSymTable, RESERVE_BINDING_COUNT);
+   SymTable_free(oSymTable);
+
+   /* Room reserved in a table that already has a few bindings, and
+      then in one that already has many. Reserving no more than a
+      table already has room for must change nothing. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   putRange(oSymTable, 0, SMALL_BINDING_COUNT, (size_t)-1);
+   ASSURE(SymTable_reserve(oSymTable, RESERVE_BINDING_COUNT / 2));
+   checkRange(oSymTable, SMALL_BINDING_COUNT);
+   putRange(oSymTable, SMALL_BINDING_COUNT, RESERVE_BINDING_COUNT / 2,
+      0);
+   ASSURE(SymTable_reserve(oSymTable, RESERVE_BINDING_COUNT));
+   checkRange(oSymTable, RESERVE_BINDING_COUNT / 2);
+   SymTable_getStats(oSymTable, &sStats);
+   uResizes = sStats.uResizes;
+   ASSURE(SymTable_reserve(oSymTable, 0));
+   ASSURE(SymTable_reserve(oSymTable, RESERVE_BINDING_COUNT));
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uResizes == uResizes);
+   putRange(oSymTable, RESERVE_BINDING_COUNT / 2, RESERVE_BINDING_COUNT,
+      0);
+   checkRange(oSymTable, RESERVE_BINDING_COUNT);
+   SymTable_free(oSymTable);
+
+   /* A capacity small enough for any table to start with. */
+   oSymTable = SymTable_newWithCapacity(SMALL_BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   putRange(oSymTable, 0, SMALL_BINDING_COUNT, 0);
+   checkRange(oSymTable, SMALL_BINDING_COUNT);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_clear() function: a cleared table must be empty,
+   and refilling it to its old size must not resize it or take more
+   memory, whether it was cleared when small, in the middle of a
+   resize, or large. */
+
+static void testClear(void)
+{
+   static const int aiCounts[] = {3, 520, 5000};
+   enum {LONG_KEY_LENGTH = 300};
+
+   SymTable_T oSymTable;
+   struct SymTable_Iter sIter;
+   struct SymTable_Stats sBefore;
+   struct SymTable_Stats sCleared;
+   struct SymTable_Stats sAfter;
+   char acLongKey[LONG_KEY_LENGTH + 1];
+   size_t u;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_clear() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   memset(acLongKey, 'x', LONG_KEY_LENGTH);
+   acLongKey[LONG_KEY_LENGTH] = '\0';
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   for (u = 0; u < sizeof(aiCounts) / sizeof(aiCounts[0]); u++)
+   {
+      putRange(oSymTable, 0, aiCounts[u], (size_t)-1);
+      iSuccessful = SymTable_put(oSymTable, acLongKey, NULL);
+      ASSURE(iSuccessful);
+      SymTable_getStats(oSymTable, &sBefore);
+
+      /* A table cleared in the middle of a resize drops the array it
+         was moving away from, and keeps the current one. */
+      SymTable_clear(oSymTable);
+      SymTable_getStats(oSymTable, &sCleared);
+      checkStats(&sCleared, 0);
+      ASSURE(sCleared.uBuckets <= sBefore.uBuckets);
+      ASSURE(! SymTable_contains(oSymTable, "0"));
+      ASSURE(! SymTable_contains(oSymTable, acLongKey));
+      ASSURE(SymTable_remove(oSymTable, "1") == NULL);
+      SymTable_iterBegin(oSymTable, &sIter);
+      ASSURE(! SymTable_iterNext(&sIter, NULL, NULL));
+      SymTable_clear(oSymTable);
+
+      /* Refill it with the same bindings. */
+      putRange(oSymTable, 0, aiCounts[u], 0);
+      iSuccessful = SymTable_put(oSymTable, acLongKey, NULL);
+      ASSURE(iSuccessful);
+      SymTable_getStats(oSymTable, &sAfter);
+      ASSURE(sAfter.uResizes == sBefore.uResizes);
+      ASSURE(sAfter.uBuckets == sCleared.uBuckets);
+      ASSURE(sAfter.uNodeBytes <= sBefore.uNodeBytes);
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)aiCounts[u] + 1);
+      ASSURE(SymTable_contains(oSymTable, acLongKey));
+      ASSURE(SymTable_remove(oSymTable, acLongKey) == NULL);
+      checkRange(oSymTable, aiCounts[u]);
+      SymTable_clear(oSymTable);
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -925,6 +1462,7 @@ int main(int argc, char *argv[])
    testBasics();
    testKeyComparison();
    testKeyOwnership();
+   testBorrowedKeys();
    testRemove();
    testMap();
    testEmptyTable();
@@ -933,6 +1471,11 @@ int main(int argc, char *argv[])
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testUpsert();
+   testIter();
+   testStats();
+   testReserve();
+   testClear();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");
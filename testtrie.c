@@ -0,0 +1,380 @@
+/*--------------------------------------------------------------------*/
+/* testtrie.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that only the radix tree implementation of
+   SymTable provides (symtabletrie.h), and the key order of its
+   traversals. */
+
+#include "symtabletrie.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* Room for a key made by makeKey. */
+enum {KEY_LENGTH = 32};
+
+/*--------------------------------------------------------------------*/
+
+/* A Query says which keys a traversal should visit, and holds what
+   it has seen so far. */
+
+struct Query
+{
+   /* Visit the keys that begin with pcPrefix (if not NULL), are not
+      less than pcLow (if not NULL), and are less than pcHigh (if not
+      NULL). */
+   const char *pcPrefix;
+   const char *pcLow;
+   const char *pcHigh;
+
+   /* Number of bindings visited, and the key of the last one. */
+   size_t uCount;
+   const char *pcLast;
+
+   /* 1 while every key visited was wanted and followed the one
+      before it. */
+   int iGood;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey the key numbered i, which looks like a qualified
+   name, so that many keys share long prefixes. */
+
+static void makeKey(char *pcKey, int i)
+{
+   assert(pcKey != NULL);
+
+   sprintf(pcKey, "pkg%d.mod%d.fn%d", i % 7, i % 61, i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if pcKey is one that the Query psQuery wants, or 0
+   otherwise. */
+
+static int isWanted(const struct Query *psQuery, const char *pcKey)
+{
+   assert(psQuery != NULL);
+   assert(pcKey != NULL);
+
+   if (psQuery->pcPrefix != NULL && strncmp(pcKey, psQuery->pcPrefix,
+      strlen(psQuery->pcPrefix)) != 0)
+      return 0;
+   if (psQuery->pcLow != NULL && strcmp(pcKey, psQuery->pcLow) < 0)
+      return 0;
+   if (psQuery->pcHigh != NULL && strcmp(pcKey, psQuery->pcHigh) >= 0)
+      return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record in the Query pvExtra the binding whose key is pcKey. */
+
+static void visitBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Query *psQuery = (struct Query*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psQuery != NULL);
+
+   /* The key of a binding is also its value. */
+   if (strcmp(pcKey, (const char*)pvValue) != 0)
+      psQuery->iGood = 0;
+   if (! isWanted(psQuery, pcKey))
+      psQuery->iGood = 0;
+   if (psQuery->pcLast != NULL && strcmp(psQuery->pcLast, pcKey) >= 0)
+      psQuery->iGood = 0;
+   psQuery->pcLast = pcKey;
+   psQuery->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count in the Query pvExtra the binding whose key is pcKey if the
+   Query wants it. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Query *psQuery = (struct Query*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psQuery != NULL);
+
+   (void)pvValue;
+   if (isWanted(psQuery, pcKey)) psQuery->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set up *psQuery for the keys that begin with pcPrefix and lie
+   between pcLow and pcHigh. */
+
+static void setQuery(struct Query *psQuery, const char *pcPrefix,
+   const char *pcLow, const char *pcHigh)
+{
+   assert(psQuery != NULL);
+
+   psQuery->pcPrefix = pcPrefix;
+   psQuery->pcLow = pcLow;
+   psQuery->pcHigh = pcHigh;
+   psQuery->uCount = 0;
+   psQuery->pcLast = NULL;
+   psQuery->iGood = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that SymTable_mapPrefix visits, in order, exactly the keys
+   of oSymTable that begin with pcPrefix. */
+
+static void checkPrefix(SymTable_T oSymTable, const char *pcPrefix)
+{
+   struct Query sWanted;
+   struct Query sSeen;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+
+   setQuery(&sWanted, pcPrefix, NULL, NULL);
+   SymTable_map(oSymTable, countBinding, &sWanted);
+   setQuery(&sSeen, pcPrefix, NULL, NULL);
+   SymTable_mapPrefix(oSymTable, pcPrefix, visitBinding, &sSeen);
+   ASSURE(sSeen.iGood);
+   ASSURE(sSeen.uCount == sWanted.uCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that SymTable_mapRange visits, in order, exactly the keys of
+   oSymTable from pcLow up to but not including pcHigh. */
+
+static void checkRange(SymTable_T oSymTable, const char *pcLow,
+   const char *pcHigh)
+{
+   struct Query sWanted;
+   struct Query sSeen;
+
+   assert(oSymTable != NULL);
+
+   setQuery(&sWanted, NULL, pcLow, pcHigh);
+   SymTable_map(oSymTable, countBinding, &sWanted);
+   setQuery(&sSeen, NULL, pcLow, pcHigh);
+   SymTable_mapRange(oSymTable, pcLow, pcHigh, visitBinding, &sSeen);
+   ASSURE(sSeen.iGood);
+   ASSURE(sSeen.uCount == sWanted.uCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that SymTable_map and an iteration of oSymTable both visit
+   its uCount bindings in increasing order of key. */
+
+static void checkOrder(SymTable_T oSymTable, size_t uCount)
+{
+   struct Query sSeen;
+   struct SymTable_Iter sIter;
+   const char *pcKey;
+   const char *pcLast = NULL;
+   size_t uSeen = 0;
+   int iSorted = 1;
+
+   assert(oSymTable != NULL);
+
+   setQuery(&sSeen, NULL, NULL, NULL);
+   SymTable_map(oSymTable, visitBinding, &sSeen);
+   ASSURE(sSeen.iGood);
+   ASSURE(sSeen.uCount == uCount);
+
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, NULL))
+   {
+      if (pcLast != NULL && strcmp(pcLast, pcKey) >= 0) iSorted = 0;
+      pcLast = pcKey;
+      uSeen++;
+   }
+   ASSURE(iSorted);
+   ASSURE(uSeen == uCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run prefix and range queries on oSymTable, whose keys are among
+   the iCount keys in pcKeys, with bounds both inside and outside its
+   set of keys. */
+
+static void checkQueries(SymTable_T oSymTable, const char *pcKeys,
+   int iCount)
+{
+   static const char *apcPrefixes[] = {"", "p", "pkg", "pkg3",
+      "pkg3.", "pkg3.mod1", "pkg3.mod10.", "pkg3.mod10.fn3",
+      "pkg30", "q", "pkg3.mod10.fn3.x"};
+   static const char *apcBounds[] = {"", "a", "pkg", "pkg2.mod",
+      "pkg2.mod9", "pkg5.mod40.fn9", "pkg5.mod40.fn9~", "pkg6.z",
+      "z"};
+   char acKey[KEY_LENGTH];
+   size_t u;
+   size_t v;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(pcKeys != NULL);
+
+   for (u = 0; u < sizeof(apcPrefixes) / sizeof(apcPrefixes[0]); u++)
+      checkPrefix(oSymTable, apcPrefixes[u]);
+   for (u = 0; u < sizeof(apcBounds) / sizeof(apcBounds[0]); u++)
+   {
+      checkRange(oSymTable, apcBounds[u], NULL);
+      checkRange(oSymTable, NULL, apcBounds[u]);
+      for (v = 0; v < sizeof(apcBounds) / sizeof(apcBounds[0]); v++)
+         checkRange(oSymTable, apcBounds[u], apcBounds[v]);
+   }
+   checkRange(oSymTable, NULL, NULL);
+
+   /* Use some of the keys, and keys just past them, as prefixes and
+      bounds too. */
+   for (i = 0; i < iCount; i += iCount / 13 + 1)
+   {
+      checkPrefix(oSymTable, pcKeys + i * KEY_LENGTH);
+      sprintf(acKey, "%s0", pcKeys + i * KEY_LENGTH);
+      checkRange(oSymTable, pcKeys + i * KEY_LENGTH, acKey);
+      checkRange(oSymTable, pcKeys + (iCount - 1 - i) * KEY_LENGTH,
+         pcKeys + i * KEY_LENGTH);
+      checkRange(oSymTable, pcKeys + i * KEY_LENGTH,
+         pcKeys + (iCount - 1 - i) * KEY_LENGTH);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount keys that share long prefixes into a radix tree,
+   then remove and put back some of them, checking its order and its
+   prefix and range queries after each step. */
+
+static void testQueries(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   struct Query sSeen;
+   char *pcKeys;
+   int iCount = iBindingCount + 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapPrefix() and SymTable_mapRange().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)iCount * KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL) return;
+   for (i = 0; i < iCount; i++)
+      makeKey(pcKeys + i * KEY_LENGTH, i);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+   {
+      free(pcKeys);
+      return;
+   }
+
+   /* An empty table has nothing to visit. */
+   setQuery(&sSeen, NULL, NULL, NULL);
+   SymTable_mapPrefix(oSymTable, "", visitBinding, &sSeen);
+   SymTable_mapRange(oSymTable, NULL, NULL, visitBinding, &sSeen);
+   ASSURE(sSeen.uCount == 0);
+
+   for (i = 0; i < iCount; i++)
+      ASSURE(SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+         pcKeys + i * KEY_LENGTH));
+   checkOrder(oSymTable, (size_t)iCount);
+   checkQueries(oSymTable, pcKeys, iCount);
+
+   /* Remove every key but those numbered 3 mod 4. */
+   for (i = 0; i < iCount; i++)
+      if (i % 4 != 3)
+         ASSURE(SymTable_remove(oSymTable, pcKeys + i * KEY_LENGTH) ==
+            pcKeys + i * KEY_LENGTH);
+   for (i = 0; i < iCount; i++)
+      ASSURE(SymTable_contains(oSymTable, pcKeys + i * KEY_LENGTH) ==
+         (i % 4 == 3));
+   checkOrder(oSymTable, (size_t)(iCount / 4));
+   checkQueries(oSymTable, pcKeys, iCount);
+
+   /* Put them back, last first, along with keys that are prefixes
+      of others. */
+   for (i = iCount - 1; i >= 0; i--)
+      if (i % 4 != 3)
+         ASSURE(SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+            pcKeys + i * KEY_LENGTH));
+   ASSURE(SymTable_put(oSymTable, "pkg3", "pkg3"));
+   ASSURE(SymTable_put(oSymTable, "pkg3.mod10.", "pkg3.mod10."));
+   ASSURE(SymTable_put(oSymTable, "", ""));
+   checkOrder(oSymTable, (size_t)iCount + 3);
+   checkQueries(oSymTable, pcKeys, iCount);
+
+   /* Removing a key that other keys extend keeps the others. */
+   ASSURE(SymTable_remove(oSymTable, "pkg3") != NULL);
+   ASSURE(SymTable_remove(oSymTable, "") != NULL);
+   ASSURE(SymTable_contains(oSymTable, "pkg3.mod10."));
+   checkOrder(oSymTable, (size_t)iCount + 1);
+   checkQueries(oSymTable, pcKeys, iCount);
+
+   SymTable_clear(oSymTable);
+   checkOrder(oSymTable, 0);
+   checkQueries(oSymTable, pcKeys, iCount);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions of symtabletrie.h on a SymTable holding up to
+   argv[1] bindings. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount <= 0)
+   {
+      fprintf(stderr, "bindingcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testQueries(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}